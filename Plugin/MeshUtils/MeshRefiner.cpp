@@ -2,6 +2,7 @@
 #include "MeshUtils.h"
 #include "SIMD.h"
 #include "MeshRefiner.h"
+#include "Parallel.h"
 
 namespace mu {
 
@@ -22,10 +23,7 @@ void MeshRefiner::prepare(
 
     counts_tmp.clear();
     offsets.clear();
-    v2f_counts.clear();
-    v2f_offsets.clear();
-    shared_faces.clear();
-    shared_indices.clear();
+    connection.clear();
     face_normals.clear();
     normals_tmp.clear();
     tangents_tmp.clear();
@@ -54,7 +52,8 @@ void MeshRefiner::prepare(
         counts = counts_tmp;
     }
     else {
-        mu::CountIndices(counts, offsets, num_indices, num_indices_tri);
+        offsets.resize(counts.size());
+        mu::CountIndicesParallel(counts, offsets, num_indices, num_indices_tri);
     }
 
 }
@@ -85,55 +84,50 @@ void MeshRefiner::genNormals()
 
 void MeshRefiner::genNormals(float smooth_angle)
 {
-    if (v2f_counts.empty()) { buildConnection(); }
+    buildConnection();
 
     auto& p = npoints;
+    size_t num_points = p.size();
     size_t num_indices = indices.size();
     size_t num_faces = counts.size();
     normals_tmp.resize(num_indices);
 
     // gen face normals
     face_normals.resize(num_faces);
-    face_normals.zeroclear();
-    for (size_t fi = 0; fi < num_faces; ++fi)
-    {
-        int offset = offsets[fi];
-        const int *face = &indices[offset];
-        float3 p0 = p[face[0]];
-        float3 p1 = p[face[1]];
-        float3 p2 = p[face[2]];
-        float3 n = cross(p1 - p0, p2 - p0);
-        face_normals[fi] = n;
-    }
-    Normalize(face_normals.data(), face_normals.size());
-
-    // gen vertex normals
+    ParallelForChunks(num_faces, [&](size_t begin, size_t end) {
+        GenerateFaceNormals(&face_normals[begin], p.data(),
+            &counts[begin], &offsets[begin], indices.data(), end - begin);
+        Normalize(&face_normals[begin], end - begin);
+    });
+
+    // gen vertex normals. walk connections of each vertex so that every corner is written exactly once
+    // and connected faces are summed in order of face index regardless of scheduling.
     const float angle = std::cos(smooth_angle * Deg2Rad) - 0.001f;
-    for (size_t fi = 0; fi < num_faces; ++fi)
-    {
-        int count = counts[fi];
-        int offset = offsets[fi];
-        const int *face = &indices[offset];
-        auto& face_normal = face_normals[fi];
-        for (int ci = 0; ci < count; ++ci) {
-            int vi = face[ci];
-
-            int num_connections = v2f_counts[vi];
-            int *connection = &shared_faces[v2f_offsets[vi]];
-            auto normal = float3::zero();
-            for (int ni = 0; ni < num_connections; ++ni) {
-                auto& connected_normal = face_normals[connection[ni]];
-                float dp = dot(face_normal, connected_normal);
-                if (dp > angle) {
-                    normal += connected_normal;
+    ParallelForChunks(num_points, [&](size_t begin, size_t end) {
+        for (size_t vi = begin; vi < end; ++vi) {
+            int num_connections = connection.v2f_counts[vi];
+            int offset = connection.v2f_offsets[vi];
+            const int *faces = &connection.v2f_faces[offset];
+            const int *corners = &connection.v2f_indices[offset];
+            for (int ci = 0; ci < num_connections; ++ci) {
+                auto& face_normal = face_normals[faces[ci]];
+                auto normal = float3::zero();
+                for (int ni = 0; ni < num_connections; ++ni) {
+                    auto& connected_normal = face_normals[faces[ni]];
+                    float dp = dot(face_normal, connected_normal);
+                    if (dp > angle) {
+                        normal += connected_normal;
+                    }
                 }
+                normals_tmp[corners[ci]] = normal;
             }
-            normals_tmp[offset + ci] = normal;
         }
-    }
+    });
 
     // normalize
-    Normalize(normals_tmp.data(), normals_tmp.size());
+    ParallelForChunks(num_indices, [&](size_t begin, size_t end) {
+        Normalize(&normals_tmp[begin], end - begin);
+    });
 
     normals = normals_tmp;
 }
@@ -272,12 +266,8 @@ bool MeshRefiner::refineDumb()
         });
     }
     else if (triangulate) {
-        if (flattened) {
-            mu::Triangulate(new_indices_triangulated, counts, swap_faces);
-        }
-        else {
-            mu::TriangulateWithIndices(new_indices_triangulated, counts, indices, swap_faces);
-        }
+        mu::TriangulateParallel(new_indices_triangulated, counts,
+            flattened ? IArray<int>() : indices, swap_faces);
         auto split = Split{};
         split.num_faces = (int)counts.size();
         split.num_vertices = (int)points.size();
@@ -526,60 +516,17 @@ void MeshRefiner::swapNewData(
 void MeshRefiner::buildConnection()
 {
     // skip if already built
-    if (v2f_counts.size() == points.size()) { return; }
-
-    size_t num_faces = counts.size();
-    size_t num_indices = indices.size();
-    size_t num_points = points.size();
+    if (connection.v2f_counts.size() == points.size()) { return; }
 
-    v2f_counts.resize(num_points);
-    v2f_offsets.resize(num_points);
-    shared_faces.resize(num_indices);
-    shared_indices.resize(num_indices);
-    memset(v2f_counts.data(), 0, sizeof(int)*num_points);
-
-    {
-        const int *idx = indices.data();
-        for (auto& c : counts) {
-            for (int i = 0; i < c; ++i) {
-                v2f_counts[idx[i]]++;
-            }
-            idx += c;
-        }
-    }
-
-    RawVector<int> v2f_indices;
-    v2f_indices.resize(num_points);
-    memset(v2f_indices.data(), 0, sizeof(int)*num_points);
-
-    {
-        int offset = 0;
-        for (size_t i = 0; i < num_points; ++i) {
-            v2f_offsets[i] = offset;
-            offset += v2f_counts[i];
-        }
-    }
-    {
-        int i = 0;
-        for (int fi = 0; fi < (int)num_faces; ++fi) {
-            int c = counts[fi];
-            for (int ci = 0; ci < c; ++ci) {
-                int vi = indices[i + ci];
-                int ti = v2f_offsets[vi] + v2f_indices[vi]++;
-                shared_faces[ti] = fi;
-                shared_indices[ti] = i + ci;
-            }
-            i += c;
-        }
-    }
+    connection.buildConnection(counts, offsets, indices, points.size());
 }
 
 int MeshRefiner::findOrAddVertexPNTUC(int vi, const float3& p, const float3& n, const float4& t, const float2& u, const float4& c)
 {
-    int offset = v2f_offsets[vi];
-    int count = v2f_counts[vi];
+    int offset = connection.v2f_offsets[vi];
+    int count = connection.v2f_counts[vi];
     for (int ci = 0; ci < count; ++ci) {
-        int& ni = old2new[shared_indices[offset + ci]];
+        int& ni = old2new[connection.v2f_indices[offset + ci]];
         // tangent can be omitted as it is generated by point, normal and uv
         if (ni != -1 && near_equal(new_points[ni], p) && near_equal(new_normals[ni], n) && near_equal(new_uv[ni], u) && near_equal(new_colors[ni], c)) {
             return ni;
@@ -600,10 +547,10 @@ int MeshRefiner::findOrAddVertexPNTUC(int vi, const float3& p, const float3& n,
 
 int MeshRefiner::findOrAddVertexPNTU(int vi, const float3& p, const float3& n, const float4& t, const float2& u)
 {
-    int offset = v2f_offsets[vi];
-    int count = v2f_counts[vi];
+    int offset = connection.v2f_offsets[vi];
+    int count = connection.v2f_counts[vi];
     for (int ci = 0; ci < count; ++ci) {
-        int& ni = old2new[shared_indices[offset + ci]];
+        int& ni = old2new[connection.v2f_indices[offset + ci]];
         if (ni != -1 && near_equal(new_points[ni], p) && near_equal(new_normals[ni], n) && near_equal(new_uv[ni], u)) {
             return ni;
         }
@@ -622,10 +569,10 @@ int MeshRefiner::findOrAddVertexPNTU(int vi, const float3& p, const float3& n, c
 
 int MeshRefiner::findOrAddVertexPNU(int vi, const float3& p, const float3& n, const float2& u)
 {
-    int offset = v2f_offsets[vi];
-    int count = v2f_counts[vi];
+    int offset = connection.v2f_offsets[vi];
+    int count = connection.v2f_counts[vi];
     for (int ci = 0; ci < count; ++ci) {
-        int& ni = old2new[shared_indices[offset + ci]];
+        int& ni = old2new[connection.v2f_indices[offset + ci]];
         if (ni != -1 && near_equal(new_points[ni], p) && near_equal(new_normals[ni], n) && near_equal(new_uv[ni], u)) {
             return ni;
         }
@@ -643,10 +590,10 @@ int MeshRefiner::findOrAddVertexPNU(int vi, const float3& p, const float3& n, co
 
 int MeshRefiner::findOrAddVertexPN(int vi, const float3& p, const float3& n)
 {
-    int offset = v2f_offsets[vi];
-    int count = v2f_counts[vi];
+    int offset = connection.v2f_offsets[vi];
+    int count = connection.v2f_counts[vi];
     for (int ci = 0; ci < count; ++ci) {
-        int& ni = old2new[shared_indices[offset + ci]];
+        int& ni = old2new[connection.v2f_indices[offset + ci]];
         if (ni != -1 && near_equal(new_points[ni], p) && near_equal(new_normals[ni], n)) {
             return ni;
         }
@@ -663,10 +610,10 @@ int MeshRefiner::findOrAddVertexPN(int vi, const float3& p, const float3& n)
 
 int MeshRefiner::findOrAddVertexPU(int vi, const float3& p, const float2& u)
 {
-    int offset = v2f_offsets[vi];
-    int count = v2f_counts[vi];
+    int offset = connection.v2f_offsets[vi];
+    int count = connection.v2f_counts[vi];
     for (int ci = 0; ci < count; ++ci) {
-        int& ni = old2new[shared_indices[offset + ci]];
+        int& ni = old2new[connection.v2f_indices[offset + ci]];
         if (ni != -1 && near_equal(new_points[ni], p) && near_equal(new_uv[ni], u)) {
             return ni;
         }
@@ -40,10 +40,7 @@ struct MeshRefiner
 private:
     RawVector<int> counts_tmp;
     RawVector<int> offsets;
-    RawVector<int> v2f_counts;
-    RawVector<int> v2f_offsets;
-    RawVector<int> shared_faces;
-    RawVector<int> shared_indices;
+    MeshConnectionInfo connection;
     RawVector<float3> face_normals;
     RawVector<float3> normals_tmp;
     RawVector<float4> tangents_tmp;
@@ -0,0 +1,496 @@
+#include "pch.h"
+#include "MeshUtils.h"
+#include "MeshSimplifier.h"
+#include "Parallel.h"
+
+namespace mu {
+
+namespace {
+
+// symmetric 4x4 matrix of plane equations
+struct Quadric
+{
+    double a2, ab, ac, ad, b2, bc, bd, c2, cd, d2;
+
+    void clear()
+    {
+        a2 = ab = ac = ad = b2 = bc = bd = c2 = cd = d2 = 0.0;
+    }
+
+    // plane: dot(n, p) + d = 0. w: weight
+    void addPlane(const float3& n, float d, double w)
+    {
+        double a = n.x, b = n.y, c = n.z, e = d;
+        a2 += w*a*a; ab += w*a*b; ac += w*a*c; ad += w*a*e;
+        b2 += w*b*b; bc += w*b*c; bd += w*b*e;
+        c2 += w*c*c; cd += w*c*e;
+        d2 += w*e*e;
+    }
+
+    Quadric& operator+=(const Quadric& v)
+    {
+        a2 += v.a2; ab += v.ab; ac += v.ac; ad += v.ad;
+        b2 += v.b2; bc += v.bc; bd += v.bd;
+        c2 += v.c2; cd += v.cd;
+        d2 += v.d2;
+        return *this;
+    }
+
+    double error(const float3& p) const
+    {
+        double x = p.x, y = p.y, z = p.z;
+        return
+            a2*x*x + 2.0*ab*x*y + 2.0*ac*x*z + 2.0*ad*x +
+            b2*y*y + 2.0*bc*y*z + 2.0*bd*y +
+            c2*z*z + 2.0*cd*z +
+            d2;
+    }
+};
+
+template<int N>
+static float FindWeight(const Weights<N>& w, int bone)
+{
+    for (int i = 0; i < N; ++i) {
+        if (w.weights[i] != 0.0f && w.indices[i] == bone) { return w.weights[i]; }
+    }
+    return 0.0f;
+}
+
+// sum of differences of weights of each bone.
+// zero weights are ignored, so unused slots (e.g. Weights8 with 4 or less influences) don't matter.
+template<int N>
+static float WeightsDifference(const Weights<N>& w0, const Weights<N>& w1)
+{
+    float diff = 0.0f;
+    for (int i = 0; i < N; ++i) {
+        if (w0.weights[i] == 0.0f) { continue; }
+        diff += std::abs(w0.weights[i] - FindWeight(w1, w0.indices[i]));
+    }
+    for (int j = 0; j < N; ++j) {
+        if (w1.weights[j] == 0.0f) { continue; }
+        if (FindWeight(w0, w1.indices[j]) == 0.0f) { diff += std::abs(w1.weights[j]); }
+    }
+    return diff;
+}
+
+struct Collapse
+{
+    float cost;
+    int from, to;
+
+    // for min-heap by std::priority_queue
+    bool operator<(const Collapse& v) const { return cost > v.cost; }
+};
+
+class SimplifierImpl
+{
+public:
+    SimplifierImpl(const MeshSimplifier& s) : m_s(s) {}
+    bool run(std::vector<MeshLOD>& dst, int num_lods, float ratio);
+
+private:
+    void setup();
+    bool evaluate(int from, int to, float& cost) const;
+    void collapse(int from, int to);
+    void pushCollapses(int vi);
+    void snapshot(MeshLOD& dst);
+
+    bool alive(int fi) const { return m_face_alive[fi] != 0; }
+    bool contains(int fi, int vi) const
+    {
+        const int *f = &m_faces[fi * 3];
+        return f[0] == vi || f[1] == vi || f[2] == vi;
+    }
+
+    const MeshSimplifier& m_s;
+    int m_num_points = 0;
+    int m_num_faces = 0;
+    int m_num_alive_faces = 0;
+    int m_num_channels = 0;
+
+    RawVector<float3> m_points; // normalized
+    RawVector<float> m_attributes; // m_num_channels per vertex. scaled by sqrt of weights
+    RawVector<int> m_faces;
+    RawVector<char> m_face_alive;
+    RawVector<float> m_face_areas;
+    RawVector<float4> m_face_fields; // m_num_channels per face. xyz: gradient, w: offset
+    RawVector<Quadric> m_face_quadrics;
+    RawVector<Quadric> m_quadrics;
+    RawVector<char> m_vertex_alive;
+    RawVector<char> m_boundary;
+    std::vector<std::vector<int>> m_vertex_faces;
+    std::priority_queue<Collapse> m_queue;
+    RawVector<int> m_neighbors;
+};
+
+
+void SimplifierImpl::setup()
+{
+    const auto& s = m_s;
+    m_num_points = (int)s.points.size();
+    m_num_faces = (int)s.indices.size() / 3;
+    m_faces.assign(s.indices.data(), s.indices.data() + m_num_faces * 3);
+    m_face_alive.resize(m_num_faces);
+    m_face_alive.zeroclear();
+    m_vertex_alive.resize(m_num_points);
+    m_vertex_alive.zeroclear();
+
+    // normalize positions so that errors don't depend on scale of the mesh
+    float3 bmin, bmax;
+    MinMax(s.points.data(), s.points.size(), bmin, bmax);
+    float3 size = bmax - bmin;
+    float extent = std::max(std::max(size.x, size.y), size.z);
+    float rcp = extent > 0.0f ? 1.0f / extent : 1.0f;
+    m_points.resize(m_num_points);
+    ParallelForChunks(m_num_points, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            m_points[i] = (s.points[i] - bmin) * rcp;
+        }
+    });
+
+    // attribute channels
+    bool has_normals = s.normals.size() == s.points.size() && s.normal_weight > 0.0f;
+    bool has_uv = s.uv.size() == s.points.size() && s.uv_weight > 0.0f;
+    m_num_channels = (has_normals ? 3 : 0) + (has_uv ? 2 : 0);
+    m_attributes.resize(m_num_points * m_num_channels);
+    if (m_num_channels > 0) {
+        float nw = std::sqrt(s.normal_weight);
+        float uw = std::sqrt(s.uv_weight);
+        ParallelForChunks(m_num_points, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                float *a = &m_attributes[i * m_num_channels];
+                if (has_normals) {
+                    auto n = s.normals[i] * nw;
+                    *a++ = n.x; *a++ = n.y; *a++ = n.z;
+                }
+                if (has_uv) {
+                    auto t = s.uv[i] * uw;
+                    *a++ = t.x; *a++ = t.y;
+                }
+            }
+        });
+    }
+
+    // face quadrics and linear fields of attributes
+    m_face_areas.resize(m_num_faces);
+    m_face_quadrics.resize(m_num_faces);
+    m_face_fields.resize(m_num_faces * m_num_channels);
+    ParallelForChunks(m_num_faces, [&](size_t begin, size_t end) {
+        for (size_t fi = begin; fi < end; ++fi) {
+            const int *f = &m_faces[fi * 3];
+            bool valid = f[0] >= 0 && f[0] < m_num_points && f[1] >= 0 && f[1] < m_num_points && f[2] >= 0 && f[2] < m_num_points &&
+                f[0] != f[1] && f[1] != f[2] && f[2] != f[0];
+            m_face_quadrics[fi].clear();
+            m_face_areas[fi] = 0.0f;
+            for (int ci = 0; ci < m_num_channels; ++ci) {
+                m_face_fields[fi * m_num_channels + ci] = { 0.0f, 0.0f, 0.0f, 0.0f };
+            }
+            if (!valid) { continue; }
+            m_face_alive[fi] = 1;
+
+            const auto& p0 = m_points[f[0]];
+            auto e1 = m_points[f[1]] - p0;
+            auto e2 = m_points[f[2]] - p0;
+            auto n = cross(e1, e2);
+            float len = std::sqrt(dot(n, n));
+            if (len == 0.0f) { continue; }
+            n /= len;
+            float area = len * 0.5f;
+            m_face_areas[fi] = area;
+            m_face_quadrics[fi].addPlane(n, -dot(n, p0), area);
+
+            // gradient of each channel in the plane of the face
+            float d11 = dot(e1, e1), d12 = dot(e1, e2), d22 = dot(e2, e2);
+            float det = d11 * d22 - d12 * d12;
+            if (det == 0.0f) { continue; }
+            float rdet = 1.0f / det;
+            const float *a0 = &m_attributes[f[0] * m_num_channels];
+            const float *a1 = &m_attributes[f[1] * m_num_channels];
+            const float *a2 = &m_attributes[f[2] * m_num_channels];
+            for (int ci = 0; ci < m_num_channels; ++ci) {
+                float v1 = a1[ci] - a0[ci];
+                float v2 = a2[ci] - a0[ci];
+                float s1 = (d22 * v1 - d12 * v2) * rdet;
+                float s2 = (d11 * v2 - d12 * v1) * rdet;
+                auto g = e1 * s1 + e2 * s2;
+                m_face_fields[fi * m_num_channels + ci] = { g.x, g.y, g.z, a0[ci] - dot(g, p0) };
+            }
+        }
+    });
+
+    // vertex -> faces
+    RawVector<int> counts, offsets;
+    counts.resize(m_num_faces);
+    offsets.resize(m_num_faces);
+    m_num_alive_faces = 0;
+    for (int fi = 0; fi < m_num_faces; ++fi) {
+        counts[fi] = alive(fi) ? 3 : 0; // skip invalid faces
+        offsets[fi] = fi * 3;
+        m_num_alive_faces += alive(fi) ? 1 : 0;
+    }
+    MeshConnectionInfo connection;
+    connection.buildConnection(counts, offsets, m_faces, m_num_points);
+
+    // vertex quadrics. boundary edges add planes perpendicular to the face to keep the boundary.
+    m_quadrics.resize(m_num_points);
+    m_boundary.resize(m_num_points);
+    m_vertex_faces.resize(m_num_points);
+    ParallelForChunks(m_num_points, [&](size_t begin, size_t end) {
+        for (size_t vi = begin; vi < end; ++vi) {
+            auto& q = m_quadrics[vi];
+            auto& vfaces = m_vertex_faces[vi];
+            q.clear();
+            vfaces.clear();
+            m_boundary[vi] = 0;
+
+            int count = connection.v2f_counts[vi];
+            int offset = connection.v2f_offsets[vi];
+            const int *v2f = &connection.v2f_faces[offset];
+            for (int i = 0; i < count; ++i) {
+                int fi = v2f[i];
+                if (!alive(fi)) { continue; }
+                vfaces.push_back(fi);
+                q += m_face_quadrics[fi];
+            }
+            if (!vfaces.empty()) {
+                m_vertex_alive[vi] = 1;
+            }
+
+            for (int fi : vfaces) {
+                const int *f = &m_faces[fi * 3];
+                int ci = f[0] == (int)vi ? 0 : (f[1] == (int)vi ? 1 : 2);
+                // both edges of the face that share this vertex
+                for (int ei = 0; ei < 2; ++ei) {
+                    int ui = ei == 0 ? f[(ci + 1) % 3] : f[(ci + 2) % 3];
+                    int shared = 0;
+                    for (int fj : vfaces) {
+                        if (contains(fj, ui)) { ++shared; }
+                    }
+                    if (shared != 1) { continue; }
+
+                    m_boundary[vi] = 1;
+                    auto fn = cross(m_points[f[1]] - m_points[f[0]], m_points[f[2]] - m_points[f[0]]);
+                    auto e = m_points[ui] - m_points[vi];
+                    auto n = cross(e, fn);
+                    float len2 = dot(n, n);
+                    if (len2 == 0.0f) { continue; }
+                    n /= std::sqrt(len2);
+                    q.addPlane(n, -dot(n, m_points[vi]), m_s.boundary_weight * dot(e, e));
+                }
+            }
+        }
+    });
+
+    // initial collapses. evaluated in parallel and gathered in order of chunks to be deterministic.
+    size_t chunk_size = muParallelChunkSize / 8;
+    std::vector<std::vector<Collapse>> chunks(ceildiv((size_t)m_num_points, chunk_size));
+    ParallelForChunks(m_num_points, chunk_size, [&](size_t begin, size_t end) {
+        auto& collapses = chunks[begin / chunk_size];
+        std::vector<int> neighbors;
+        for (size_t vi = begin; vi < end; ++vi) {
+            neighbors.clear();
+            for (int fi : m_vertex_faces[vi]) {
+                const int *f = &m_faces[fi * 3];
+                for (int i = 0; i < 3; ++i) {
+                    if (f[i] != (int)vi) { neighbors.push_back(f[i]); }
+                }
+            }
+            std::sort(neighbors.begin(), neighbors.end());
+            neighbors.erase(std::unique(neighbors.begin(), neighbors.end()), neighbors.end());
+            for (int ui : neighbors) {
+                float cost;
+                if (evaluate((int)vi, ui, cost)) {
+                    collapses.push_back({ cost, (int)vi, ui });
+                }
+            }
+        }
+    });
+
+    std::vector<Collapse> collapses;
+    for (auto& c : chunks) {
+        collapses.insert(collapses.end(), c.begin(), c.end());
+    }
+    m_queue = std::priority_queue<Collapse>(std::less<Collapse>(), std::move(collapses));
+}
+
+bool SimplifierImpl::evaluate(int from, int to, float& cost) const
+{
+    const auto& pt = m_points[to];
+    int shared = 0;
+    double attr_error = 0.0;
+    const float *attr = &m_attributes[to * m_num_channels];
+    for (int fi : m_vertex_faces[from]) {
+        if (!alive(fi)) { continue; }
+        if (contains(fi, to)) {
+            ++shared;
+            continue;
+        }
+
+        // reject collapses that flip or degenerate faces
+        const int *f = &m_faces[fi * 3];
+        float3 p[3] = { m_points[f[0]], m_points[f[1]], m_points[f[2]] };
+        auto n0 = cross(p[1] - p[0], p[2] - p[0]);
+        for (int i = 0; i < 3; ++i) {
+            if (f[i] == from) { p[i] = pt; }
+        }
+        auto n1 = cross(p[1] - p[0], p[2] - p[0]);
+        float l0 = dot(n0, n0), l1 = dot(n1, n1);
+        if (l1 == 0.0f || dot(n0, n1) < m_s.flip_threshold * std::sqrt(l0 * l1)) {
+            return false;
+        }
+
+        // this face's corner at 'from' takes attributes of 'to'. compare them with the field of the original face.
+        const float4 *fields = &m_face_fields[fi * m_num_channels];
+        for (int ci = 0; ci < m_num_channels; ++ci) {
+            const auto& g = fields[ci];
+            float d = g.x * pt.x + g.y * pt.y + g.z * pt.z + g.w - attr[ci];
+            attr_error += m_face_areas[fi] * d * d;
+        }
+    }
+    if (shared == 0) {
+        // not connected anymore
+        return false;
+    }
+    if (m_boundary[from] && (shared != 1 || !m_boundary[to])) {
+        // boundary vertices can move only along boundary edges
+        return false;
+    }
+
+    Quadric q = m_quadrics[from];
+    q += m_quadrics[to];
+    double error = std::max(q.error(pt), 0.0) + attr_error;
+
+    if ((!m_s.weights4.empty() || !m_s.weights8.empty()) && m_s.bone_weight > 0.0f) {
+        float diff = !m_s.weights8.empty() ?
+            WeightsDifference(m_s.weights8[from], m_s.weights8[to]) :
+            WeightsDifference(m_s.weights4[from], m_s.weights4[to]);
+        double area = 0.0;
+        for (int fi : m_vertex_faces[from]) {
+            if (alive(fi)) { area += m_face_areas[fi]; }
+        }
+        error += m_s.bone_weight * area * diff * diff;
+    }
+
+    cost = (float)error;
+    return true;
+}
+
+void SimplifierImpl::collapse(int from, int to)
+{
+    auto& dst_faces = m_vertex_faces[to];
+    for (int fi : m_vertex_faces[from]) {
+        if (!alive(fi)) { continue; }
+        if (contains(fi, to)) {
+            m_face_alive[fi] = 0;
+            --m_num_alive_faces;
+        }
+        else {
+            int *f = &m_faces[fi * 3];
+            for (int i = 0; i < 3; ++i) {
+                if (f[i] == from) { f[i] = to; }
+            }
+            dst_faces.push_back(fi);
+        }
+    }
+    dst_faces.erase(std::remove_if(dst_faces.begin(), dst_faces.end(), [&](int fi) { return !alive(fi); }), dst_faces.end());
+    m_vertex_faces[from].clear();
+    m_vertex_alive[from] = 0;
+    m_quadrics[to] += m_quadrics[from];
+}
+
+void SimplifierImpl::pushCollapses(int vi)
+{
+    m_neighbors.clear();
+    for (int fi : m_vertex_faces[vi]) {
+        const int *f = &m_faces[fi * 3];
+        for (int i = 0; i < 3; ++i) {
+            if (f[i] != vi) { m_neighbors.push_back(f[i]); }
+        }
+    }
+    std::sort(m_neighbors.begin(), m_neighbors.end());
+    auto end = std::unique(m_neighbors.begin(), m_neighbors.end());
+    for (auto it = m_neighbors.begin(); it != end; ++it) {
+        int ui = *it;
+        float cost;
+        if (evaluate(vi, ui, cost)) { m_queue.push({ cost, vi, ui }); }
+        if (evaluate(ui, vi, cost)) { m_queue.push({ cost, ui, vi }); }
+    }
+}
+
+void SimplifierImpl::snapshot(MeshLOD& dst)
+{
+    RawVector<int> old2new;
+    old2new.resize(m_num_points);
+    for (auto& v : old2new) { v = -1; }
+
+    dst.vertices.clear();
+    dst.indices.clear();
+    dst.indices.reserve(m_num_alive_faces * 3);
+    for (int fi = 0; fi < m_num_faces; ++fi) {
+        if (!alive(fi)) { continue; }
+        const int *f = &m_faces[fi * 3];
+        for (int i = 0; i < 3; ++i) {
+            int& ni = old2new[f[i]];
+            if (ni == -1) {
+                ni = (int)dst.vertices.size();
+                dst.vertices.push_back(f[i]);
+            }
+            dst.indices.push_back(ni);
+        }
+    }
+}
+
+bool SimplifierImpl::run(std::vector<MeshLOD>& dst, int num_lods, float ratio)
+{
+    setup();
+
+    dst.resize(num_lods);
+    double target = m_num_faces;
+    for (int li = 0; li < num_lods; ++li) {
+        target *= ratio;
+        while (m_num_alive_faces > (int)target && !m_queue.empty()) {
+            auto c = m_queue.top();
+            m_queue.pop();
+            if (!m_vertex_alive[c.from] || !m_vertex_alive[c.to]) { continue; }
+
+            // neighborhood may have changed since this was pushed. re-evaluate and postpone if it got worse.
+            float cost;
+            if (!evaluate(c.from, c.to, cost)) { continue; }
+            if (cost > c.cost * 1.0001f + 1e-20f) {
+                m_queue.push({ cost, c.from, c.to });
+                continue;
+            }
+            collapse(c.from, c.to);
+            pushCollapses(c.to);
+        }
+        snapshot(dst[li]);
+    }
+    return true;
+}
+
+} // namespace
+
+
+void MeshSimplifier::prepare(const IArray<int>& indices_, const IArray<float3>& points_)
+{
+    indices = indices_;
+    points = points_;
+    normals.reset(nullptr, 0);
+    uv.reset(nullptr, 0);
+    weights4.reset(nullptr, 0);
+    weights8.reset(nullptr, 0);
+}
+
+bool MeshSimplifier::simplify(std::vector<MeshLOD>& dst, int num_lods, float ratio)
+{
+    dst.clear();
+    if (num_lods <= 0 || points.empty() || indices.size() < 3 || indices.size() % 3 != 0) { return false; }
+    if (ratio <= 0.0f || ratio >= 1.0f) { return false; }
+    if (!weights4.empty() && weights4.size() != points.size()) { return false; }
+    if (!weights8.empty() && weights8.size() != points.size()) { return false; }
+
+    SimplifierImpl impl(*this);
+    return impl.run(dst, num_lods, ratio);
+}
+
+} // namespace mu
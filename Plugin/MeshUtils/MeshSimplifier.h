@@ -0,0 +1,47 @@
+#pragma once
+
+namespace mu {
+
+// a level of detail made by MeshSimplifier.
+// vertices are a subset of the source mesh's, so a LOD made from one sample can be applied to other samples of
+// the same topology (e.g. animated points) by gathering their attributes with vertices.
+struct MeshLOD
+{
+    RawVector<int> vertices;    // new -> old vertex index
+    RawVector<int> indices;     // triangles that refer vertices
+};
+
+// quadric error metric simplifier.
+// edges are collapsed into one of their end points (half-edge collapse), so remaining vertices keep their
+// attributes as they are and nothing needs to be interpolated.
+// errors of normals and uv are measured against linear fields of original faces (so linear attributes cost nothing),
+// and difference of bone weights is added as penalty.
+struct MeshSimplifier
+{
+    // inputs. attributes are optional and must be per-vertex.
+    IArray<float3> points;
+    IArray<float3> normals;
+    IArray<float2> uv;
+    IArray<Weights4> weights4;
+    IArray<Weights8> weights8; // used instead of weights4 if given
+    IArray<int> indices; // triangulated
+
+    // errors of attributes are scaled by these and added to the geometric error.
+    // positions are normalized by size of bounds, so these don't depend on scale of the mesh.
+    float normal_weight = 0.5f;
+    float uv_weight = 1.0f;
+    float bone_weight = 1.0f;
+    // scale of quadrics of planes that are perpendicular to boundary edges
+    float boundary_weight = 10.0f;
+    // collapses that make any face normal turn more than this (cosine) are rejected
+    float flip_threshold = 0.2f;
+
+    void prepare(const IArray<int>& indices, const IArray<float3>& points);
+
+    // make num_lods levels. nth level (1 origin) has about (number of triangles) * ratio^n triangles.
+    // a level may have more triangles than that if no more edges can be collapsed.
+    // quadrics and initial costs are computed in parallel. collapses are done sequentially.
+    bool simplify(std::vector<MeshLOD>& dst, int num_lods, float ratio);
+};
+
+} // namespace mu
@@ -4,6 +4,7 @@
 #include "RawVector.h"
 #include "IntrusiveArray.h"
 #include "SIMD.h"
+#include "Parallel.h"
 
 #ifdef muEnableHalf
 #ifdef _WIN32
@@ -69,6 +70,122 @@ bool GenerateNormals(
     return true;
 }
 
+
+void MeshConnectionInfo::clear()
+{
+    v2f_counts.clear();
+    v2f_offsets.clear();
+    v2f_faces.clear();
+    v2f_indices.clear();
+}
+
+void MeshConnectionInfo::buildConnection(
+    const IArray<int>& counts, const IArray<int>& offsets, const IArray<int>& indices, size_t num_points)
+{
+    size_t num_faces = counts.size();
+    size_t num_indices = indices.size();
+
+    v2f_counts.resize(num_points);
+    v2f_offsets.resize(num_points);
+    v2f_faces.resize(num_indices);
+    v2f_indices.resize(num_indices);
+    v2f_counts.zeroclear();
+
+    static_assert(sizeof(std::atomic_int) == sizeof(int), "");
+    auto *acounts = (std::atomic_int*)v2f_counts.data();
+    ParallelForChunks(num_faces, [&](size_t begin, size_t end) {
+        for (size_t fi = begin; fi < end; ++fi) {
+            int count = counts[fi];
+            const int *face = &indices[offsets[fi]];
+            for (int ci = 0; ci < count; ++ci) {
+                acounts[face[ci]].fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+    });
+
+    ParallelPrefixSum(v2f_offsets.data(), v2f_counts.data(), num_points);
+
+    RawVector<int> pos;
+    pos.assign(v2f_offsets.begin(), v2f_offsets.end());
+    auto *apos = (std::atomic_int*)pos.data();
+    ParallelForChunks(num_faces, [&](size_t begin, size_t end) {
+        for (size_t fi = begin; fi < end; ++fi) {
+            int count = counts[fi];
+            int face_offset = offsets[fi];
+            for (int ci = 0; ci < count; ++ci) {
+                int ii = face_offset + ci;
+                int ti = apos[indices[ii]].fetch_add(1, std::memory_order_relaxed);
+                v2f_faces[ti] = (int)fi;
+                v2f_indices[ti] = ii;
+            }
+        }
+    });
+
+    // slots are taken in arbitrary order when run in parallel. sort connections of each vertex by face index
+    // so that results don't depend on scheduling. lists are short, so insertion sort is enough.
+    ParallelForChunks(num_points, [&](size_t begin, size_t end) {
+        for (size_t vi = begin; vi < end; ++vi) {
+            int *faces = &v2f_faces[v2f_offsets[vi]];
+            int *idx = &v2f_indices[v2f_offsets[vi]];
+            int n = v2f_counts[vi];
+            for (int i = 1; i < n; ++i) {
+                int f = faces[i], ii = idx[i];
+                int j = i;
+                for (; j > 0 && (faces[j - 1] > f || (faces[j - 1] == f && idx[j - 1] > ii)); --j) {
+                    faces[j] = faces[j - 1];
+                    idx[j] = idx[j - 1];
+                }
+                faces[j] = f;
+                idx[j] = ii;
+            }
+        }
+    });
+}
+
+static void BuildConnectionIfNeeded(MeshConnectionInfo& connection,
+    const IArray<int>& counts, const IArray<int>& offsets, const IArray<int>& indices, size_t num_points)
+{
+    if (connection.v2f_counts.size() != num_points || connection.v2f_faces.size() != indices.size()) {
+        connection.buildConnection(counts, offsets, indices, num_points);
+    }
+}
+
+bool GenerateNormalsParallel(
+    IArray<float3> dst, const IArray<float3> points,
+    const IArray<int> counts, const IArray<int> offsets, const IArray<int> indices,
+    MeshConnectionInfo& connection)
+{
+    if (dst.size() != points.size() || offsets.size() != counts.size()) {
+        return false;
+    }
+
+    size_t num_points = points.size();
+    size_t num_faces = counts.size();
+    BuildConnectionIfNeeded(connection, counts, offsets, indices, num_points);
+
+    RawVector<float3> face_normals;
+    face_normals.resize(num_faces);
+    ParallelForChunks(num_faces, [&](size_t begin, size_t end) {
+        GenerateFaceNormals(&face_normals[begin], points.data(),
+            &counts[begin], &offsets[begin], indices.data(), end - begin);
+    });
+
+    // gather. each vertex sums connected face normals in order of face index, same as GenerateNormals().
+    ParallelForChunks(num_points, [&](size_t begin, size_t end) {
+        for (size_t vi = begin; vi < end; ++vi) {
+            int num_connections = connection.v2f_counts[vi];
+            const int *faces = &connection.v2f_faces[connection.v2f_offsets[vi]];
+            auto n = float3::zero();
+            for (int ci = 0; ci < num_connections; ++ci) {
+                n += face_normals[faces[ci]];
+            }
+            dst[vi] = n;
+        }
+        Normalize(&dst[begin], end - begin);
+    });
+    return true;
+}
+
 struct TSpaceContext
 {
     IArray<float4> dst;
@@ -78,6 +195,11 @@ struct TSpaceContext
     const IArray<int> counts;
     const IArray<int> offsets;
     const IArray<int> indices;
+    // if not null, only tangents of vertices whose mask value is mask_value are written
+    const char *mask;
+    char mask_value;
+
+    bool isMasked(int vi) const { return mask && mask[vi] != mask_value; }
 
     static int getNumFaces(const SMikkTSpaceContext *tctx)
     {
@@ -135,6 +257,7 @@ struct TSpaceContext
     {
         auto *_this = reinterpret_cast<TSpaceContext*>(tctx->m_pUserData);
         const int *face = &_this->indices[_this->offsets[iface]];
+        if (_this->isMasked(face[ivtx])) { return; }
         float sign = (IsOrientationPreserving != 0) ? 1.0f : -1.0f;
         _this->dst[face[ivtx]] = { tangent[0], tangent[1], tangent[2], sign };
     }
@@ -143,16 +266,20 @@ struct TSpaceContext
         float /*fMagS*/, float /*fMagT*/, tbool IsOrientationPreserving, int iface, int ivtx)
     {
         auto *_this = reinterpret_cast<TSpaceContext*>(tctx->m_pUserData);
+        int ci = _this->offsets[iface] + ivtx;
+        if (_this->isMasked(_this->indices[ci])) { return; }
         float sign = (IsOrientationPreserving != 0) ? 1.0f : -1.0f;
-        _this->dst[_this->offsets[iface] + ivtx] = { tangent[0], tangent[1], tangent[2], sign };
+        _this->dst[ci] = { tangent[0], tangent[1], tangent[2], sign };
     }
 };
 
-bool GenerateTangents(
-    IArray<float4> dst, const IArray<float3> points, const IArray<float3> normals, const IArray<float2> uv,
-    const IArray<int> counts, const IArray<int> offsets, const IArray<int> indices)
+static bool GenerateTangentsMikkTSpace(TSpaceContext& ctx)
 {
-    TSpaceContext ctx = {dst, points, normals, uv, counts, offsets, indices};
+    auto& points = ctx.points;
+    auto& normals = ctx.normals;
+    auto& uv = ctx.uv;
+    auto& indices = ctx.indices;
+    auto& dst = ctx.dst;
 
     SMikkTSpaceInterface iface;
     memset(&iface, 0, sizeof(iface));
@@ -171,64 +298,501 @@ bool GenerateTangents(
     return genTangSpaceDefault(&tctx) != 0;
 }
 
+bool GenerateTangents(
+    IArray<float4> dst, const IArray<float3> points, const IArray<float3> normals, const IArray<float2> uv,
+    const IArray<int> counts, const IArray<int> offsets, const IArray<int> indices)
+{
+    TSpaceContext ctx = {dst, points, normals, uv, counts, offsets, indices, nullptr, 0};
+    return GenerateTangentsMikkTSpace(ctx);
+}
 
+#define muTangentChunkSize 0x2000
+
+bool GenerateTangentsParallel(
+    IArray<float4> dst, const IArray<float3> points, const IArray<float3> normals, const IArray<float2> uv,
+    const IArray<int> counts, const IArray<int> offsets, const IArray<int> indices,
+    MeshConnectionInfo& connection)
+{
+    size_t num_faces = counts.size();
+    size_t num_indices = indices.size();
+    // vertex indices are needed to find vertices shared between chunks
+    size_t num_points = dst.size() != num_indices ? dst.size() : points.size() != num_indices ? points.size() : 0;
+    if (num_faces <= muTangentChunkSize || offsets.size() != num_faces || num_points == 0) {
+        return GenerateTangents(dst, points, normals, uv, counts, offsets, indices);
+    }
+
+    // MikkTSpace computes tangents of a vertex from the faces around it. tangents of vertices shared by faces
+    // of different chunks are incomplete in each chunk, so they are skipped and recomputed later.
+    BuildConnectionIfNeeded(connection, counts, offsets, indices, num_points);
+    RawVector<char> shared;
+    shared.resize(num_points);
+    ParallelForChunks(num_points, [&](size_t begin, size_t end) {
+        for (size_t vi = begin; vi < end; ++vi) {
+            int num_connections = connection.v2f_counts[vi];
+            const int *faces = &connection.v2f_faces[connection.v2f_offsets[vi]];
+            char s = 0;
+            for (int ci = 1; ci < num_connections; ++ci) {
+                if (faces[ci] / muTangentChunkSize != faces[0] / muTangentChunkSize) { s = 1; break; }
+            }
+            shared[vi] = s;
+        }
+    });
+
+    std::atomic_bool ok = { true };
+    ParallelForChunks(num_faces, muTangentChunkSize, [&](size_t begin, size_t end) {
+        size_t n = end - begin;
+        TSpaceContext ctx = { dst, points, normals, uv,
+            IArray<int>(&counts[begin], n), IArray<int>(&offsets[begin], n), indices, shared.data(), 0 };
+        if (!GenerateTangentsMikkTSpace(ctx)) { ok = false; }
+    });
+    if (!ok) { return false; }
+
+    // all faces around shared vertices in original order, processed at once.
+    // the last corner of each vertex wins as in GenerateTangents().
+    RawVector<int> scounts, soffsets;
+    for (size_t fi = 0; fi < num_faces; ++fi) {
+        int count = counts[fi];
+        const int *face = &indices[offsets[fi]];
+        for (int ci = 0; ci < count; ++ci) {
+            if (shared[face[ci]]) {
+                scounts.push_back(count);
+                soffsets.push_back(offsets[fi]);
+                break;
+            }
+        }
+    }
+    if (!scounts.empty()) {
+        TSpaceContext ctx = { dst, points, normals, uv, scounts, soffsets, indices, shared.data(), 1 };
+        if (!GenerateTangentsMikkTSpace(ctx)) { return false; }
+    }
+    return true;
+}
+
+bool GenerateTangentsFast(
+    IArray<float4> dst, const IArray<float3> points, const IArray<float3> normals, const IArray<float2> uv,
+    const IArray<int> counts, const IArray<int> offsets, const IArray<int> indices,
+    MeshConnectionInfo& connection)
+{
+    size_t num_points = points.size();
+    size_t num_faces = counts.size();
+    size_t num_indices = indices.size();
+    if (dst.size() != num_points || offsets.size() != num_faces ||
+        (normals.size() != num_points && normals.size() != num_indices) ||
+        (uv.size() != num_points && uv.size() != num_indices))
+    {
+        return false;
+    }
+    BuildConnectionIfNeeded(connection, counts, offsets, indices, num_points);
+
+    // UV gradients of each face. polygons are handled as triangle fans.
+    bool vertex_uv = uv.size() == num_points;
+    RawVector<float3> face_tangents, face_binormals;
+    face_tangents.resize(num_faces);
+    face_binormals.resize(num_faces);
+    ParallelForChunks(num_faces, [&](size_t begin, size_t end) {
+        for (size_t fi = begin; fi < end; ++fi) {
+            int count = counts[fi];
+            int offset = offsets[fi];
+            const int *face = &indices[offset];
+            auto get_uv = [&](int ci) { return vertex_uv ? uv[face[ci]] : uv[offset + ci]; };
+
+            auto t = float3::zero();
+            auto b = float3::zero();
+            float3 p0 = points[face[0]];
+            float2 u0 = get_uv(0);
+            for (int ci = 1; ci < count - 1; ++ci) {
+                float3 e1 = points[face[ci]] - p0;
+                float3 e2 = points[face[ci + 1]] - p0;
+                float2 d1 = get_uv(ci) - u0;
+                float2 d2 = get_uv(ci + 1) - u0;
+                float r = d1.x * d2.y - d2.x * d1.y;
+                if (r == 0.0f) { continue; }
+                r = 1.0f / r;
+                t += (e1 * d2.y - e2 * d1.y) * r;
+                b += (e2 * d1.x - e1 * d2.x) * r;
+            }
+            face_tangents[fi] = t;
+            face_binormals[fi] = b;
+        }
+    });
+
+    bool vertex_normals = normals.size() == num_points;
+    ParallelForChunks(num_points, [&](size_t begin, size_t end) {
+        for (size_t vi = begin; vi < end; ++vi) {
+            int num_connections = connection.v2f_counts[vi];
+            int coffset = connection.v2f_offsets[vi];
+            const int *faces = &connection.v2f_faces[coffset];
+            auto t = float3::zero();
+            auto b = float3::zero();
+            for (int ci = 0; ci < num_connections; ++ci) {
+                t += face_tangents[faces[ci]];
+                b += face_binormals[faces[ci]];
+            }
+            if (num_connections == 0) {
+                dst[vi] = float4::zero();
+                continue;
+            }
+
+            // Gram-Schmidt
+            const auto& n = vertex_normals ? normals[vi] : normals[connection.v2f_indices[coffset]];
+            t -= n * dot(n, t);
+            float len2 = dot(t, t);
+            if (len2 > 0.0f) {
+                t *= 1.0f / std::sqrt(len2);
+            }
+            else {
+                // no UV gradient. any direction perpendicular to the normal
+                t = normalize(cross(n, std::abs(n.x) < 0.9f ? float3{ 1.0f, 0.0f, 0.0f } : float3{ 0.0f, 1.0f, 0.0f }));
+            }
+            float w = dot(cross(n, t), b) < 0.0f ? -1.0f : 1.0f;
+            dst[vi] = { t.x, t.y, t.z, w };
+        }
+    });
+    return true;
+}
+
+
+
+// select N most influential bones from count bones and normalize weights. result is sorted by weight.
+template<int N>
+static inline void SelectWeights(Weights<N>& dst, const int *bindices, const float *bweights, int count)
+{
+    int n = 0;
+    for (int i = 0; i < count; ++i) {
+        float w = bweights[i];
+        if (n == N && !(w > dst.weights[N - 1])) { continue; }
+
+        // insertion sort. stable for equal weights.
+        int pos = n < N ? n++ : N - 1;
+        while (pos > 0 && w > dst.weights[pos - 1]) {
+            dst.weights[pos] = dst.weights[pos - 1];
+            dst.indices[pos] = dst.indices[pos - 1];
+            --pos;
+        }
+        dst.weights[pos] = w;
+        dst.indices[pos] = bindices[i];
+    }
+    for (int i = n; i < N; ++i) {
+        dst.weights[i] = 0.0f;
+        dst.indices[i] = 0;
+    }
+
+    float total = 0.0f;
+    for (int i = 0; i < N; ++i) { total += dst.weights[i]; }
+    if (total > 0.0f) {
+        float rcp = 1.0f / total;
+        for (int i = 0; i < N; ++i) { dst.weights[i] *= rcp; }
+    }
+}
 
 template<int N>
 bool GenerateWeightsN(RawVector<Weights<N>>& dst, IArray<int> bone_indices, IArray<float> bone_weights, int bones_per_vertex)
 {
-    if (bone_indices.size() != bone_weights.size()) {
+    if (bone_indices.size() != bone_weights.size() || bones_per_vertex <= 0) {
         return false;
     }
 
-    int num_weightsN = (int)bone_indices.size() / bones_per_vertex;
-    dst.resize(num_weightsN);
+    dst.resize(bone_indices.size() / bones_per_vertex);
+    return GenerateWeightsN(IArray<Weights<N>>(dst.data(), dst.size()), bone_indices, bone_weights, bones_per_vertex);
+}
 
-    if (bones_per_vertex <= N) {
-        dst.zeroclear();
-        int bpvN = std::min<int>(N, bones_per_vertex);
-        for (int wi = 0; wi < num_weightsN; ++wi) {
-            auto *bindices = &bone_indices[bones_per_vertex * wi];
-            auto *bweights = &bone_weights[bones_per_vertex * wi];
+template<int N>
+bool GenerateWeightsN(IArray<Weights<N>> dst, IArray<int> bone_indices, IArray<float> bone_weights, int bones_per_vertex)
+{
+    if (bone_indices.size() != bone_weights.size() || bones_per_vertex <= 0 ||
+        dst.size() != bone_indices.size() / bones_per_vertex) {
+        return false;
+    }
 
-            // copy (up to) N elements
-            auto& w4 = dst[wi];
-            for (int oi = 0; oi < bpvN; ++oi) {
-                w4.indices[oi] = bindices[oi];
-                w4.weights[oi] = bweights[oi];
+    const int bpv = bones_per_vertex;
+    ParallelForChunks(dst.size(), [&](size_t begin, size_t end) {
+        if (bpv == N) {
+            // just a transposition
+            PackWeights(&dst[begin], &bone_weights[bpv * begin], &bone_indices[bpv * begin], N, end - begin);
+        }
+        else if (bpv < N) {
+            // copy and zero-fill
+            for (size_t wi = begin; wi < end; ++wi) {
+                auto& w = dst[wi];
+                w = Weights<N>();
+                memcpy(w.weights, &bone_weights[bpv * wi], sizeof(float) * bpv);
+                memcpy(w.indices, &bone_indices[bpv * wi], sizeof(int) * bpv);
+            }
+        }
+        else {
+            for (size_t wi = begin; wi < end; ++wi) {
+                SelectWeights(dst[wi], &bone_indices[bpv * wi], &bone_weights[bpv * wi], bpv);
             }
         }
+    });
+    return true;
+}
+
+template<int N>
+bool FlattenWeightsN(IArray<int> bone_indices, IArray<float> bone_weights, const IArray<Weights<N>> src)
+{
+    if (bone_indices.size() != src.size() * N || bone_weights.size() != src.size() * N) {
+        return false;
     }
-    else {
-        int *order = (int*)alloca(sizeof(int) * bones_per_vertex);
-        for (int wi = 0; wi < num_weightsN; ++wi) {
-            auto *bindices = &bone_indices[bones_per_vertex * wi];
-            auto *bweights = &bone_weights[bones_per_vertex * wi];
 
-            // sort order
-            std::iota(order, order + bones_per_vertex, 0);
-            std::nth_element(order, order + N, order + bones_per_vertex,
-                [&](int a, int b) { return bweights[a] > bweights[b]; });
+    ParallelForChunks(src.size(), [&](size_t begin, size_t end) {
+        UnpackWeights(&bone_weights[N * begin], &bone_indices[N * begin], &src[begin], N, end - begin);
+    });
+    return true;
+}
 
-            // copy (up to) N elements
-            auto& w4 = dst[wi];
-            float w = 0.0f;
-            for (int oi = 0; oi < N; ++oi) {
-                int o = order[oi];
-                w4.indices[oi] = bindices[o];
-                w4.weights[oi] = bweights[o];
-                w += bweights[o];
-            }
+template<int N, int M>
+bool ConvertWeights(IArray<Weights<N>> dst, const IArray<Weights<M>> src)
+{
+    if (dst.size() != src.size()) {
+        return false;
+    }
 
-            // normalize weights
-            float rcpw = 1.0f / w;
-            for (int oi = 0; oi < N; ++oi) {
-                w4.weights[oi] *= rcpw;
+    ParallelForChunks(src.size(), [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            const auto& s = src[i];
+            auto& d = dst[i];
+            if (M <= N) {
+                d = Weights<N>();
+                memcpy(d.weights, s.weights, sizeof(float) * std::min(N, M));
+                memcpy(d.indices, s.indices, sizeof(int) * std::min(N, M));
+            }
+            else {
+                SelectWeights(d, s.indices, s.weights, M);
             }
         }
-    }
+    });
     return true;
 }
+
 template bool GenerateWeightsN(RawVector<Weights<4>>& dst, IArray<int> bone_indices, IArray<float> bone_weights, int bones_per_vertex);
 template bool GenerateWeightsN(RawVector<Weights<8>>& dst, IArray<int> bone_indices, IArray<float> bone_weights, int bones_per_vertex);
+template bool GenerateWeightsN(IArray<Weights<4>> dst, IArray<int> bone_indices, IArray<float> bone_weights, int bones_per_vertex);
+template bool GenerateWeightsN(IArray<Weights<8>> dst, IArray<int> bone_indices, IArray<float> bone_weights, int bones_per_vertex);
+template bool FlattenWeightsN(IArray<int> bone_indices, IArray<float> bone_weights, const IArray<Weights<4>> src);
+template bool FlattenWeightsN(IArray<int> bone_indices, IArray<float> bone_weights, const IArray<Weights<8>> src);
+template bool ConvertWeights(IArray<Weights<4>> dst, const IArray<Weights<8>> src);
+template bool ConvertWeights(IArray<Weights<8>> dst, const IArray<Weights<4>> src);
+
+
+// begin offsets of a chunk of faces in indices and triangulated indices
+struct FaceChunk
+{
+    int index_begin;
+    int tri_index_begin;
+    int min_count;
+    int max_count;
+};
+
+// dst gets num_chunks + 1 elements. the last one holds totals and min / max of counts of whole mesh.
+static void ScanFaceChunks(RawVector<FaceChunk>& dst, const IArray<int>& counts)
+{
+    size_t num_faces = counts.size();
+    size_t num_chunks = ceildiv(num_faces, (size_t)muParallelChunkSize);
+    dst.resize(num_chunks + 1);
+    ParallelForChunks(num_faces, [&](size_t begin, size_t end) {
+        FaceChunk c = { 0, 0, INT_MAX, 0 };
+        for (size_t fi = begin; fi < end; ++fi) {
+            int count = counts[fi];
+            c.index_begin += count;
+            c.tri_index_begin += std::max<int>(count - 2, 0) * 3;
+            c.min_count = std::min<int>(c.min_count, count);
+            c.max_count = std::max<int>(c.max_count, count);
+        }
+        dst[begin / muParallelChunkSize] = c;
+    });
+
+    FaceChunk total = { 0, 0, INT_MAX, 0 };
+    for (size_t ci = 0; ci < num_chunks; ++ci) {
+        FaceChunk c = dst[ci];
+        dst[ci].index_begin = total.index_begin;
+        dst[ci].tri_index_begin = total.tri_index_begin;
+        total.index_begin += c.index_begin;
+        total.tri_index_begin += c.tri_index_begin;
+        total.min_count = std::min<int>(total.min_count, c.min_count);
+        total.max_count = std::max<int>(total.max_count, c.max_count);
+    }
+    dst[num_chunks] = total;
+}
+
+void CountIndicesParallel(const IArray<int> counts, IArray<int> offsets, int& num_indices, int& num_indices_triangulated)
+{
+    if (!ShouldRunParallel(counts.size())) {
+        int reti = 0, rett = 0;
+        size_t num_faces = counts.size();
+        for (size_t fi = 0; fi < num_faces; ++fi) {
+            int f = counts[fi];
+            offsets[fi] = reti;
+            reti += f;
+            rett += std::max<int>(f - 2, 0) * 3;
+        }
+        num_indices = reti;
+        num_indices_triangulated = rett;
+        return;
+    }
+
+    RawVector<FaceChunk> chunks;
+    ScanFaceChunks(chunks, counts);
+
+    ParallelForChunks(counts.size(), [&](size_t begin, size_t end) {
+        int offset = chunks[begin / muParallelChunkSize].index_begin;
+        for (size_t fi = begin; fi < end; ++fi) {
+            offsets[fi] = offset;
+            offset += counts[fi];
+        }
+    });
+    num_indices = chunks.back().index_begin;
+    num_indices_triangulated = chunks.back().tri_index_begin;
+}
+
+// indices of face corners. used when no index array is given.
+struct CornerIndices
+{
+    int operator[](int i) const { return i; }
+};
+
+template<class Indices>
+static void TriangulateImpl(IArray<int>& dst, const IArray<int>& counts, const Indices& indices,
+    const RawVector<FaceChunk>& chunks, bool swap_face)
+{
+    const int i1 = swap_face ? 2 : 1;
+    const int i2 = swap_face ? 1 : 2;
+    const auto& total = chunks.back();
+    size_t num_faces = counts.size();
+
+    if (total.min_count == 3 && total.max_count == 3) {
+        ParallelForChunks(num_faces, [&](size_t begin, size_t end) {
+            for (int fi = (int)begin; fi < (int)end; ++fi) {
+                int n = fi * 3;
+                dst[n + 0] = indices[n + 0];
+                dst[n + 1] = indices[n + i1];
+                dst[n + 2] = indices[n + i2];
+            }
+        });
+    }
+    else if (total.min_count == 4 && total.max_count == 4) {
+        ParallelForChunks(num_faces, [&](size_t begin, size_t end) {
+            for (int fi = (int)begin; fi < (int)end; ++fi) {
+                int n = fi * 4;
+                int i = fi * 6;
+                dst[i + 0] = indices[n + 0];
+                dst[i + 1] = indices[n + i1];
+                dst[i + 2] = indices[n + i2];
+                dst[i + 3] = indices[n + 0];
+                dst[i + 4] = indices[n + 1 + i1];
+                dst[i + 5] = indices[n + 1 + i2];
+            }
+        });
+    }
+    else {
+        ParallelForChunks(num_faces, [&](size_t begin, size_t end) {
+            const auto& chunk = chunks[begin / muParallelChunkSize];
+            int n = chunk.index_begin;
+            int i = chunk.tri_index_begin;
+            for (size_t fi = begin; fi < end; ++fi) {
+                int count = counts[fi];
+                for (int ni = 0; ni < count - 2; ++ni) {
+                    dst[i + 0] = indices[n + 0];
+                    dst[i + 1] = indices[n + ni + i1];
+                    dst[i + 2] = indices[n + ni + i2];
+                    i += 3;
+                }
+                n += count;
+            }
+        });
+    }
+}
+
+void TriangulateParallel(IArray<int> dst, const IArray<int> counts, const IArray<int> indices, bool swap_face)
+{
+    if (!ShouldRunParallel(counts.size())) {
+        if (!indices.empty()) {
+            TriangulateWithIndices(dst, counts, indices, swap_face);
+        }
+        else {
+            Triangulate(dst, counts, swap_face);
+        }
+        return;
+    }
+
+    RawVector<FaceChunk> chunks;
+    ScanFaceChunks(chunks, counts);
+
+    const auto& total = chunks.back();
+    if (!indices.empty() && !swap_face && total.min_count == 3 && total.max_count == 3) {
+        // already triangulated
+        memcpy(dst.data(), indices.data(), sizeof(int) * total.index_begin);
+    }
+    else if (!indices.empty()) {
+        TriangulateImpl(dst, counts, indices, chunks, swap_face);
+    }
+    else {
+        TriangulateImpl(dst, counts, CornerIndices(), chunks, swap_face);
+    }
+}
+
+void GatherParallel(const GatherStream *streams, size_t num_streams, const int *indices, size_t num)
+{
+    ParallelForChunks(num, [&](size_t begin, size_t end) {
+        RawVector<GatherStream> chunk;
+        chunk.assign(streams, streams + num_streams);
+        for (auto& s : chunk) {
+            if (s.dst) { s.dst = (char*)s.dst + s.size * begin; }
+        }
+        Gather(chunk.data(), chunk.size(), indices + begin, end - begin);
+    });
+}
+
+void SplitMesh(std::vector<MeshSplit>& dst,
+    const IArray<int> counts, const IArray<int> indices, const IArray<int> indices_triangulated,
+    size_t num_points, int max_vertices)
+{
+    dst.clear();
+
+    // vertex is in current chunk if marks[vi] == index of current chunk. avoids clearing old2new for each chunk.
+    RawVector<int> marks, old2new;
+    marks.resize(num_points);
+    old2new.resize(num_points);
+    memset(marks.data(), -1, sizeof(int) * num_points);
+
+    MeshSplit *split = nullptr;
+    int nth = -1;
+    int ii = 0, ti = 0;
+    size_t num_faces = counts.size();
+    for (size_t fi = 0; fi < num_faces; ++fi) {
+        int count = counts[fi];
+        const int *face = &indices[ii];
+
+        int num_new_vertices = 0;
+        for (int ci = 0; ci < count; ++ci) {
+            if (marks[face[ci]] != nth) { ++num_new_vertices; }
+        }
+        if (!split || (split->num_faces > 0 && (int)split->vertices.size() + num_new_vertices > max_vertices)) {
+            dst.emplace_back();
+            split = &dst.back();
+            ++nth;
+            split->face_begin = (int)fi;
+            split->index_begin = ti;
+        }
+
+        for (int ci = 0; ci < count; ++ci) {
+            int vi = face[ci];
+            if (marks[vi] != nth) {
+                marks[vi] = nth;
+                old2new[vi] = (int)split->vertices.size();
+                split->vertices.push_back(vi);
+            }
+        }
+
+        int num_tri_indices = std::max<int>(count - 2, 0) * 3;
+        for (int i = 0; i < num_tri_indices; ++i) {
+            split->indices.push_back(old2new[indices_triangulated[ti + i]]);
+        }
+        split->num_faces++;
+        split->num_indices += num_tri_indices;
+        ii += count;
+        ti += num_tri_indices;
+    }
+}
 
 } // namespace mu
@@ -21,6 +21,30 @@ struct Weights
 using Weights4 = Weights<4>;
 using Weights8 = Weights<8>;
 
+// vertex -> faces connection. can be reused while topology is unchanged.
+struct MeshConnectionInfo
+{
+    RawVector<int> v2f_counts;
+    RawVector<int> v2f_offsets;
+    RawVector<int> v2f_faces;   // connected faces of each vertex in order of face index
+    RawVector<int> v2f_indices; // position in indices of each connection
+
+    void clear();
+    // offsets: offset of each face in indices
+    void buildConnection(const IArray<int>& counts, const IArray<int>& offsets, const IArray<int>& indices, size_t num_points);
+};
+
+// a chunk of mesh made by SplitMesh()
+struct MeshSplit
+{
+    int face_begin = 0;
+    int num_faces = 0;
+    int index_begin = 0;        // offset in triangulated indices
+    int num_indices = 0;        // number of triangulated indices
+    RawVector<int> vertices;    // new -> old vertex index
+    RawVector<int> indices;     // triangulated indices of this chunk that refer vertices
+};
+
 // size of dst must be num_points
 bool GenerateNormals(
     IArray<float3> dst, const IArray<float3> points,
@@ -28,13 +52,67 @@ bool GenerateNormals(
 bool GenerateNormals(
     IArray<float3> dst, const IArray<float3> points,
     const IArray<int> counts, const IArray<int> offsets, const IArray<int> indices);
+// same result as GenerateNormals() but runs in parallel. face normals are computed in SIMD and then gathered per vertex
+// through connection. result doesn't depend on number of threads.
+// slower than GenerateNormals() on a single thread or with small meshes. see ShouldRunParallel().
+// connection is built if it doesn't match points, and should be cleared when topology changes.
+bool GenerateNormalsParallel(
+    IArray<float3> dst, const IArray<float3> points,
+    const IArray<int> counts, const IArray<int> offsets, const IArray<int> indices,
+    MeshConnectionInfo& connection);
 
 bool GenerateTangents(
     IArray<float4> dst, const IArray<float3> points, const IArray<float3> normals, const IArray<float2> uv,
     const IArray<int> counts, const IArray<int> offsets, const IArray<int> indices);
+// parallel version of GenerateTangents(). faces are split into chunks and each chunk is processed by MikkTSpace.
+// vertices shared by faces of different chunks are recomputed afterwards from all faces around them in one pass,
+// so the result is same as GenerateTangents() (as long as no distinct vertices have identical position, normal and
+// uv: MikkTSpace welds them). the extra pass is serial, so meshes whose face order is far from spatially coherent
+// gain little. connection is built if it doesn't match points.
+bool GenerateTangentsParallel(
+    IArray<float4> dst, const IArray<float3> points, const IArray<float3> normals, const IArray<float2> uv,
+    const IArray<int> counts, const IArray<int> offsets, const IArray<int> indices,
+    MeshConnectionInfo& connection);
+// per-vertex tangents by accumulating UV gradients of connected faces and Gram-Schmidt orthogonalization.
+// much faster than MikkTSpace, but results are not identical to it. dst must be per-vertex.
+bool GenerateTangentsFast(
+    IArray<float4> dst, const IArray<float3> points, const IArray<float3> normals, const IArray<float2> uv,
+    const IArray<int> counts, const IArray<int> offsets, const IArray<int> indices,
+    MeshConnectionInfo& connection);
 
+// flat arrays of bone indices and weights (bones_per_vertex elements per vertex) -> Weights<N>. runs in parallel.
+// if bones_per_vertex > N, N most influential bones are selected (sorted by weight) and weights are normalized.
+// if bones_per_vertex < N, rest elements are zero-filled.
 template<int N>
 bool GenerateWeightsN(RawVector<Weights<N>>& dst, IArray<int> bone_indices, IArray<float> bone_weights, int bones_per_vertex);
+// dst must be sized to bone_indices.size() / bones_per_vertex.
+template<int N>
+bool GenerateWeightsN(IArray<Weights<N>> dst, IArray<int> bone_indices, IArray<float> bone_weights, int bones_per_vertex);
+// Weights<N> -> flat arrays of N elements per vertex. bone_indices and bone_weights must be sized to src.size() * N.
+template<int N>
+bool FlattenWeightsN(IArray<int> bone_indices, IArray<float> bone_weights, const IArray<Weights<N>> src);
+// Weights<M> -> Weights<N>. same rule as GenerateWeightsN() is applied if M > N.
+template<int N, int M>
+bool ConvertWeights(IArray<Weights<N>> dst, const IArray<Weights<M>> src);
+
+// parallel versions of CountIndices() and TriangulateWithIndices(). faces are processed in fixed-size chunks:
+// chunks are summed in parallel, the sums are scanned, and then each chunk writes its part independently.
+// the extra summing pass makes them slower on a single thread, so they run serially if !ShouldRunParallel(num_faces).
+// offsets must be sized to counts.size(). dst must be sized to num_indices_triangulated.
+void CountIndicesParallel(const IArray<int> counts, IArray<int> offsets, int& num_indices, int& num_indices_triangulated);
+// if indices is empty, indices of face corners are written (same as Triangulate()).
+// meshes that consist of only triangles or only quads take fast paths.
+void TriangulateParallel(IArray<int> dst, const IArray<int> counts, const IArray<int> indices, bool swap_face);
+
+// parallel version of Gather(). indices are split into fixed-size chunks and each chunk is gathered by Gather().
+void GatherParallel(const GatherStream *streams, size_t num_streams, const int *indices, size_t num);
+
+// split mesh into chunks that have max_vertices or less vertices each.
+// faces are not reordered and vertices shared by faces in the same chunk stay shared.
+// indices_triangulated must be made from counts and indices by TriangulateWithIndices() (swap_face is ok).
+void SplitMesh(std::vector<MeshSplit>& dst,
+    const IArray<int> counts, const IArray<int> indices, const IArray<int> indices_triangulated,
+    size_t num_points, int max_vertices);
 
 
 
@@ -284,3 +362,4 @@ inline uint32_t Float4ToColor32(const float4& c)
 } // namespace mu
 
 #include "MeshRefiner.h"
+#include "MeshSimplifier.h"
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <tbb/tbb.h>
+
+namespace mu {
+
+#define muParallelChunkSize 0x4000
+
+// parallel paths have extra passes (connection, chunk sums) and pay off only if the work is split into more than
+// one chunk and more than one thread is available. otherwise serial paths are faster.
+inline bool ShouldRunParallel(size_t num, size_t chunk_size = muParallelChunkSize)
+{
+    return num > chunk_size && tbb::this_task_arena::max_concurrency() > 1;
+}
+
+// Body: [](size_t begin, size_t end) -> void
+// chunk boundaries are fixed regardless of number of threads and scheduling.
+// so results of SIMD kernels (vectorized part and scalar tail may differ slightly) are deterministic.
+template<class Body>
+inline void ParallelForChunks(size_t num, size_t chunk_size, const Body& body)
+{
+    if (num == 0) { return; }
+    size_t num_chunks = ceildiv(num, chunk_size);
+    if (num_chunks == 1) {
+        body(size_t(0), num);
+        return;
+    }
+    tbb::parallel_for(size_t(0), num_chunks, [&](size_t ci) {
+        size_t begin = ci * chunk_size;
+        size_t end = std::min<size_t>(begin + chunk_size, num);
+        body(begin, end);
+    });
+}
+
+template<class Body>
+inline void ParallelForChunks(size_t num, const Body& body)
+{
+    ParallelForChunks(num, muParallelChunkSize, body);
+}
+
+// exclusive prefix sum. dst and src must not overlap. returns total.
+template<class T>
+inline T ParallelPrefixSum(T *dst, const T *src, size_t num)
+{
+    if (num <= muParallelChunkSize) {
+        T sum = T();
+        for (size_t i = 0; i < num; ++i) {
+            T v = src[i];
+            dst[i] = sum;
+            sum += v;
+        }
+        return sum;
+    }
+    return tbb::parallel_scan(
+        tbb::blocked_range<size_t>(0, num, muParallelChunkSize), T(),
+        [&](const tbb::blocked_range<size_t>& r, T sum, bool is_final) {
+            for (size_t i = r.begin(); i != r.end(); ++i) {
+                T v = src[i];
+                if (is_final) { dst[i] = sum; }
+                sum += v;
+            }
+            return sum;
+        },
+        [](T a, T b) { return a + b; });
+}
+
+} // namespace mu
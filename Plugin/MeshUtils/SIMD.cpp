@@ -1,6 +1,21 @@
 #include "pch.h"
 #include "MeshUtils.h"
 #include "SIMD.h"
+#include "Parallel.h"
+
+#ifdef _MSC_VER
+    #include <xmmintrin.h>
+    #define muPrefetch(p) _mm_prefetch((const char*)(p), _MM_HINT_T0)
+#else
+    #define muPrefetch(p) __builtin_prefetch(p)
+#endif
+#ifdef muEnableSSE
+    #include <emmintrin.h>
+#endif
+
+// distance in elements to prefetch ahead in Gather()
+#define muGatherPrefetchDistance 64
+#define muMaxGatherStreams 16
 
 namespace mu {
 
@@ -60,6 +75,40 @@ void Normalize_Generic(float3 *dst, size_t num)
     }
 }
 
+void TransformPoints_Generic(float3 *dst, const float3 *src, const float4x4& m, size_t num)
+{
+    for (size_t i = 0; i < num; ++i) {
+        dst[i] = applyTRS(m, src[i]);
+    }
+}
+void TransformVectors_Generic(float3 *dst, const float3 *src, const float4x4& m, size_t num)
+{
+    for (size_t i = 0; i < num; ++i) {
+        dst[i] = m * src[i];
+    }
+}
+void TransformNormals_Generic(float3 *dst, const float3 *src, const float4x4& m, size_t num)
+{
+    for (size_t i = 0; i < num; ++i) {
+        dst[i] = normalize(m * src[i]);
+    }
+}
+
+void GenerateFaceNormals_Generic(float3 *dst, const float3 *points, const int *counts, const int *offsets, const int *indices, size_t num_faces)
+{
+    for (size_t fi = 0; fi < num_faces; ++fi) {
+        if (counts[fi] < 3) {
+            dst[fi] = float3::zero();
+            continue;
+        }
+        const int *face = &indices[offsets[fi]];
+        float3 p0 = points[face[0]];
+        float3 p1 = points[face[1]];
+        float3 p2 = points[face[2]];
+        dst[fi] = cross(p1 - p0, p2 - p0);
+    }
+}
+
 void Lerp_Generic(float *dst, const float *src1, const float *src2, size_t num, float w)
 {
     const float iw = 1.0f - w;
@@ -118,6 +167,306 @@ bool NearEqual_Generic(const float *src1, const float *src2, size_t num, float e
     return true;
 }
 
+template<int Size>
+static inline void GatherStream_Generic(char *dst, const char *src, const int *indices, size_t num)
+{
+    size_t num_prefetch = num > muGatherPrefetchDistance ? num - muGatherPrefetchDistance : 0;
+    size_t i = 0;
+    for (; i < num_prefetch; ++i) {
+        muPrefetch(src + Size * indices[i + muGatherPrefetchDistance]);
+        memcpy(dst + Size * i, src + Size * indices[i], Size);
+    }
+    for (; i < num; ++i) {
+        memcpy(dst + Size * i, src + Size * indices[i], Size);
+    }
+}
+
+// on scalar path, interleaving streams per element or per block was measured slower than a pass per stream
+// (random accesses to many arrays at once compete for cache and TLB). so streams are processed one by one
+// with size-specialized loops. the ISPC version shares each index vector among streams.
+void Gather_Generic(const GatherStream *streams, size_t num_streams, const int *indices, size_t num)
+{
+    for (size_t si = 0; si < num_streams; ++si) {
+        auto& s = streams[si];
+        if (!s.dst || !s.src) { continue; }
+        auto *dst = (char*)s.dst;
+        auto *src = (const char*)s.src;
+        switch (s.size) {
+        case 8: GatherStream_Generic<8>(dst, src, indices, num); break;
+        case 12: GatherStream_Generic<12>(dst, src, indices, num); break;
+        case 16: GatherStream_Generic<16>(dst, src, indices, num); break;
+        case 32: GatherStream_Generic<32>(dst, src, indices, num); break;
+        case 64: GatherStream_Generic<64>(dst, src, indices, num); break;
+        default:
+            for (size_t i = 0; i < num; ++i) {
+                memcpy(dst + s.size * i, src + s.size * indices[i], s.size);
+            }
+            break;
+        }
+    }
+}
+
+template<int N>
+static inline void PackWeights_Generic(char *dst, const float *weights, const int *indices, size_t num)
+{
+    // fixed-size copies are turned into vector moves
+    for (size_t i = 0; i < num; ++i) {
+        memcpy(dst, weights, sizeof(float) * N);
+        memcpy(dst + sizeof(float) * N, indices, sizeof(int) * N);
+        dst += (sizeof(float) + sizeof(int)) * N;
+        weights += N;
+        indices += N;
+    }
+}
+void PackWeights_Generic(void *dst, const float *weights, const int *indices, int n, size_t num)
+{
+    switch (n) {
+    case 4: PackWeights_Generic<4>((char*)dst, weights, indices, num); break;
+    case 8: PackWeights_Generic<8>((char*)dst, weights, indices, num); break;
+    }
+}
+
+template<int N>
+static inline void UnpackWeights_Generic(float *weights, int *indices, const char *src, size_t num)
+{
+    for (size_t i = 0; i < num; ++i) {
+        memcpy(weights, src, sizeof(float) * N);
+        memcpy(indices, src + sizeof(float) * N, sizeof(int) * N);
+        src += (sizeof(float) + sizeof(int)) * N;
+        weights += N;
+        indices += N;
+    }
+}
+void UnpackWeights_Generic(float *weights, int *indices, const void *src, int n, size_t num)
+{
+    switch (n) {
+    case 4: UnpackWeights_Generic<4>(weights, indices, (const char*)src, num); break;
+    case 8: UnpackWeights_Generic<8>(weights, indices, (const char*)src, num); break;
+    }
+}
+
+
+#ifdef muEnableSSE
+// hand-written SSE versions. used when ISPC is not available.
+// float3 streams are processed 4 elements (= 3 registers) at a time and the rest are handled by the generic versions.
+
+void InvertX_SSE(float3 *dst, size_t num)
+{
+    // sign bits of x in 4 float3 laid out as 3 registers: xyzx yzxy zxyz
+    const __m128 m0 = _mm_set_ps(-0.0f, 0.0f, 0.0f, -0.0f);
+    const __m128 m1 = _mm_set_ps(0.0f, -0.0f, 0.0f, 0.0f);
+    const __m128 m2 = _mm_set_ps(0.0f, 0.0f, -0.0f, 0.0f);
+
+    size_t n4 = num / 4;
+    float *d = (float*)dst;
+    for (size_t i = 0; i < n4; ++i, d += 12) {
+        _mm_storeu_ps(d + 0, _mm_xor_ps(_mm_loadu_ps(d + 0), m0));
+        _mm_storeu_ps(d + 4, _mm_xor_ps(_mm_loadu_ps(d + 4), m1));
+        _mm_storeu_ps(d + 8, _mm_xor_ps(_mm_loadu_ps(d + 8), m2));
+    }
+    InvertX_Generic(dst + n4 * 4, num - n4 * 4);
+}
+void InvertX_SSE(float4 *dst, size_t num)
+{
+    const __m128 m = _mm_set_ps(0.0f, 0.0f, 0.0f, -0.0f);
+    float *d = (float*)dst;
+    for (size_t i = 0; i < num; ++i, d += 4) {
+        _mm_storeu_ps(d, _mm_xor_ps(_mm_loadu_ps(d), m));
+    }
+}
+
+void Scale_SSE(float *dst, float s, size_t num)
+{
+    const __m128 s4 = _mm_set1_ps(s);
+    size_t n4 = num / 4;
+    for (size_t i = 0; i < n4; ++i) {
+        _mm_storeu_ps(dst + i * 4, _mm_mul_ps(_mm_loadu_ps(dst + i * 4), s4));
+    }
+    Scale_Generic(dst + n4 * 4, s, num - n4 * 4);
+}
+void Scale_SSE(float3 *dst, float s, size_t num)
+{
+    Scale_SSE((float*)dst, s, num * 3);
+}
+
+void Normalize_SSE(float3 *dst, size_t num)
+{
+    const __m128 one = _mm_set1_ps(1.0f);
+    size_t n4 = num / 4;
+    float *d = (float*)dst;
+    for (size_t i = 0; i < n4; ++i, d += 12) {
+        __m128 a = _mm_loadu_ps(d + 0); // x0 y0 z0 x1
+        __m128 b = _mm_loadu_ps(d + 4); // y1 z1 x2 y2
+        __m128 c = _mm_loadu_ps(d + 8); // z2 x3 y3 z3
+        __m128 aa = _mm_mul_ps(a, a);
+        __m128 bb = _mm_mul_ps(b, b);
+        __m128 cc = _mm_mul_ps(c, c);
+
+        // transpose squares to xxxx yyyy zzzz
+        __m128 xx = _mm_shuffle_ps(aa, _mm_shuffle_ps(bb, cc, _MM_SHUFFLE(1, 1, 2, 2)), _MM_SHUFFLE(2, 0, 3, 0));
+        __m128 yy = _mm_shuffle_ps(_mm_shuffle_ps(aa, bb, _MM_SHUFFLE(0, 0, 1, 1)), _mm_shuffle_ps(bb, cc, _MM_SHUFFLE(2, 2, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0));
+        __m128 zz = _mm_shuffle_ps(_mm_shuffle_ps(aa, bb, _MM_SHUFFLE(1, 1, 2, 2)), _mm_shuffle_ps(cc, cc, _MM_SHUFFLE(3, 3, 0, 0)), _MM_SHUFFLE(2, 0, 2, 0));
+        __m128 rl = _mm_div_ps(one, _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(xx, yy), zz)));
+
+        // and back to xyzx yzxy zxyz
+        _mm_storeu_ps(d + 0, _mm_mul_ps(a, _mm_shuffle_ps(rl, rl, _MM_SHUFFLE(1, 0, 0, 0))));
+        _mm_storeu_ps(d + 4, _mm_mul_ps(b, _mm_shuffle_ps(rl, rl, _MM_SHUFFLE(2, 2, 1, 1))));
+        _mm_storeu_ps(d + 8, _mm_mul_ps(c, _mm_shuffle_ps(rl, rl, _MM_SHUFFLE(3, 3, 3, 2))));
+    }
+    Normalize_Generic(dst + n4 * 4, num - n4 * 4);
+}
+
+void Lerp_SSE(float *dst, const float *src1, const float *src2, size_t num, float w)
+{
+    const __m128 w4 = _mm_set1_ps(w);
+    const __m128 iw4 = _mm_set1_ps(1.0f - w);
+    size_t n4 = num / 4;
+    for (size_t i = 0; i < n4; ++i) {
+        __m128 r = _mm_add_ps(
+            _mm_mul_ps(_mm_loadu_ps(src1 + i * 4), w4),
+            _mm_mul_ps(_mm_loadu_ps(src2 + i * 4), iw4));
+        _mm_storeu_ps(dst + i * 4, r);
+    }
+    Lerp_Generic(dst + n4 * 4, src1 + n4 * 4, src2 + n4 * 4, num - n4 * 4, w);
+}
+
+void MinMax_SSE(const float3 *src, size_t num, float3& dst_min, float3& dst_max)
+{
+    if (num < 4) {
+        MinMax_Generic(src, num, dst_min, dst_max);
+        return;
+    }
+
+    size_t n4 = num / 4;
+    const float *s = (const float*)src;
+    __m128 min0, min1, min2, max0, max1, max2;
+    min0 = max0 = _mm_loadu_ps(s + 0);
+    min1 = max1 = _mm_loadu_ps(s + 4);
+    min2 = max2 = _mm_loadu_ps(s + 8);
+    for (size_t i = 1; i < n4; ++i) {
+        s += 12;
+        __m128 a = _mm_loadu_ps(s + 0);
+        __m128 b = _mm_loadu_ps(s + 4);
+        __m128 c = _mm_loadu_ps(s + 8);
+        min0 = _mm_min_ps(min0, a); max0 = _mm_max_ps(max0, a);
+        min1 = _mm_min_ps(min1, b); max1 = _mm_max_ps(max1, b);
+        min2 = _mm_min_ps(min2, c); max2 = _mm_max_ps(max2, c);
+    }
+
+    // each register holds a mix of xyz (xyzx yzxy zxyz). reduce them to one float3.
+    float mins[12], maxs[12];
+    _mm_storeu_ps(mins + 0, min0); _mm_storeu_ps(mins + 4, min1); _mm_storeu_ps(mins + 8, min2);
+    _mm_storeu_ps(maxs + 0, max0); _mm_storeu_ps(maxs + 4, max1); _mm_storeu_ps(maxs + 8, max2);
+    float3 rmin = (float3&)mins[0];
+    float3 rmax = (float3&)maxs[0];
+    for (int i = 1; i < 4; ++i) {
+        rmin[0] = std::min<float>(rmin[0], mins[i * 3 + 0]);
+        rmin[1] = std::min<float>(rmin[1], mins[i * 3 + 1]);
+        rmin[2] = std::min<float>(rmin[2], mins[i * 3 + 2]);
+
+        rmax[0] = std::max<float>(rmax[0], maxs[i * 3 + 0]);
+        rmax[1] = std::max<float>(rmax[1], maxs[i * 3 + 1]);
+        rmax[2] = std::max<float>(rmax[2], maxs[i * 3 + 2]);
+    }
+
+    size_t rest = num - n4 * 4;
+    if (rest > 0) {
+        float3 tmin, tmax;
+        MinMax_Generic(src + n4 * 4, rest, tmin, tmax);
+        rmin = float3{ std::min<float>(rmin[0], tmin[0]), std::min<float>(rmin[1], tmin[1]), std::min<float>(rmin[2], tmin[2]) };
+        rmax = float3{ std::max<float>(rmax[0], tmax[0]), std::max<float>(rmax[1], tmax[1]), std::max<float>(rmax[2], tmax[2]) };
+    }
+    dst_min = rmin;
+    dst_max = rmax;
+}
+
+bool NearEqual_SSE(const float *src1, const float *src2, size_t num, float eps)
+{
+    const __m128 sign = _mm_set1_ps(-0.0f);
+    const __m128 eps4 = _mm_set1_ps(eps);
+    size_t n4 = num / 4;
+    for (size_t i = 0; i < n4; ++i) {
+        __m128 d = _mm_andnot_ps(sign, _mm_sub_ps(_mm_loadu_ps(src1 + i * 4), _mm_loadu_ps(src2 + i * 4)));
+        if (_mm_movemask_ps(_mm_cmplt_ps(d, eps4)) != 0xf) {
+            return false;
+        }
+    }
+    return NearEqual_Generic(src1 + n4 * 4, src2 + n4 * 4, num - n4 * 4, eps);
+}
+
+// load / store a float3 without touching memory outside of it. w is 0.
+static inline __m128 Load3_SSE(const float3& v)
+{
+    return _mm_movelh_ps(_mm_loadl_pi(_mm_setzero_ps(), (const __m64*)&v), _mm_load_ss(&v[2]));
+}
+static inline void Store3_SSE(float3& dst, __m128 v)
+{
+    _mm_storel_pi((__m64*)&dst, v);
+    _mm_store_ss(&dst[2], _mm_movehl_ps(v, v));
+}
+
+// x * m[0] + y * m[1] + z * m[2] (+ m[3]). same order of operations as the generic versions.
+// each element is loaded before it is stored, so dst and src can be the same.
+template<bool Translate, bool Normalize>
+static inline void Transform_SSE(float3 *dst, const float3 *src, const float4x4& m, size_t num)
+{
+    const __m128 m0 = _mm_loadu_ps(&m[0][0]);
+    const __m128 m1 = _mm_loadu_ps(&m[1][0]);
+    const __m128 m2 = _mm_loadu_ps(&m[2][0]);
+    const __m128 m3 = _mm_loadu_ps(&m[3][0]);
+    const __m128 one = _mm_set_ss(1.0f);
+    for (size_t i = 0; i < num; ++i) {
+        const float *s = &src[i][0];
+        __m128 r = _mm_add_ps(_mm_add_ps(
+            _mm_mul_ps(_mm_load1_ps(s + 0), m0),
+            _mm_mul_ps(_mm_load1_ps(s + 1), m1)),
+            _mm_mul_ps(_mm_load1_ps(s + 2), m2));
+        if (Translate) {
+            r = _mm_add_ps(r, m3);
+        }
+        if (Normalize) {
+            __m128 rr = _mm_mul_ps(r, r);
+            __m128 d = _mm_add_ss(_mm_add_ss(rr, _mm_shuffle_ps(rr, rr, _MM_SHUFFLE(1, 1, 1, 1))), _mm_movehl_ps(rr, rr));
+            d = _mm_div_ss(one, _mm_sqrt_ss(d));
+            r = _mm_mul_ps(r, _mm_shuffle_ps(d, d, _MM_SHUFFLE(0, 0, 0, 0)));
+        }
+        Store3_SSE(dst[i], r);
+    }
+}
+
+void TransformPoints_SSE(float3 *dst, const float3 *src, const float4x4& m, size_t num)
+{
+    Transform_SSE<true, false>(dst, src, m, num);
+}
+void TransformVectors_SSE(float3 *dst, const float3 *src, const float4x4& m, size_t num)
+{
+    Transform_SSE<false, false>(dst, src, m, num);
+}
+void TransformNormals_SSE(float3 *dst, const float3 *src, const float4x4& m, size_t num)
+{
+    Transform_SSE<false, true>(dst, src, m, num);
+}
+
+void GenerateFaceNormals_SSE(float3 *dst, const float3 *points, const int *counts, const int *offsets, const int *indices, size_t num_faces)
+{
+    for (size_t fi = 0; fi < num_faces; ++fi) {
+        if (counts[fi] < 3) {
+            dst[fi] = float3::zero();
+            continue;
+        }
+        const int *face = &indices[offsets[fi]];
+        __m128 p0 = Load3_SSE(points[face[0]]);
+        __m128 e1 = _mm_sub_ps(Load3_SSE(points[face[1]]), p0);
+        __m128 e2 = _mm_sub_ps(Load3_SSE(points[face[2]]), p0);
+        // cross(e1, e2) = e1.yzx * e2.zxy - e1.zxy * e2.yzx
+        __m128 r = _mm_sub_ps(
+            _mm_mul_ps(_mm_shuffle_ps(e1, e1, _MM_SHUFFLE(3, 0, 2, 1)), _mm_shuffle_ps(e2, e2, _MM_SHUFFLE(3, 1, 0, 2))),
+            _mm_mul_ps(_mm_shuffle_ps(e1, e1, _MM_SHUFFLE(3, 1, 0, 2)), _mm_shuffle_ps(e2, e2, _MM_SHUFFLE(3, 0, 2, 1))));
+        Store3_SSE(dst[fi], r);
+    }
+}
+#endif // muEnableSSE
+
 
 #ifdef muEnableISPC
 #include "MeshUtilsCore.h"
@@ -156,6 +505,24 @@ void Normalize_ISPC(float3 *dst, size_t num)
     ispc::Normalize((ispc::float3*)dst, (int)num);
 }
 
+void TransformPoints_ISPC(float3 *dst, const float3 *src, const float4x4& m, size_t num)
+{
+    ispc::TransformPoints((ispc::float3*)dst, (const ispc::float3*)src, (const float*)&m, (int)num);
+}
+void TransformVectors_ISPC(float3 *dst, const float3 *src, const float4x4& m, size_t num)
+{
+    ispc::TransformVectors((ispc::float3*)dst, (const ispc::float3*)src, (const float*)&m, (int)num);
+}
+void TransformNormals_ISPC(float3 *dst, const float3 *src, const float4x4& m, size_t num)
+{
+    ispc::TransformNormals((ispc::float3*)dst, (const ispc::float3*)src, (const float*)&m, (int)num);
+}
+
+void GenerateFaceNormals_ISPC(float3 *dst, const float3 *points, const int *counts, const int *offsets, const int *indices, size_t num_faces)
+{
+    ispc::GenerateFaceNormals((ispc::float3*)dst, (const ispc::float3*)points, counts, offsets, indices, (int)num_faces);
+}
+
 void GenerateNormals_ISPC(
     float3 *dst, const float3 *p,
     const int *counts, const int *offsets, const int *indices, size_t num_points, size_t num_faces)
@@ -204,15 +571,55 @@ bool NearEqual_ISPC(const float *src1, const float *src2, size_t num, float eps)
 {
     return ispc::NearEqual(src1, src2, (int)num, eps);
 }
-#endif
 
+void Gather_ISPC(const GatherStream *streams, size_t num_streams, const int *indices, size_t num)
+{
+    int32_t *dsts[muMaxGatherStreams];
+    const int32_t *srcs[muMaxGatherStreams];
+    int32_t sizes[muMaxGatherStreams];
+
+    size_t si = 0;
+    while (si < num_streams) {
+        int n = 0;
+        for (; si < num_streams && n < muMaxGatherStreams; ++si) {
+            auto& s = streams[si];
+            if (!s.dst || !s.src) { continue; }
+            dsts[n] = (int32_t*)s.dst;
+            srcs[n] = (const int32_t*)s.src;
+            sizes[n] = s.size / 4;
+            ++n;
+        }
+        if (n > 0) {
+            ispc::Gather(dsts, srcs, sizes, n, indices, (int)num);
+        }
+    }
+}
 
+void PackWeights_ISPC(void *dst, const float *weights, const int *indices, int n, size_t num)
+{
+    if (n != 4 && n != 8) { return; }
+    ispc::PackWeights((int32_t*)dst, weights, indices, n, (int)num);
+}
+void UnpackWeights_ISPC(float *weights, int *indices, const void *src, int n, size_t num)
+{
+    if (n != 4 && n != 8) { return; }
+    ispc::UnpackWeights(weights, indices, (const int32_t*)src, n, (int)num);
+}
+#endif
 
 #ifdef muEnableISPC
     #define Forward(Name, ...) Name##_ISPC(__VA_ARGS__)
 #else
     #define Forward(Name, ...) Name##_Generic(__VA_ARGS__)
 #endif
+// for functions that have SSE versions
+#if defined(muEnableISPC)
+    #define ForwardSSE(Name, ...) Name##_ISPC(__VA_ARGS__)
+#elif defined(muEnableSSE)
+    #define ForwardSSE(Name, ...) Name##_SSE(__VA_ARGS__)
+#else
+    #define ForwardSSE(Name, ...) Name##_Generic(__VA_ARGS__)
+#endif
 
 #ifdef muEnableHalf
 void FloatToHalf(half *dst, const float *src, size_t num)
@@ -227,30 +634,54 @@ void HalfToFloat(float *dst, const half *src, size_t num)
 
 void InvertX(float3 *dst, size_t num)
 {
-    Forward(InvertX, dst, num);
+    ForwardSSE(InvertX, dst, num);
 }
 void InvertX(float4 *dst, size_t num)
 {
-    Forward(InvertX, dst, num);
+    ForwardSSE(InvertX, dst, num);
 }
 
 void Scale(float *dst, float s, size_t num)
 {
-    Forward(Scale, dst, s, num);
+    ForwardSSE(Scale, dst, s, num);
 }
 void Scale(float3 *dst, float s, size_t num)
 {
-    Forward(Scale, dst, s, num);
+    ForwardSSE(Scale, dst, s, num);
 }
 
 void Normalize(float3 *dst, size_t num)
 {
-    Forward(Normalize, dst, num);
+    ForwardSSE(Normalize, dst, num);
+}
+
+void TransformPoints(float3 *dst, const float3 *src, const float4x4& m, size_t num)
+{
+    ParallelForChunks(num, [&](size_t begin, size_t end) {
+        ForwardSSE(TransformPoints, dst + begin, src + begin, m, end - begin);
+    });
+}
+void TransformVectors(float3 *dst, const float3 *src, const float4x4& m, size_t num)
+{
+    ParallelForChunks(num, [&](size_t begin, size_t end) {
+        ForwardSSE(TransformVectors, dst + begin, src + begin, m, end - begin);
+    });
+}
+void TransformNormals(float3 *dst, const float3 *src, const float4x4& m, size_t num)
+{
+    ParallelForChunks(num, [&](size_t begin, size_t end) {
+        ForwardSSE(TransformNormals, dst + begin, src + begin, m, end - begin);
+    });
+}
+
+void GenerateFaceNormals(float3 *dst, const float3 *points, const int *counts, const int *offsets, const int *indices, size_t num_faces)
+{
+    ForwardSSE(GenerateFaceNormals, dst, points, counts, offsets, indices, num_faces);
 }
 
 void Lerp(float *dst, const float *src1, const float *src2, size_t num, float w)
 {
-    Forward(Lerp, dst, src1, src2, num, w);
+    ForwardSSE(Lerp, dst, src1, src2, num, w);
 }
 void Lerp(float2 *dst, const float2 *src1, const float2 *src2, size_t num, float w)
 {
@@ -273,12 +704,12 @@ float3 Max(const float3 *p, size_t num)
 
 void MinMax(const float3 *p, size_t num, float3& dst_min, float3& dst_max)
 {
-    Forward(MinMax, p, num, dst_min, dst_max);
+    ForwardSSE(MinMax, p, num, dst_min, dst_max);
 }
 
 bool NearEqual(const float *src1, const float *src2, size_t num, float eps)
 {
-    return Forward(NearEqual, src1, src2, num, eps);
+    return ForwardSSE(NearEqual, src1, src2, num, eps);
 }
 bool NearEqual(const float2 *src1, const float2 *src2, size_t num, float eps)
 {
@@ -289,6 +720,20 @@ bool NearEqual(const float3 *src1, const float3 *src2, size_t num, float eps)
     return NearEqual((const float*)src1, (const float*)src2, num * 3, eps);
 }
 
+void Gather(const GatherStream *streams, size_t num_streams, const int *indices, size_t num)
+{
+    Forward(Gather, streams, num_streams, indices, num);
+}
+
+void PackWeights(void *dst, const float *weights, const int *indices, int n, size_t num)
+{
+    Forward(PackWeights, dst, weights, indices, n, num);
+}
+void UnpackWeights(float *weights, int *indices, const void *src, int n, size_t num)
+{
+    Forward(UnpackWeights, weights, indices, src, n, num);
+}
+
 #undef Forward
 
 } // namespace mu
@@ -1,7 +1,21 @@
 #pragma once
 
+// SSE2 is always available on x86-64. functions that have hand-written SSE versions use them when ISPC is disabled.
+#if !defined(muDisableSSE) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+    #define muEnableSSE
+#endif
+
 namespace mu {
 
+// a stream for Gather(). dst[i] = src[indices[i]] for elements of size bytes.
+// size must be multiple of 4. streams with null dst or src are skipped.
+struct GatherStream
+{
+    void *dst;
+    const void *src;
+    int size;
+};
+
 #ifdef muEnableHalf
 void FloatToHalf(half *dst, const float *src, size_t num);
 void HalfToFloat(float *dst, const half *src, size_t num);
@@ -13,6 +27,15 @@ void InvertV(float2 *dst, size_t num);
 void Scale(float *dst, float s, size_t num);
 void Scale(float3 *dst, float s, size_t num);
 void Normalize(float3 *dst, size_t num);
+// transform float3 arrays by m. dst and src can be the same. large arrays are split into chunks and processed in parallel.
+// points are transformed as (x, y, z, 1) and vectors as (x, y, z, 0). no perspective divide.
+// TransformNormals() normalizes results of TransformVectors(). pass inverse transpose of m if it has non-uniform scale.
+void TransformPoints(float3 *dst, const float3 *src, const float4x4& m, size_t num);
+void TransformVectors(float3 *dst, const float3 *src, const float4x4& m, size_t num);
+void TransformNormals(float3 *dst, const float3 *src, const float4x4& m, size_t num);
+// dst[fi] = cross(p1 - p0, p2 - p0) of first triangle of each face. not normalized (weighted by area). zero if count < 3.
+// offsets are offset of each face in indices.
+void GenerateFaceNormals(float3 *dst, const float3 *points, const int *counts, const int *offsets, const int *indices, size_t num_faces);
 void Lerp(float *dst, const float *src1, const float *src2, size_t num, float w);
 void Lerp(float2 *dst, const float2 *src1, const float2 *src2, size_t num, float w);
 void Lerp(float3 *dst, const float3 *src1, const float3 *src2, size_t num, float w);
@@ -22,6 +45,12 @@ void MinMax(const float3 *src, size_t num, float3& dst_min, float3& dst_max);
 bool NearEqual(const float *src1, const float *src2, size_t num, float eps = muDefaultEpsilon);
 bool NearEqual(const float2 *src1, const float2 *src2, size_t num, float eps = muDefaultEpsilon);
 bool NearEqual(const float3 *src1, const float3 *src2, size_t num, float eps = muDefaultEpsilon);
+// gather multiple streams with one call. source elements are prefetched ahead.
+void Gather(const GatherStream *streams, size_t num_streams, const int *indices, size_t num);
+// flat arrays of bone weights and indices (n elements per vertex) <-> Weights<n> (n floats followed by n ints).
+// n must be 4 or 8.
+void PackWeights(void *dst, const float *weights, const int *indices, int n, size_t num);
+void UnpackWeights(float *weights, int *indices, const void *src, int n, size_t num);
 
 
 // ------------------------------------------------------------
@@ -36,19 +65,39 @@ void HalfToFloat_ISPC(float *dst, const half *src, size_t num);
 
 void InvertX_Generic(float3 *dst, size_t num);
 void InvertX_ISPC(float3 *dst, size_t num);
+void InvertX_SSE(float3 *dst, size_t num);
 void InvertX_Generic(float4 *dst, size_t num);
 void InvertX_ISPC(float4 *dst, size_t num);
+void InvertX_SSE(float4 *dst, size_t num);
 
 void Scale_Generic(float *dst, float s, size_t num);
 void Scale_Generic(float3 *dst, float s, size_t num);
 void Scale_ISPC(float *dst, float s, size_t num);
 void Scale_ISPC(float3 *dst, float s, size_t num);
+void Scale_SSE(float *dst, float s, size_t num);
+void Scale_SSE(float3 *dst, float s, size_t num);
 
 void Normalize_Generic(float3 *dst, size_t num);
 void Normalize_ISPC(float3 *dst, size_t num);
+void Normalize_SSE(float3 *dst, size_t num);
+
+void TransformPoints_Generic(float3 *dst, const float3 *src, const float4x4& m, size_t num);
+void TransformPoints_ISPC(float3 *dst, const float3 *src, const float4x4& m, size_t num);
+void TransformPoints_SSE(float3 *dst, const float3 *src, const float4x4& m, size_t num);
+void TransformVectors_Generic(float3 *dst, const float3 *src, const float4x4& m, size_t num);
+void TransformVectors_ISPC(float3 *dst, const float3 *src, const float4x4& m, size_t num);
+void TransformVectors_SSE(float3 *dst, const float3 *src, const float4x4& m, size_t num);
+void TransformNormals_Generic(float3 *dst, const float3 *src, const float4x4& m, size_t num);
+void TransformNormals_ISPC(float3 *dst, const float3 *src, const float4x4& m, size_t num);
+void TransformNormals_SSE(float3 *dst, const float3 *src, const float4x4& m, size_t num);
+
+void GenerateFaceNormals_Generic(float3 *dst, const float3 *points, const int *counts, const int *offsets, const int *indices, size_t num_faces);
+void GenerateFaceNormals_ISPC(float3 *dst, const float3 *points, const int *counts, const int *offsets, const int *indices, size_t num_faces);
+void GenerateFaceNormals_SSE(float3 *dst, const float3 *points, const int *counts, const int *offsets, const int *indices, size_t num_faces);
 
 void Lerp_Generic(float *dst, const float *src1, const float *src2, size_t num, float w);
 void Lerp_ISPC(float *dst, const float *src1, const float *src2, size_t num, float w);
+void Lerp_SSE(float *dst, const float *src1, const float *src2, size_t num, float w);
 
 float3 Min_Generic(const float3 *src, size_t num);
 float3 Min_ISPC(const float3 *src, size_t num);
@@ -58,8 +107,18 @@ float3 Max_ISPC(const float3 *src, size_t num);
 
 void MinMax_Generic(const float3 *src, size_t num, float3& dst_min, float3& dst_max);
 void MinMax_ISPC(const float3 *src, size_t num, float3& dst_min, float3& dst_max);
+void MinMax_SSE(const float3 *src, size_t num, float3& dst_min, float3& dst_max);
 
 bool NearEqual_Generic(const float *src1, const float *src2, size_t num, float eps);
 bool NearEqual_ISPC(const float *src1, const float *src2, size_t num, float eps);
+bool NearEqual_SSE(const float *src1, const float *src2, size_t num, float eps);
+
+void Gather_Generic(const GatherStream *streams, size_t num_streams, const int *indices, size_t num);
+void Gather_ISPC(const GatherStream *streams, size_t num_streams, const int *indices, size_t num);
+
+void PackWeights_Generic(void *dst, const float *weights, const int *indices, int n, size_t num);
+void PackWeights_ISPC(void *dst, const float *weights, const int *indices, int n, size_t num);
+void UnpackWeights_Generic(float *weights, int *indices, const void *src, int n, size_t num);
+void UnpackWeights_ISPC(float *weights, int *indices, const void *src, int n, size_t num);
 
 } // namespace mu
@@ -1,7 +1,9 @@
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <climits>
 #include <vector>
+#include <queue>
 #include <algorithm>
 #include <numeric>
 #ifdef muEnableHalf
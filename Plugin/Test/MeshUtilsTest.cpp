@@ -1,6 +1,9 @@
 #include <cstdio>
 #include <vector>
 #include <chrono>
+#include <cstring>
+#include <numeric>
+#include <tbb/tbb.h>
 #include "Mesh.h"
 using namespace mu;
 
@@ -27,6 +30,17 @@ inline bool near_equal(const std::vector<T>& a, const std::vector<T>& b, float e
     return true;
 }
 
+// number of elements that are not near equal
+template<class T>
+inline size_t count_not_near_equal(const std::vector<T>& a, const std::vector<T>& b, float epsilon = muDefaultEpsilon)
+{
+    size_t ret = 0;
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (!near_equal(a[i], b[i], epsilon)) { ++ret; }
+    }
+    return ret;
+}
+
 template<class T, size_t S>
 inline bool near_equal(const T (&a)[S], const T (&b)[S], float epsilon = muDefaultEpsilon)
 {
@@ -108,9 +122,11 @@ static void Test_InvertX()
 {
     auto data1 = GenerateFloat3Array(NumTestData, 0.1f, 1.0f);
     auto data2 = data1;
+    auto data3 = data1;
 
     ns elapsed1 = 0;
     ns elapsed2 = 0;
+    ns elapsed3 = 0;
     bool result = false;
 
     for (int i = 0; i < NumTry; ++i) {
@@ -124,13 +140,27 @@ static void Test_InvertX()
         elapsed2 += now() - start;
 #endif // muEnableISPC
 
-        result = near_equal(data1, data2);
+#ifdef muEnableSSE
+        start = now();
+        InvertX_SSE(data3.data(), data3.size());
+        elapsed3 += now() - start;
+#endif // muEnableSSE
+
+        // each implementation is validated against Generic on its own. data2 is untouched without ISPC.
+        result = true;
+#ifdef muEnableISPC
+        result = result && near_equal(data1, data2);
+#endif // muEnableISPC
+#ifdef muEnableSSE
+        result = result && near_equal(data1, data3);
+#endif // muEnableSSE
         if (!result) { break; }
     }
 
     printf("Test_InvertX: %s\n", result ? "succeeded" : "failed");
     printf("    InvertX_Generic(): avg. %f ms\n", float(elapsed1 / NumTry) / 1000000.0f);
     printf("    InvertX_ISPC(): avg. %f ms\n", float(elapsed2 / NumTry) / 1000000.0f);
+    printf("    InvertX_SSE(): avg. %f ms\n", float(elapsed3 / NumTry) / 1000000.0f);
     printf("\n");
 }
 
@@ -139,10 +169,12 @@ static void Test_Scale()
 {
     auto data1 = GenerateFloat3Array(NumTestData, 0.1f, 1.0f);
     auto data2 = data1;
+    auto data3 = data1;
     auto scale = 12.345f;
 
     ns elapsed1 = 0;
     ns elapsed2 = 0;
+    ns elapsed3 = 0;
     bool result = false;
 
     for (int i = 0; i < NumTry; ++i) {
@@ -156,13 +188,26 @@ static void Test_Scale()
         elapsed2 += now() - start;
 #endif // muEnableISPC
 
-        result = near_equal(data1, data2);
+#ifdef muEnableSSE
+        start = now();
+        Scale_SSE(data3.data(), scale, data3.size());
+        elapsed3 += now() - start;
+#endif // muEnableSSE
+
+        result = true;
+#ifdef muEnableISPC
+        result = result && near_equal(data1, data2);
+#endif // muEnableISPC
+#ifdef muEnableSSE
+        result = result && near_equal(data1, data3);
+#endif // muEnableSSE
         if (!result) { break; }
     }
 
     printf("Test_Scale: %s\n", result ? "succeeded" : "failed");
     printf("    Scale_Generic(): avg. %f ms\n", float(elapsed1 / NumTry) / 1000000.0f);
     printf("    Scale_ISPC(): avg. %f ms\n", float(elapsed2 / NumTry) / 1000000.0f);
+    printf("    Scale_SSE(): avg. %f ms\n", float(elapsed3 / NumTry) / 1000000.0f);
     printf("\n");
 }
 
@@ -172,9 +217,11 @@ static void Test_MinMax()
     auto data = GenerateFloat3Array(NumTestData, 0.1f, 1.0f);
     float3 bounds1[2];
     float3 bounds2[2];
+    float3 bounds3[2];
 
     ns elapsed1 = 0;
     ns elapsed2 = 0;
+    ns elapsed3 = 0;
     bool result = false;
 
     for (int i = 0; i < NumTry; ++i) {
@@ -188,13 +235,26 @@ static void Test_MinMax()
         elapsed2 += now() - start;
 #endif // muEnableISPC
 
-        result = near_equal(bounds1, bounds2);
+#ifdef muEnableSSE
+        start = now();
+        MinMax_SSE(data.data(), data.size(), bounds3[0], bounds3[1]);
+        elapsed3 += now() - start;
+#endif // muEnableSSE
+
+        result = true;
+#ifdef muEnableISPC
+        result = result && near_equal(bounds1, bounds2);
+#endif // muEnableISPC
+#ifdef muEnableSSE
+        result = result && near_equal(bounds1, bounds3);
+#endif // muEnableSSE
         if (!result) { break; }
     }
 
     printf("Test_MinMax: %s\n", result ? "succeeded" : "failed");
     printf("    MinMax_Generic(): avg. %f ms\n", float(elapsed1 / NumTry) / 1000000.0f);
     printf("    MinMax_ISPC(): avg. %f ms\n", float(elapsed2 / NumTry) / 1000000.0f);
+    printf("    MinMax_SSE(): avg. %f ms\n", float(elapsed3 / NumTry) / 1000000.0f);
     printf("\n");
 }
 
@@ -203,9 +263,11 @@ static void Test_Normalize()
 {
     auto data1 = GenerateFloat3Array(NumTestData, 0.1f, 1.0f);
     auto data2 = data1;
+    auto data3 = data1;
 
     ns elapsed1 = 0;
     ns elapsed2 = 0;
+    ns elapsed3 = 0;
     bool result = false;
 
     for (int i = 0; i < NumTry; ++i) {
@@ -219,13 +281,608 @@ static void Test_Normalize()
         elapsed2 += now() - start;
 #endif // muEnableISPC
 
-        result = near_equal(data1, data2);
+#ifdef muEnableSSE
+        start = now();
+        Normalize_SSE(data3.data(), data3.size());
+        elapsed3 += now() - start;
+#endif // muEnableSSE
+
+        result = true;
+#ifdef muEnableISPC
+        result = result && near_equal(data1, data2);
+#endif // muEnableISPC
+#ifdef muEnableSSE
+        result = result && near_equal(data1, data3);
+#endif // muEnableSSE
         if (!result) { break; }
     }
 
     printf("Test_Normalize: %s\n", result ? "succeeded" : "failed");
     printf("    Normalize_Generic(): avg. %f ms\n", float(elapsed1 / NumTry) / 1000000.0f);
     printf("    Normalize_ISPC(): avg. %f ms\n", float(elapsed2 / NumTry) / 1000000.0f);
+    printf("    Normalize_SSE(): avg. %f ms\n", float(elapsed3 / NumTry) / 1000000.0f);
+    printf("\n");
+}
+
+
+static void Test_Transform()
+{
+    auto src = GenerateFloat3Array(NumTestData, 0.1f, 1.0f);
+    std::vector<float3> dst1(src.size()), dst2(src.size()), dst3(src.size());
+    auto m = transform(float3{ 1.0f, 2.0f, 3.0f }, rotateXYZ(float3{ 0.3f, 0.6f, 0.9f }), float3{ 0.5f, 2.0f, 3.0f });
+
+    ns elapsed1 = 0;
+    ns elapsed2 = 0;
+    ns elapsed3 = 0;
+    bool result = false;
+
+    for (int i = 0; i < NumTry; ++i) {
+        auto start = now();
+        TransformPoints_Generic(dst1.data(), src.data(), m, src.size());
+        elapsed1 += now() - start;
+
+        // chunked and parallel
+        start = now();
+        TransformPoints(dst2.data(), src.data(), m, src.size());
+        elapsed2 += now() - start;
+        result = near_equal(dst1, dst2);
+
+#ifdef muEnableISPC
+        start = now();
+        TransformPoints_ISPC(dst3.data(), src.data(), m, src.size());
+        elapsed3 += now() - start;
+        result = result && near_equal(dst1, dst3);
+#endif // muEnableISPC
+
+        if (!result) { break; }
+    }
+
+    // vectors and normals. in-place (dst == src) must work too.
+    if (result) {
+        TransformVectors_Generic(dst1.data(), src.data(), m, src.size());
+        dst2 = src;
+        TransformVectors(dst2.data(), dst2.data(), m, dst2.size());
+        result = near_equal(dst1, dst2);
+
+        TransformNormals_Generic(dst1.data(), src.data(), m, src.size());
+        dst2 = src;
+        TransformNormals(dst2.data(), dst2.data(), m, dst2.size());
+        result = result && near_equal(dst1, dst2);
+    }
+#ifdef muEnableSSE
+    if (result) {
+        TransformPoints_Generic(dst1.data(), src.data(), m, src.size());
+        dst3 = src;
+        TransformPoints_SSE(dst3.data(), dst3.data(), m, dst3.size());
+        result = near_equal(dst1, dst3);
+
+        TransformVectors_Generic(dst1.data(), src.data(), m, src.size());
+        dst3 = src;
+        TransformVectors_SSE(dst3.data(), dst3.data(), m, dst3.size());
+        result = result && near_equal(dst1, dst3);
+
+        TransformNormals_Generic(dst1.data(), src.data(), m, src.size());
+        dst3 = src;
+        TransformNormals_SSE(dst3.data(), dst3.data(), m, dst3.size());
+        result = result && near_equal(dst1, dst3);
+    }
+#endif // muEnableSSE
+
+    printf("Test_Transform: %s\n", result ? "succeeded" : "failed");
+    printf("    TransformPoints_Generic(): avg. %f ms\n", float(elapsed1 / NumTry) / 1000000.0f);
+    printf("    TransformPoints(): avg. %f ms\n", float(elapsed2 / NumTry) / 1000000.0f);
+    printf("    TransformPoints_ISPC(): avg. %f ms\n", float(elapsed3 / NumTry) / 1000000.0f);
+    printf("\n");
+}
+
+
+static void Test_GenerateNormals()
+{
+    std::vector<int> counts, indices, offsets;
+    std::vector<float3> points;
+    std::vector<float2> uv;
+    GenerateWaveMesh(counts, indices, points, uv, 1.0f, 0.5f, 1024, 0.0f);
+    GenerateOffsets(offsets, counts);
+
+    std::vector<float3> normals1(points.size());
+    std::vector<float3> normals2(points.size());
+    std::vector<float3> normals3(points.size());
+    MeshConnectionInfo connection;
+
+    ns elapsed1 = 0;
+    ns elapsed2 = 0;
+    bool result = false;
+
+    for (int i = 0; i < NumTry; ++i) {
+        auto start = now();
+        GenerateNormals(normals1, points, counts, offsets, indices);
+        elapsed1 += now() - start;
+
+        // connection is built in first try and reused after that
+        start = now();
+        GenerateNormalsParallel(normals2, points, counts, offsets, indices, connection);
+        elapsed2 += now() - start;
+
+        // face normals may be computed with FMA in SIMD version
+        result = near_equal(normals1, normals2, 0.0001f);
+        if (!result) { break; }
+    }
+
+    // result must be exactly the same regardless of number of threads
+    if (result) {
+        tbb::task_arena single(1);
+        single.execute([&]() {
+            GenerateNormalsParallel(normals3, points, counts, offsets, indices, connection);
+        });
+        result = memcmp(normals2.data(), normals3.data(), sizeof(float3) * normals2.size()) == 0;
+    }
+#ifdef muEnableSSE
+    if (result) {
+        std::vector<float3> face_normals1(counts.size()), face_normals2(counts.size());
+        GenerateFaceNormals_Generic(face_normals1.data(), points.data(), counts.data(), offsets.data(), indices.data(), counts.size());
+        GenerateFaceNormals_SSE(face_normals2.data(), points.data(), counts.data(), offsets.data(), indices.data(), counts.size());
+        result = near_equal(face_normals1, face_normals2);
+    }
+#endif // muEnableSSE
+
+    printf("Test_GenerateNormals: %s\n", result ? "succeeded" : "failed");
+    printf("    GenerateNormals(): avg. %f ms\n", float(elapsed1 / NumTry) / 1000000.0f);
+    printf("    GenerateNormalsParallel(): avg. %f ms\n", float(elapsed2 / NumTry) / 1000000.0f);
+    printf("\n");
+}
+
+
+static void Test_SmoothingNormals()
+{
+    std::vector<int> counts, indices;
+    std::vector<float3> points;
+    std::vector<float2> uv;
+    GenerateWaveMesh(counts, indices, points, uv, 1.0f, 0.5f, 1024, 0.0f);
+
+    MeshRefiner refiner1, refiner2;
+
+    auto start = now();
+    refiner1.prepare(counts, indices, points);
+    refiner1.genNormals(60.0f);
+    ns elapsed = now() - start;
+
+    // connection and normals must be exactly the same regardless of number of threads
+    tbb::task_arena single(1);
+    single.execute([&]() {
+        refiner2.prepare(counts, indices, points);
+        refiner2.genNormals(60.0f);
+    });
+    bool result = refiner1.normals.size() == indices.size() &&
+        memcmp(refiner1.normals.data(), refiner2.normals.data(), sizeof(float3) * indices.size()) == 0;
+
+    printf("Test_SmoothingNormals: %s\n", result ? "succeeded" : "failed");
+    printf("    MeshRefiner::genNormals(60.0f): %f ms\n", float(elapsed) / 1000000.0f);
+    printf("\n");
+}
+
+
+static void Test_GenerateTangents()
+{
+    std::vector<int> counts, indices, offsets;
+    std::vector<float3> points;
+    std::vector<float2> uv;
+    GenerateWaveMesh(counts, indices, points, uv, 1.0f, 0.5f, 512, 0.0f);
+    GenerateOffsets(offsets, counts);
+
+    std::vector<float3> normals(points.size());
+    std::vector<float4> tangents1(points.size());
+    std::vector<float4> tangents2(points.size());
+    std::vector<float4> tangents3(points.size());
+    MeshConnectionInfo connection;
+    GenerateNormalsParallel(normals, points, counts, offsets, indices, connection);
+
+    auto start = now();
+    GenerateTangents(tangents1, points, normals, uv, counts, offsets, indices);
+    ns elapsed1 = now() - start;
+
+    start = now();
+    GenerateTangentsParallel(tangents2, points, normals, uv, counts, offsets, indices, connection);
+    ns elapsed2 = now() - start;
+
+    start = now();
+    GenerateTangentsFast(tangents3, points, normals, uv, counts, offsets, indices, connection);
+    ns elapsed3 = now() - start;
+
+    // parallel version must match MikkTSpace.
+    // fast version weights faces by UV gradients instead of corner angles. on this mesh it deviates by up to ~0.43,
+    // but only around the sharp peak at the center of the wave (80 of 262144 vertices deviate by more than 0.01).
+    // allow 0.1% of vertices to deviate by more than 0.01.
+    size_t num_deviated = count_not_near_equal(tangents1, tangents3, 0.01f);
+    bool result = near_equal(tangents1, tangents2, 0.001f) && num_deviated <= tangents1.size() / 1000;
+
+    printf("Test_GenerateTangents: %s\n", result ? "succeeded" : "failed");
+    printf("    GenerateTangentsFast(): %d of %d vertices deviate by more than 0.01\n", (int)num_deviated, (int)tangents1.size());
+    printf("    GenerateTangents(): %f ms\n", float(elapsed1) / 1000000.0f);
+    printf("    GenerateTangentsParallel(): %f ms\n", float(elapsed2) / 1000000.0f);
+    printf("    GenerateTangentsFast(): %f ms\n", float(elapsed3) / 1000000.0f);
+    printf("\n");
+}
+
+
+static void Test_SplitMesh()
+{
+    const int max_vertices = 64998;
+
+    std::vector<int> counts, indices, indices_triangulated;
+    std::vector<float3> points;
+    std::vector<float2> uv;
+    GenerateWaveMesh(counts, indices, points, uv, 1.0f, 0.5f, 512, 0.0f);
+
+    int num_indices, num_indices_triangulated;
+    std::vector<int> offsets;
+    CountIndices(counts, offsets, num_indices, num_indices_triangulated);
+    indices_triangulated.resize(num_indices_triangulated);
+    TriangulateWithIndices(indices_triangulated, counts, indices, false);
+
+    std::vector<MeshSplit> splits;
+    auto start = now();
+    SplitMesh(splits, counts, indices, indices_triangulated, points.size(), max_vertices);
+    ns elapsed = now() - start;
+
+    // remapped indices must point same vertices as original ones
+    bool result = true;
+    size_t total_vertices = 0;
+    int total_indices = 0;
+    for (auto& split : splits) {
+        if (split.vertices.size() > (size_t)max_vertices || split.indices.size() != (size_t)split.num_indices || split.index_begin != total_indices) {
+            result = false;
+            break;
+        }
+        for (int i = 0; i < split.num_indices; ++i) {
+            if (split.vertices[split.indices[i]] != indices_triangulated[split.index_begin + i]) {
+                result = false;
+                break;
+            }
+        }
+        total_vertices += split.vertices.size();
+        total_indices += split.num_indices;
+    }
+    result = result && total_indices == num_indices_triangulated;
+
+    printf("Test_SplitMesh: %s\n", result ? "succeeded" : "failed");
+    printf("    SplitMesh(): %f ms, %d splits, %d vertices (%d if flattened)\n",
+        float(elapsed) / 1000000.0f, (int)splits.size(), (int)total_vertices, num_indices_triangulated);
+    printf("\n");
+}
+
+
+static void Test_Simplify()
+{
+    const int num_lods = 4;
+    const float ratio = 0.5f;
+
+    std::vector<int> counts, indices, indices_triangulated;
+    std::vector<float3> points;
+    std::vector<float2> uv;
+    GenerateWaveMesh(counts, indices, points, uv, 1.0f, 0.5f, 256, 0.0f);
+
+    int num_indices, num_indices_triangulated;
+    std::vector<int> offsets;
+    CountIndices(counts, offsets, num_indices, num_indices_triangulated);
+    indices_triangulated.resize(num_indices_triangulated);
+    TriangulateWithIndices(indices_triangulated, counts, indices, false);
+
+    std::vector<float3> normals(points.size());
+    GenerateNormals(normals, points, counts, offsets, indices);
+
+    MeshSimplifier simplifier;
+    simplifier.prepare(indices_triangulated, points);
+    simplifier.normals = normals;
+    simplifier.uv = uv;
+
+    std::vector<MeshLOD> lods;
+    auto start = now();
+    bool result = simplifier.simplify(lods, num_lods, ratio);
+    ns elapsed = now() - start;
+
+    // each level must be a valid mesh made of original vertices, have about the target number of triangles,
+    // and keep bounds of the original (boundary is preserved).
+    float3 bmin, bmax;
+    MinMax(points.data(), points.size(), bmin, bmax);
+    float target = float(num_indices_triangulated / 3);
+    result = result && lods.size() == num_lods;
+    for (size_t li = 0; li < lods.size() && result; ++li) {
+        auto& lod = lods[li];
+        target *= ratio;
+        int num_triangles = int(lod.indices.size() / 3);
+        result = result && num_triangles <= int(target) && num_triangles >= int(target) - 2;
+
+        std::vector<float3> lod_points;
+        for (int vi : lod.vertices) {
+            result = result && vi >= 0 && vi < (int)points.size();
+            if (result) { lod_points.push_back(points[vi]); }
+        }
+        for (int i : lod.indices) {
+            result = result && i >= 0 && i < (int)lod.vertices.size();
+        }
+
+        float3 lmin, lmax;
+        MinMax(lod_points.data(), lod_points.size(), lmin, lmax);
+        result = result && lmin.x == bmin.x && lmin.z == bmin.z && lmax.x == bmax.x && lmax.z == bmax.z;
+        printf("    LOD %d: %d triangles, %d vertices\n", int(li + 1), num_triangles, (int)lod.vertices.size());
+    }
+
+    // bone weights. Weights8 that have the same influences as Weights4 must give the same result.
+    if (result) {
+        std::vector<Weights4> weights4(points.size());
+        std::vector<Weights8> weights8(points.size());
+        for (size_t vi = 0; vi < points.size(); ++vi) {
+            float w = std::min(std::max(points[vi].x + 0.5f, 0.0f), 1.0f);
+            weights4[vi].indices[0] = 0; weights4[vi].weights[0] = w;
+            weights4[vi].indices[1] = 1; weights4[vi].weights[1] = 1.0f - w;
+            for (int i = 0; i < 4; ++i) {
+                weights8[vi].indices[i] = weights4[vi].indices[i];
+                weights8[vi].weights[i] = weights4[vi].weights[i];
+            }
+        }
+
+        std::vector<MeshLOD> lods4, lods8;
+        simplifier.weights4 = weights4;
+        result = result && simplifier.simplify(lods4, num_lods, ratio);
+        simplifier.weights4.reset(nullptr, 0);
+        simplifier.weights8 = weights8;
+        result = result && simplifier.simplify(lods8, num_lods, ratio);
+        result = result && lods4.size() == lods8.size();
+        for (size_t li = 0; li < lods4.size() && result; ++li) {
+            auto& l4 = lods4[li];
+            auto& l8 = lods8[li];
+            result = l4.vertices.size() == l8.vertices.size() && l4.indices.size() == l8.indices.size() &&
+                std::equal(l4.vertices.begin(), l4.vertices.end(), l8.vertices.begin()) &&
+                std::equal(l4.indices.begin(), l4.indices.end(), l8.indices.begin());
+        }
+    }
+
+    printf("Test_Simplify: %s\n", result ? "succeeded" : "failed");
+    printf("    MeshSimplifier::simplify(): %f ms, %d triangles\n",
+        float(elapsed) / 1000000.0f, num_indices_triangulated / 3);
+    printf("\n");
+}
+
+
+static void Test_Triangulate()
+{
+    std::vector<int> counts_quad, indices_quad;
+    std::vector<float3> points;
+    std::vector<float2> uv;
+    GenerateWaveMesh(counts_quad, indices_quad, points, uv, 1.0f, 0.5f, 1024, 0.0f);
+
+    // mixed n-gons (including degenerate ones) and triangles made from the quad mesh
+    std::vector<int> counts_mixed, counts_tri(counts_quad.size() * 2, 3), indices_tri;
+    for (size_t fi = 0; fi < counts_quad.size(); ++fi) {
+        counts_mixed.push_back(int(fi % 7));
+    }
+    counts_mixed.push_back(int(indices_quad.size() - std::accumulate(counts_mixed.begin(), counts_mixed.end(), 0)));
+    for (size_t fi = 0; fi < counts_quad.size(); ++fi) {
+        const int *q = &indices_quad[fi * 4];
+        int t[] = { q[0], q[1], q[2], q[0], q[2], q[3] };
+        indices_tri.insert(indices_tri.end(), t, t + 6);
+    }
+
+    struct Case { const char *name; std::vector<int> *counts, *indices; };
+    Case cases[] = {
+        { "mixed", &counts_mixed, &indices_quad },
+        { "quads", &counts_quad, &indices_quad },
+        { "triangles", &counts_tri, &indices_tri },
+    };
+
+    bool result = true;
+    for (auto& c : cases) {
+        auto& counts = *c.counts;
+        auto& indices = *c.indices;
+
+        int num_indices1, num_indices_triangulated1, num_indices2, num_indices_triangulated2;
+        std::vector<int> offsets1, offsets2(counts.size());
+        CountIndices(counts, offsets1, num_indices1, num_indices_triangulated1);
+        CountIndicesParallel(counts, offsets2, num_indices2, num_indices_triangulated2);
+        result = result && offsets1 == offsets2 &&
+            num_indices1 == num_indices2 && num_indices_triangulated1 == num_indices_triangulated2;
+
+        ns elapsed1 = 0, elapsed2 = 0;
+        for (int swap = 0; swap < 2 && result; ++swap) {
+            std::vector<int> dst1(num_indices_triangulated1), dst2(num_indices_triangulated1);
+
+            auto start = now();
+            TriangulateWithIndices(dst1, counts, indices, swap != 0);
+            elapsed1 += now() - start;
+
+            start = now();
+            TriangulateParallel(dst2, counts, indices, swap != 0);
+            elapsed2 += now() - start;
+            result = result && dst1 == dst2;
+
+            Triangulate(dst1, counts, swap != 0);
+            TriangulateParallel(dst2, counts, IArray<int>(), swap != 0);
+            result = result && dst1 == dst2;
+        }
+        printf("    TriangulateWithIndices() (%s): avg. %f ms\n", c.name, float(elapsed1 / 2) / 1000000.0f);
+        printf("    TriangulateParallel() (%s): avg. %f ms\n", c.name, float(elapsed2 / 2) / 1000000.0f);
+
+        // chunked paths are taken only if multiple threads are available. force them to be tested on any machine.
+        tbb::task_arena arena(4);
+        arena.execute([&]() {
+            int num_indices3, num_indices_triangulated3;
+            std::vector<int> offsets3(counts.size());
+            CountIndicesParallel(counts, offsets3, num_indices3, num_indices_triangulated3);
+            result = result && offsets1 == offsets3 &&
+                num_indices1 == num_indices3 && num_indices_triangulated1 == num_indices_triangulated3;
+
+            std::vector<int> dst1(num_indices_triangulated1), dst3(num_indices_triangulated1);
+            for (int swap = 0; swap < 2 && result; ++swap) {
+                TriangulateWithIndices(dst1, counts, indices, swap != 0);
+                TriangulateParallel(dst3, counts, indices, swap != 0);
+                result = result && dst1 == dst3;
+
+                Triangulate(dst1, counts, swap != 0);
+                TriangulateParallel(dst3, counts, IArray<int>(), swap != 0);
+                result = result && dst1 == dst3;
+            }
+        });
+    }
+
+    printf("Test_Triangulate: %s\n", result ? "succeeded" : "failed");
+    printf("\n");
+}
+
+
+static void Test_Gather()
+{
+    std::vector<int> counts, indices;
+    std::vector<float3> points;
+    std::vector<float2> uv;
+    GenerateWaveMesh(counts, indices, points, uv, 1.0f, 0.5f, 512, 0.0f);
+    size_t num = indices.size();
+
+    std::vector<float4> tangents(points.size());
+    std::vector<Weights4> weights(points.size());
+    for (size_t i = 0; i < points.size(); ++i) {
+        tangents[i] = { points[i].x, points[i].y, points[i].z, 1.0f };
+        weights[i].indices[0] = (int)i;
+        weights[i].weights[0] = 1.0f;
+    }
+
+    // reference: one CopyWithIndices() per stream
+    std::vector<float3> points1(num), points2(num);
+    std::vector<float2> uv1(num), uv2(num);
+    std::vector<float4> tangents1(num), tangents2(num);
+    std::vector<Weights4> weights1(num), weights2(num);
+    auto start = now();
+    CopyWithIndices(points1.data(), points.data(), indices);
+    CopyWithIndices(uv1.data(), uv.data(), indices);
+    CopyWithIndices(tangents1.data(), tangents.data(), indices);
+    CopyWithIndices(weights1.data(), weights.data(), indices);
+    ns elapsed1 = now() - start;
+
+    GatherStream streams[] = {
+        { points2.data(), points.data(), sizeof(float3) },
+        { uv2.data(), uv.data(), sizeof(float2) },
+        { tangents2.data(), tangents.data(), sizeof(float4) },
+        { weights2.data(), weights.data(), sizeof(Weights4) },
+    };
+    const size_t num_streams = sizeof(streams) / sizeof(streams[0]);
+    auto check = [&]() {
+        return memcmp(points1.data(), points2.data(), sizeof(float3) * num) == 0 &&
+            memcmp(uv1.data(), uv2.data(), sizeof(float2) * num) == 0 &&
+            memcmp(tangents1.data(), tangents2.data(), sizeof(float4) * num) == 0 &&
+            memcmp(weights1.data(), weights2.data(), sizeof(Weights4) * num) == 0;
+    };
+
+    start = now();
+    Gather_Generic(streams, num_streams, indices.data(), num);
+    ns elapsed2 = now() - start;
+    bool result = check();
+
+    ns elapsed3 = 0;
+#ifdef muEnableISPC
+    points2.assign(num, float3::zero());
+    start = now();
+    Gather_ISPC(streams, num_streams, indices.data(), num);
+    elapsed3 = now() - start;
+    result = result && check();
+#endif // muEnableISPC
+
+    points2.assign(num, float3::zero());
+    start = now();
+    GatherParallel(streams, num_streams, indices.data(), num);
+    ns elapsed4 = now() - start;
+    result = result && check();
+
+    printf("Test_Gather: %s\n", result ? "succeeded" : "failed");
+    printf("    CopyWithIndices() x4: %f ms\n", float(elapsed1) / 1000000.0f);
+    printf("    Gather_Generic(): %f ms\n", float(elapsed2) / 1000000.0f);
+    printf("    Gather_ISPC(): %f ms\n", float(elapsed3) / 1000000.0f);
+    printf("    GatherParallel(): %f ms\n", float(elapsed4) / 1000000.0f);
+    printf("\n");
+}
+
+
+static void Test_Weights()
+{
+    const int num = 100000;
+    const int bpv = 8;
+
+    // 8 influences per vertex with distinct weights
+    std::vector<int> bone_indices(num * bpv);
+    std::vector<float> bone_weights(num * bpv);
+    for (int i = 0; i < num * bpv; ++i) {
+        bone_indices[i] = (i * 7) % 61;
+        bone_weights[i] = float((i * 13) % 97 + 1) / 97.0f;
+    }
+
+    // reference: scalar transposition and nth_element() selection
+    std::vector<Weights8> weights8_ref(num);
+    std::vector<Weights4> weights4_ref(num);
+    auto start = now();
+    for (int wi = 0; wi < num; ++wi) {
+        for (int i = 0; i < bpv; ++i) {
+            weights8_ref[wi].weights[i] = bone_weights[wi * bpv + i];
+            weights8_ref[wi].indices[i] = bone_indices[wi * bpv + i];
+        }
+    }
+    ns elapsed1 = now() - start;
+
+    start = now();
+    for (int wi = 0; wi < num; ++wi) {
+        const float *w = &bone_weights[wi * bpv];
+        int order[bpv];
+        std::iota(order, order + bpv, 0);
+        std::nth_element(order, order + 4, order + bpv, [&](int a, int b) { return w[a] > w[b]; });
+        std::sort(order, order + 4, [&](int a, int b) { return w[a] > w[b]; });
+        float total = 0.0f;
+        for (int i = 0; i < 4; ++i) { total += w[order[i]]; }
+        for (int i = 0; i < 4; ++i) {
+            weights4_ref[wi].weights[i] = w[order[i]] / total;
+            weights4_ref[wi].indices[i] = bone_indices[wi * bpv + order[i]];
+        }
+    }
+    ns elapsed2 = now() - start;
+
+    std::vector<Weights8> weights8(num);
+    std::vector<Weights4> weights4(num), weights4c(num);
+    start = now();
+    bool result = GenerateWeightsN<8>(weights8, bone_indices, bone_weights, bpv);
+    ns elapsed3 = now() - start;
+    result = result && memcmp(weights8.data(), weights8_ref.data(), sizeof(Weights8) * num) == 0;
+
+    start = now();
+    result = result && GenerateWeightsN<4>(weights4, bone_indices, bone_weights, bpv);
+    ns elapsed4 = now() - start;
+    result = result && ConvertWeights<4, 8>(weights4c, weights8);
+    for (int wi = 0; wi < num && result; ++wi) {
+        for (int i = 0; i < 4; ++i) {
+            result = result &&
+                weights4[wi].indices[i] == weights4_ref[wi].indices[i] &&
+                near_equal(weights4[wi].weights[i], weights4_ref[wi].weights[i]);
+        }
+    }
+    result = result && memcmp(weights4.data(), weights4c.data(), sizeof(Weights4) * num) == 0;
+
+    // Weights8 -> flat arrays must give back the source
+    std::vector<int> bone_indices2(num * bpv);
+    std::vector<float> bone_weights2(num * bpv);
+    start = now();
+    result = result && FlattenWeightsN<8>(bone_indices2, bone_weights2, weights8);
+    ns elapsed5 = now() - start;
+    result = result && bone_indices == bone_indices2 && bone_weights == bone_weights2;
+
+#ifdef muEnableISPC
+    std::vector<Weights8> weights8_ispc(num);
+    PackWeights_ISPC(weights8_ispc.data(), bone_weights.data(), bone_indices.data(), 8, num);
+    result = result && memcmp(weights8_ispc.data(), weights8_ref.data(), sizeof(Weights8) * num) == 0;
+    UnpackWeights_ISPC(bone_weights2.data(), bone_indices2.data(), weights8_ispc.data(), 8, num);
+    result = result && bone_indices == bone_indices2 && bone_weights == bone_weights2;
+#endif // muEnableISPC
+
+    printf("Test_Weights: %s\n", result ? "succeeded" : "failed");
+    printf("    transposition (scalar): %f ms\n", float(elapsed1) / 1000000.0f);
+    printf("    top 4 selection (nth_element): %f ms\n", float(elapsed2) / 1000000.0f);
+    printf("    GenerateWeightsN<8>(): %f ms\n", float(elapsed3) / 1000000.0f);
+    printf("    GenerateWeightsN<4>(): %f ms\n", float(elapsed4) / 1000000.0f);
+    printf("    FlattenWeightsN<8>(): %f ms\n", float(elapsed5) / 1000000.0f);
     printf("\n");
 }
 
@@ -308,5 +965,14 @@ void MeshUtilsTest()
     Test_Scale();
     Test_MinMax();
     Test_Normalize();
+    Test_Transform();
+    Test_GenerateNormals();
+    Test_SmoothingNormals();
+    Test_GenerateTangents();
+    Test_SplitMesh();
+    Test_Simplify();
+    Test_Triangulate();
+    Test_Gather();
+    Test_Weights();
     Test_Interleave();
 }
@@ -0,0 +1,96 @@
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "Mesh.h"
+
+using usdi::Weights8;
+
+// export a skinned mesh with 8 weights per vertex, bake it and compare samples read from the cache with ones read from the stage
+bool TestBake(const char *usd_path, const char *bake_path)
+{
+    std::vector<int> counts, indices;
+    std::vector<float3> points;
+    std::vector<float2> uv;
+    std::vector<Weights8> weights;
+    GenerateCylinderMesh(counts, indices, points, uv, 0.2f, 5.0f, 16, 8);
+    weights.resize(points.size());
+    for (size_t i = 0; i < points.size(); ++i) {
+        auto& w = weights[i];
+        for (int j = 0; j < 8; ++j) {
+            w.indices[j] = int(i + j) % 13;
+            w.weight[j] = float(8 - j) / 36.0f;
+        }
+    }
+
+    {
+        auto *ctx = usdiCreateContext();
+        usdiCreateStage(ctx, usd_path);
+        auto *xf = usdiCreateXform(ctx, usdiGetRoot(ctx), "BakeTest");
+        usdi::XformData xd;
+        usdiXformWriteSample(xf, &xd);
+
+        usdi::MeshData data;
+        data.num_counts = (uint)counts.size();
+        data.num_indices = (uint)indices.size();
+        data.num_points = (uint)points.size();
+        data.counts = counts.data();
+        data.indices = indices.data();
+        data.points = points.data();
+        data.uvs = uv.data();
+        data.max_bone_weights = 8;
+        data.weights8 = weights.data();
+        auto *mesh = usdiCreateMesh(ctx, xf, "Mesh");
+        usdiMeshWriteSample(mesh, &data);
+        usdiSave(ctx);
+        usdiDestroyContext(ctx);
+    }
+
+    bool result = false;
+    auto *ctx = usdiCreateContext();
+    if (usdiOpen(ctx, usd_path)) {
+        auto *mesh = usdiAsMesh(usdiFindSchema(ctx, "/BakeTest/Mesh"));
+        usdiUpdateAllSamples(ctx, 0.0);
+
+        // copy samples from the stage before the cache takes over
+        usdi::MeshData src;
+        std::vector<float3> src_points;
+        std::vector<Weights8> src_weights;
+        if (mesh && usdiMeshReadSample(mesh, &src, 0.0, false) && src.max_bone_weights == 8 && src.weights8) {
+            src_points.assign(src.points, src.points + src.num_points);
+            src_weights.assign(src.weights8, src.weights8 + src.num_points);
+        }
+
+        if (!src_weights.empty() && usdiBake(ctx, bake_path, nullptr, 0) && usdiOpenBakedCache(ctx, bake_path)) {
+            usdi::MeshData baked;
+            result = usdiMeshReadSample(mesh, &baked, 0.0, false) &&
+                baked.max_bone_weights == 8 && baked.weights8 &&
+                baked.num_points == (uint)src_points.size() &&
+                memcmp(baked.points, src_points.data(), sizeof(float3) * src_points.size()) == 0 &&
+                memcmp(baked.weights8, src_weights.data(), sizeof(Weights8) * src_weights.size()) == 0;
+        }
+        usdiCloseBakedCache(ctx);
+    }
+
+    // truncated cache must be rejected
+    if (result) {
+        std::vector<char> buf;
+        if (FILE *f = fopen(bake_path, "rb")) {
+            fseek(f, 0, SEEK_END);
+            buf.resize((size_t)ftell(f));
+            fseek(f, 0, SEEK_SET);
+            result = fread(buf.data(), 1, buf.size(), f) == buf.size();
+            fclose(f);
+        }
+        std::string truncated_path = std::string(bake_path) + ".truncated";
+        if (FILE *f = fopen(truncated_path.c_str(), "wb")) {
+            fwrite(buf.data(), 1, buf.size() / 2, f);
+            fclose(f);
+        }
+        result = result && !usdiOpenBakedCache(ctx, truncated_path.c_str());
+    }
+    usdiDestroyContext(ctx);
+
+    printf("TestBake: %s\n", result ? "succeeded" : "failed");
+    return result;
+}
@@ -7,6 +7,7 @@ void TestExportHighMesh(const char *filename, int frame_count);
 void TestExportSkinnedMesh(const char *filename, int cseg, int hseg);
 void TestExportReference(const char *filename, const char *flatten);
 bool TestImport(const char *path);
+bool TestBake(const char *usd_path, const char *bake_path);
 
 extern "C" {
 
@@ -23,6 +24,7 @@ testsAPI void TestMain(int argc, char *argv[])
     TestExportReference("TestReference.usda", "Flatten.usda");
     TestImport("TestExport.usda");
     TestImport("TestReference.usda");
+    TestBake("TestBake.usda", "TestBake.usdibake");
 }
 
 } // extern "C"
@@ -197,6 +197,21 @@ usdiAPI void usdiMeshAssignBones(usdi::Mesh *mesh, usdi::MeshData *dst, const ch
     if (!mesh || !dst) { return; }
     mesh->assignBones(*dst, v, n);
 }
+usdiAPI void usdiTransformPoints(usdi::float3 *dst, const usdi::float3 *src, int num, const usdi::float4x4 *m)
+{
+    if (!dst || !src || !m || num <= 0) { return; }
+    mu::TransformPoints((mu::float3*)dst, (const mu::float3*)src, (const mu::float4x4&)*m, num);
+}
+usdiAPI void usdiTransformVectors(usdi::float3 *dst, const usdi::float3 *src, int num, const usdi::float4x4 *m)
+{
+    if (!dst || !src || !m || num <= 0) { return; }
+    mu::TransformVectors((mu::float3*)dst, (const mu::float3*)src, (const mu::float4x4&)*m, num);
+}
+usdiAPI void usdiTransformNormals(usdi::float3 *dst, const usdi::float3 *src, int num, const usdi::float4x4 *m)
+{
+    if (!dst || !src || !m || num <= 0) { return; }
+    mu::TransformNormals((mu::float3*)dst, (const mu::float3*)src, (const mu::float4x4&)*m, num);
+}
 
 } // extern "C"
 #endif // usdiEnableUnityExtension
@@ -41,5 +41,10 @@ usdiAPI int             usdiMemcmp(const void *a, const void *b, int size);
 usdiAPI const char*     usdiIndexStringArray(const char **v, int i);
 usdiAPI void            usdiMeshAssignRootBone(usdi::Mesh *mesh, usdi::MeshData *dst, const char *v);
 usdiAPI void            usdiMeshAssignBones(usdi::Mesh *mesh, usdi::MeshData *dst, const char **v, int n);
+// batch version of Matrix4x4.MultiplyPoint3x4() / MultiplyVector(). dst and src can be the same.
+// usdiTransformNormals() normalizes results. pass inverse transpose of the matrix if it has non-uniform scale.
+usdiAPI void            usdiTransformPoints(usdi::float3 *dst, const usdi::float3 *src, int num, const usdi::float4x4 *m);
+usdiAPI void            usdiTransformVectors(usdi::float3 *dst, const usdi::float3 *src, int num, const usdi::float4x4 *m);
+usdiAPI void            usdiTransformNormals(usdi::float3 *dst, const usdi::float3 *src, int num, const usdi::float4x4 *m);
 
 } // extern "C"
@@ -68,7 +68,7 @@ void VertexUpdateCommand::update(const usdi::SubmeshData *data, void *vb, void *
     m_tangents      = data->tangents;
     m_indices       = data->indices;
     m_num_points    = data->num_points;
-    m_num_indices   = data->num_points; // num points == num indices on submesh
+    m_num_indices   = data->num_indices;
 
     m_ctx_vb.resource = vb;
     m_ctx_ib.resource = ib;
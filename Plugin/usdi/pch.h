@@ -27,11 +27,15 @@
 
 #include <vector>
 #include <string>
+#include <list>
 #include <map>
+#include <unordered_map>
+#include <unordered_set>
 #include <memory>
 #include <algorithm>
 #include <thread>
 #include <mutex>
+#include <condition_variable>
 #include <future>
 #include <functional>
 #include <atomic>
@@ -39,11 +43,13 @@
 #include <cmath>
 #include <cctype>
 #include <type_traits>
+#include <typeinfo>
 #ifdef usdiEnableBoostFilesystem
     #include <boost/filesystem.hpp>
 #else
     #include <experimental/filesystem>
 #endif
+#define TBB_PREVIEW_LOCAL_OBSERVER 1 // for per-arena task_scheduler_observer in older TBB
 #include <tbb/tbb.h>
 
 #pragma warning(push)
@@ -53,8 +59,12 @@
 #include "pxr/usd/usd/timeCode.h"
 #include "pxr/usd/usd/variantSets.h"
 #include "pxr/usd/usd/stage.h"
+#include "pxr/usd/usd/stagePopulationMask.h"
+#include "pxr/usd/usd/notice.h"
+#include "pxr/base/tf/weakBase.h"
 #include "pxr/usd/usdGeom/xform.h"
 #include "pxr/usd/usdGeom/xformCommonAPI.h"
+#include "pxr/usd/usdGeom/xformCache.h"
 #include "pxr/usd/usdGeom/camera.h"
 #include "pxr/usd/usdGeom/mesh.h"
 #include "pxr/usd/usdGeom/points.h"
@@ -63,6 +73,10 @@
 #include "pxr/base/gf/matrix3f.h"
 #include "pxr/base/gf/matrix4f.h"
 #include "pxr/usd/ar/resolver.h"
+#include "pxr/usd/ar/resolverContextBinder.h"
+#include "pxr/usd/ar/resolverScopedCache.h"
+#include "pxr/usd/ar/defaultResolverContext.h"
+#include "pxr/usd/sdf/layerUtils.h"
 #include "pxr/usd/sdf/fileFormat.h"
 #include "half.h"
 #pragma warning(pop)
@@ -7,6 +7,9 @@
 #include "usdiMesh.h"
 #include "usdiPoints.h"
 #include "usdiContext.h"
+#include "usdiPayloadManager.h"
+#include "usdiOpenTask.h"
+#include "usdiBakedCache.h"
 
 
 #ifdef _WIN32
@@ -89,6 +92,18 @@ usdiAPI void usdiDestroyContext(usdi::Context *ctx)
     usdiTraceFunc();
     delete ctx;
 }
+usdiAPI void usdiContextAddAssetSearchPath(usdi::Context *ctx, const char *path)
+{
+    usdiTraceFunc();
+    if (!ctx) return;
+    ctx->addSearchPath(path);
+}
+usdiAPI void usdiContextClearAssetSearchPath(usdi::Context *ctx)
+{
+    usdiTraceFunc();
+    if (!ctx) return;
+    ctx->clearSearchPaths();
+}
 
 usdiAPI bool usdiOpen(usdi::Context *ctx, const char *path)
 {
@@ -97,6 +112,56 @@ usdiAPI bool usdiOpen(usdi::Context *ctx, const char *path)
     return ctx->open(path);
 }
 
+usdiAPI bool usdiOpenWithSettings(usdi::Context *ctx, const char *path, const usdi::OpenSettings *settings)
+{
+    usdiTraceFunc();
+    if (!ctx || !path) return false;
+    return settings ? ctx->open(path, *settings) : ctx->open(path);
+}
+
+usdiAPI usdi::OpenTask* usdiOpenAsync(usdi::Context *ctx, const char *path, const usdi::OpenSettings *settings)
+{
+    usdiTraceFunc();
+    if (!ctx || !path) return nullptr;
+    auto *ret = new usdi::OpenTask(ctx, path, settings);
+    ret->start();
+    return ret;
+}
+
+usdiAPI void usdiOpenTaskGetProgress(usdi::OpenTask *task, usdi::OpenProgress *dst)
+{
+    usdiTraceFunc();
+    if (!task || !dst) return;
+    task->getProgress(*dst);
+}
+
+usdiAPI usdi::Schema* usdiOpenTaskGetCompletedSubtree(usdi::OpenTask *task, int i)
+{
+    usdiTraceFunc();
+    if (!task) return nullptr;
+    return task->getCompletedSubtree(i);
+}
+
+usdiAPI void usdiOpenTaskCancel(usdi::OpenTask *task)
+{
+    usdiTraceFunc();
+    if (!task) return;
+    task->cancel();
+}
+
+usdiAPI bool usdiOpenTaskWait(usdi::OpenTask *task)
+{
+    usdiTraceFunc();
+    if (!task) return false;
+    return task->wait();
+}
+
+usdiAPI void usdiOpenTaskRelease(usdi::OpenTask *task)
+{
+    usdiTraceFunc();
+    delete task;
+}
+
 usdiAPI bool usdiCreateStage(usdi::Context *ctx, const char *path)
 {
     usdiTraceFunc();
@@ -130,6 +195,18 @@ usdiAPI void usdiGetImportSettings(usdi::Context *ctx, usdi::ImportSettings *v)
     if (!ctx || !v) return;
     *v = ctx->getImportSettings();
 }
+usdiAPI void usdiSetConcurrencySettings(usdi::Context *ctx, const usdi::ConcurrencySettings *v)
+{
+    usdiTraceFunc();
+    if (!ctx || !v) return;
+    ctx->setConcurrencySettings(*v);
+}
+usdiAPI void usdiGetConcurrencySettings(usdi::Context *ctx, usdi::ConcurrencySettings *v)
+{
+    usdiTraceFunc();
+    if (!ctx || !v) return;
+    *v = ctx->getConcurrencySettings();
+}
 usdiAPI void usdiSetExportSettings(usdi::Context *ctx, const usdi::ExportSettings *v)
 {
     usdiTraceFunc();
@@ -239,6 +316,49 @@ usdiAPI void usdiRebuildSchemaTree(usdi::Context *ctx)
     if (!ctx) return;
     ctx->rebuildSchemaTree();
 }
+usdiAPI void usdiSetPayloadCameraPosition(usdi::Context *ctx, const usdi::float3 *pos)
+{
+    usdiTraceFunc();
+    if (!ctx || !pos) return;
+    if (auto *pm = ctx->getPayloadManager()) { pm->setCameraPosition(*pos); }
+}
+usdiAPI void usdiSetPayloadMemoryBudget(usdi::Context *ctx, uint64_t size)
+{
+    usdiTraceFunc();
+    if (!ctx) return;
+    if (auto *pm = ctx->getPayloadManager()) { pm->setMemoryBudget((size_t)size); }
+}
+usdiAPI void usdiLoadAllPayloadsAsync(usdi::Context *ctx)
+{
+    usdiTraceFunc();
+    if (!ctx) return;
+    if (auto *pm = ctx->getPayloadManager()) { pm->requestLoadAll(); }
+}
+usdiAPI int usdiGetNumPendingPayloads(usdi::Context *ctx)
+{
+    usdiTraceFunc();
+    if (!ctx) return 0;
+    auto *pm = ctx->getPayloadManager();
+    return pm ? pm->getNumPending() : 0;
+}
+usdiAPI bool usdiBake(usdi::Context *ctx, const char *path, const usdi::Time *times, int num_times)
+{
+    usdiTraceFunc();
+    if (!ctx) return false;
+    return ctx->bake(path, times, num_times);
+}
+usdiAPI bool usdiOpenBakedCache(usdi::Context *ctx, const char *path)
+{
+    usdiTraceFunc();
+    if (!ctx) return false;
+    return ctx->openBakedCache(path);
+}
+usdiAPI void usdiCloseBakedCache(usdi::Context *ctx)
+{
+    usdiTraceFunc();
+    if (!ctx) return;
+    ctx->closeBakedCache();
+}
 usdiAPI void usdiPreComputeNormalsAll(usdi::Context *ctx, bool gen_tangents, bool overwrite, usdiPreComputeNormalsCallback cb)
 {
     usdiTraceFunc();
@@ -418,6 +538,18 @@ usdiAPI void usdiPrimUnloadPayload(usdi::Schema *schema)
     if (!schema) { return; }
     schema->unloadPayload();
 }
+usdiAPI void usdiPrimLoadPayloadAsync(usdi::Schema *schema)
+{
+    usdiTraceFunc();
+    if (!schema) { return; }
+    if (auto *pm = schema->getContext()->getPayloadManager()) { pm->requestLoad(schema); }
+}
+usdiAPI void usdiPrimUnloadPayloadAsync(usdi::Schema *schema)
+{
+    usdiTraceFunc();
+    if (!schema) { return; }
+    if (auto *pm = schema->getContext()->getPayloadManager()) { pm->requestUnload(schema); }
+}
 usdiAPI bool usdiPrimSetPayload(usdi::Schema *schema, const char *asset_path, const char *prim_path)
 {
     usdiTraceFunc();
@@ -670,6 +802,21 @@ usdiAPI bool usdiMeshReadSample(usdi::Mesh *mesh, usdi::MeshData *dst, usdi::Tim
     return mesh->readSample(*dst, t, copy);
 }
 
+usdiAPI int usdiMeshAcquireSample(usdi::Mesh *mesh, usdi::MeshData *dst, usdi::Time t)
+{
+    usdiTraceFunc();
+    if (!mesh || !dst) return -1;
+    usdiVTuneScope("usdiMeshAcquireSample");
+    return mesh->acquireSample(*dst, t);
+}
+
+usdiAPI void usdiMeshReleaseSample(usdi::Mesh *mesh, int handle)
+{
+    usdiTraceFunc();
+    if (!mesh) return;
+    mesh->releaseSample(handle);
+}
+
 usdiAPI bool usdiMeshWriteSample(usdi::Mesh *mesh, const usdi::MeshData *src, usdi::Time t)
 {
     usdiTraceFunc();
@@ -717,6 +864,21 @@ usdiAPI bool usdiPointsReadSample(usdi::Points *points, usdi::PointsData *dst, u
     return points->readSample(*dst, t, copy);
 }
 
+usdiAPI int usdiPointsAcquireSample(usdi::Points *points, usdi::PointsData *dst, usdi::Time t)
+{
+    usdiTraceFunc();
+    if (!points || !dst) return -1;
+    usdiVTuneScope("usdiPointsAcquireSample");
+    return points->acquireSample(*dst, t);
+}
+
+usdiAPI void usdiPointsReleaseSample(usdi::Points *points, int handle)
+{
+    usdiTraceFunc();
+    if (!points) return;
+    points->releaseSample(handle);
+}
+
 usdiAPI bool usdiPointsWriteSample(usdi::Points *points, const usdi::PointsData *src, usdi::Time t)
 {
     usdiTraceFunc();
@@ -774,6 +936,7 @@ usdiAPI bool usdiAttrWriteSample(usdi::Attribute *attr, const usdi::AttributeDat
 {
     usdiTraceFunc();
     if (!attr || !src) { return false; }
+    if (!attr->getParent()->getContext()->checkStageEditable("usdiAttrWriteSample()")) { return false; }
     return attr->writeSample(*src, t);
 }
 
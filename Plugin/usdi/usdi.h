@@ -25,6 +25,7 @@ using uint = unsigned int;
 #ifndef usdiImpl
     // force make compatible
     class Context {};
+    class OpenTask {};
     class Attribute {};
     class Schema {};
     class Xform : public Schema  {};
@@ -114,7 +115,22 @@ struct ImportSettings
     bool swap_handedness = false;
     bool swap_faces = false;
     bool split_mesh = true;
+    // if false, the latest sample buffer is overwritten in place unless a reader is holding it.
+    // readers get nothing (readSample() fails) while it is being overwritten.
     bool double_buffering = true;
+    // create schemas on first access (Schema::getChild() etc) instead of building whole tree on open.
+    bool lazy_schema_tree = false;
+    // memory cap (in KB) of per-mesh cache of topology and constant data decoded for each variant selection.
+    // switching back to cached variant skips reading and triangulating topology. 0 disables the cache.
+    int variant_cache_kb = 0;
+    // generate tangents by accumulating UV gradients per vertex instead of MikkTSpace.
+    // much faster but results are not identical to MikkTSpace.
+    bool fast_tangents = false;
+    // number of levels of detail made by simplifying meshes. 0 disables.
+    // nth level has about (number of triangles) * lod_ratio^n triangles. only for meshes whose topology is constant
+    // and whose attributes are all per-vertex. animated meshes reuse collapses decided at the first sample.
+    int lod_count = 0;
+    float lod_ratio = 0.5f;
 };
 
 struct ExportSettings
@@ -125,6 +141,80 @@ struct ExportSettings
     bool instanceable_by_default = false;
 };
 
+enum class PayloadLoadPolicy
+{
+    Default, // follow ImportSettings::load_all_payloads
+    LoadAll,
+    LoadNone,
+};
+
+// bits for OpenSettings::type_filter
+enum class SchemaTypeFilter
+{
+    All     = 0,
+    Xform   = 0x1,
+    Camera  = 0x2,
+    Mesh    = 0x4,
+    Points  = 0x8,
+    Other   = 0x10, // prims that are none of above (Scope etc)
+};
+
+enum class TaskPriority
+{
+    Low,
+    Normal,
+    High,
+};
+
+// concurrency of parallel work of a Context (tree build, updateAllSamples(), payload streaming, ...)
+struct ConcurrencySettings
+{
+    // number of threads the context can use including the calling thread. 0 means global scheduler (no limit).
+    int max_threads = 0;
+    // priority of asynchronous tasks (payload streaming etc)
+    TaskPriority priority = TaskPriority::Normal;
+    // hint. worker threads are restricted to these logical cores while working for the context. 0 means no restriction.
+    uint64_t affinity_mask = 0;
+};
+
+struct OpenSettings
+{
+    // if not empty, only these prims and their ancestors and descendants are composed (UsdStagePopulationMask).
+    const char **prim_paths = nullptr;
+    int num_prim_paths = 0;
+    // combination of SchemaTypeFilter bits. 0 means all.
+    // schemas are not created for prims that don't match. their descendants are attached to nearest ancestor that matches.
+    int type_filter = (int)SchemaTypeFilter::All;
+    PayloadLoadPolicy payload_policy = PayloadLoadPolicy::Default;
+    // share composed stage with other contexts that open the same file with the same settings.
+    // each context still has its own schema tree and import settings.
+    // shared stage is read-only: functions that edit it (write sample, create schema / attribute / override, flatten,
+    // variant selection, loading / unloading payloads including async ones) log an error and fail.
+    bool share_stage = false;
+};
+
+enum class OpenPhase
+{
+    Pending,
+    LoadingLayers,
+    Composing,
+    BuildingSchemas,
+    Completed,
+    Failed,
+    Canceled,
+};
+
+// progress of usdiOpenAsync()
+struct OpenProgress
+{
+    OpenPhase phase = OpenPhase::Pending;
+    // progress of current phase in [0, 1]. always 0 in LoadingLayers and Composing (can't be estimated).
+    float phase_progress = 0.0f;
+    int num_layers = 0; // layers opened so far
+    int num_schemas = 0; // schemas registered so far
+    int num_completed_subtrees = 0; // see usdiOpenTaskGetCompletedSubtree()
+};
+
 
 struct XformSummary
 {
@@ -213,7 +303,8 @@ struct SubmeshData
         Weights4 *weights4 = nullptr;
         Weights8 *weights8;
     };
-    uint        num_points = 0; // num_points == num_indices in submeshes
+    uint        num_points = 0;
+    uint        num_indices = 0; // always triangulated
 
     float3  center = { 0.0f, 0.0f, 0.0f };
     float3  extents = { 0.0f, 0.0f, 0.0f };
@@ -253,6 +344,9 @@ struct MeshData
 
     SubmeshData *submeshes = nullptr;
     uint    num_submeshes = 0;
+    // simplified meshes made by ImportSettings::lod_count. ordered from detailed to coarse.
+    SubmeshData *lods = nullptr;
+    uint    num_lods = 0;
 };
 
 
@@ -310,7 +404,26 @@ usdiAPI void             usdiClearAssetSearchPath();
 // Context interface
 usdiAPI usdi::Context*   usdiCreateContext();
 usdiAPI void             usdiDestroyContext(usdi::Context *ctx);
+// search paths of the context. used in addition to global ones (usdiAddAssetSearchPath()) by subsequent open.
+usdiAPI void             usdiContextAddAssetSearchPath(usdi::Context *ctx, const char *path);
+usdiAPI void             usdiContextClearAssetSearchPath(usdi::Context *ctx);
 usdiAPI bool             usdiOpen(usdi::Context *ctx, const char *path);
+usdiAPI bool             usdiOpenWithSettings(usdi::Context *ctx, const char *path, const usdi::OpenSettings *settings);
+// asynchronous open. settings can be null. the stage is opened and the schema tree is built on a worker thread.
+// no other APIs of the context can be called until the task finishes, and the task must be released before the context.
+usdiAPI usdi::OpenTask*  usdiOpenAsync(usdi::Context *ctx, const char *path, const usdi::OpenSettings *settings);
+usdiAPI void             usdiOpenTaskGetProgress(usdi::OpenTask *task, usdi::OpenProgress *dst);
+// subtrees under the root are published as they are built. they can be updated and read while the rest is being built.
+// the context is locked until the build ends. APIs that look up the tree (usdiFindSchema(), usdiPrimFindChild() etc)
+// block until then. only use per-schema APIs (update, read, summaries, attributes, children) on completed subtrees.
+// i must be less than OpenProgress::num_completed_subtrees. all of them are destroyed if the task is canceled.
+// they are unpublished (this returns null) before they are destroyed.
+usdiAPI usdi::Schema*    usdiOpenTaskGetCompletedSubtree(usdi::OpenTask *task, int i);
+usdiAPI void             usdiOpenTaskCancel(usdi::OpenTask *task);
+// wait until the task finishes. returns true if the stage is opened and the schema tree is completely built.
+usdiAPI bool             usdiOpenTaskWait(usdi::OpenTask *task);
+// cancel if running, wait and release
+usdiAPI void             usdiOpenTaskRelease(usdi::OpenTask *task);
 usdiAPI bool             usdiCreateStage(usdi::Context *ctx, const char *path);
 usdiAPI void             usdiFlatten(usdi::Context *ctx);
 usdiAPI bool             usdiSave(usdi::Context *ctx);
@@ -320,6 +433,9 @@ usdiAPI void             usdiSetImportSettings(usdi::Context *ctx, const usdi::I
 usdiAPI void             usdiGetImportSettings(usdi::Context *ctx, usdi::ImportSettings *v);
 usdiAPI void             usdiSetExportSettings(usdi::Context *ctx, const usdi::ExportSettings *v);
 usdiAPI void             usdiGetExportSettings(usdi::Context *ctx, usdi::ExportSettings *v);
+// payload streaming of the context is stopped and reset. fails (logs an error) while usdiOpenAsync() is running.
+usdiAPI void             usdiSetConcurrencySettings(usdi::Context *ctx, const usdi::ConcurrencySettings *v);
+usdiAPI void             usdiGetConcurrencySettings(usdi::Context *ctx, usdi::ConcurrencySettings *v);
 
 usdiAPI usdi::Schema*    usdiGetRoot(usdi::Context *ctx);
 usdiAPI int              usdiGetNumSchemas(usdi::Context *ctx);
@@ -337,6 +453,22 @@ usdiAPI usdi::Points*    usdiCreatePoints(usdi::Context *ctx, usdi::Schema *pare
 usdiAPI void             usdiNotifyForceUpdate(usdi::Context *ctx);
 usdiAPI void             usdiUpdateAllSamples(usdi::Context *ctx, usdi::Time t);
 usdiAPI void             usdiRebuildSchemaTree(usdi::Context *ctx);
+// async payload loading. loaded payloads are composed into the stage in usdiUpdateAllSamples().
+// payloads nearer to the camera are loaded first. size of each payload is estimated by its file size.
+// schemas under unloaded (or evicted) payloads and removed prims are destroyed by the usdiUpdateAllSamples() that
+// follows the one reporting the change (payload_unloaded, sample_updated) on their parent. don't use them after that.
+usdiAPI void             usdiSetPayloadCameraPosition(usdi::Context *ctx, const usdi::float3 *pos);
+// 0: unlimited
+usdiAPI void             usdiSetPayloadMemoryBudget(usdi::Context *ctx, uint64_t size);
+usdiAPI void             usdiLoadAllPayloadsAsync(usdi::Context *ctx);
+usdiAPI int              usdiGetNumPendingPayloads(usdi::Context *ctx);
+// baked playback cache: fully processed samples of Xform / Mesh / Points written to a flat file.
+// while the cache is open, samples are served from memory mapped file and not read from the stage.
+// pointers given by read sample functions with copy=false point read-only memory in that case.
+// if times is null, all time samples in the stage are baked.
+usdiAPI bool             usdiBake(usdi::Context *ctx, const char *path, const usdi::Time *times, int num_times);
+usdiAPI bool             usdiOpenBakedCache(usdi::Context *ctx, const char *path);
+usdiAPI void             usdiCloseBakedCache(usdi::Context *ctx);
 using usdiPreComputeNormalsCallback = void (usdiSTDCall*)(usdi::Mesh *mesh, bool done);
 usdiAPI void             usdiPreComputeNormalsAll(usdi::Context *ctx, bool gen_tangents, bool overwrite = false, usdiPreComputeNormalsCallback cb = nullptr);
 using usdiTimeSampleCallback = void (usdiSTDCall*)(usdi::Time t);
@@ -372,6 +504,8 @@ usdiAPI bool             usdiPrimAddReference(usdi::Schema *schema, const char *
 usdiAPI bool             usdiPrimHasPayload(usdi::Schema *schema);
 usdiAPI void             usdiPrimLoadPayload(usdi::Schema *schema);
 usdiAPI void             usdiPrimUnloadPayload(usdi::Schema *schema);
+usdiAPI void             usdiPrimLoadPayloadAsync(usdi::Schema *schema);
+usdiAPI void             usdiPrimUnloadPayloadAsync(usdi::Schema *schema);
 usdiAPI bool             usdiPrimSetPayload(usdi::Schema *schema, const char *asset_path, const char *prim_path);
 
 usdiAPI usdi::Schema*    usdiPrimGetParent(usdi::Schema *schema);
@@ -422,7 +556,13 @@ usdiAPI int              usdiCameraEachSample(usdi::Camera *cam, usdiCameraSampl
 // Mesh interface
 usdiAPI usdi::Mesh*      usdiAsMesh(usdi::Schema *schema); // dynamic cast to Mesh
 usdiAPI void             usdiMeshGetSummary(usdi::Mesh *mesh, usdi::MeshSummary *dst);
+// ReadSample() returns the sample made by the last update (usdiUpdateAllSamples(), usdiPrimUpdateSample()) and never
+// updates by itself. t is used only by baked caches. with copy=false, pointers in dst stay valid until the next
+// ReadSample(copy=false) of the same schema by any caller. to hold samples from several readers, use
+// AcquireSample() / ReleaseSample() instead. AcquireSample() returns -1 if no sample is available.
 usdiAPI bool             usdiMeshReadSample(usdi::Mesh *mesh, usdi::MeshData *dst, usdi::Time t, bool copy);
+usdiAPI int              usdiMeshAcquireSample(usdi::Mesh *mesh, usdi::MeshData *dst, usdi::Time t);
+usdiAPI void             usdiMeshReleaseSample(usdi::Mesh *mesh, int handle);
 usdiAPI bool             usdiMeshWriteSample(usdi::Mesh *mesh, const usdi::MeshData *src, usdi::Time t = usdiDefaultTime());
 using usdiMeshSampleCallback = void (usdiSTDCall*)(const usdi::MeshData *data, usdi::Time t);
 usdiAPI int              usdiMeshEachSample(usdi::Mesh *mesh, usdiMeshSampleCallback cb);
@@ -431,7 +571,10 @@ usdiAPI bool             usdiMeshPreComputeNormals(usdi::Mesh *mesh, bool gen_ta
 // Points interface
 usdiAPI usdi::Points*    usdiAsPoints(usdi::Schema *schema); // dynamic cast to Points
 usdiAPI void             usdiPointsGetSummary(usdi::Points *points, usdi::PointsSummary *dst);
+// see usdiMeshReadSample() and usdiMeshAcquireSample()
 usdiAPI bool             usdiPointsReadSample(usdi::Points *points, usdi::PointsData *dst, usdi::Time t, bool copy);
+usdiAPI int              usdiPointsAcquireSample(usdi::Points *points, usdi::PointsData *dst, usdi::Time t);
+usdiAPI void             usdiPointsReleaseSample(usdi::Points *points, int handle);
 usdiAPI bool             usdiPointsWriteSample(usdi::Points *points, const usdi::PointsData *src, usdi::Time t = usdiDefaultTime());
 using usdiPointsSampleCallback = void (usdiSTDCall*)(const usdi::PointsData *data, usdi::Time t);
 usdiAPI int              usdiPointsEachSample(usdi::Points *points, usdiPointsSampleCallback cb);
@@ -1,7 +1,7 @@
 #include "pch.h"
 #include "usdiInternal.h"
-#include "usdiContext.h"
 #include "usdiSchema.h"
+#include "usdiContext.h"
 #include "usdiAttribute.h"
 #include "usdiVectorConversion.h"
 
@@ -97,11 +97,46 @@ Attribute::Attribute(Schema *parent, UsdAttribute usdattr)
     m_dbg_name = getName();
     m_dbg_typename = getTypeName();
 #endif
+}
 
-    if (m_usdattr && m_usdattr.GetNumTimeSamples() > 0) {
+void GetAttributeTimeRange(const UsdAttribute& attr, Time& start, Time& end)
+{
+    start = end = usdiInvalidTime;
+    if (attr && attr.GetNumTimeSamples() > 0) {
         bool dummy;
-        m_usdattr.GetBracketingTimeSamples(DBL_MIN, &m_time_start, &m_time_start, &dummy);
-        m_usdattr.GetBracketingTimeSamples(DBL_MAX, &m_time_end, &m_time_end, &dummy);
+        attr.GetBracketingTimeSamples(DBL_MIN, &start, &start, &dummy);
+        attr.GetBracketingTimeSamples(DBL_MAX, &end, &end, &dummy);
+    }
+}
+
+void Attribute::syncTimeRange()
+{
+    GetAttributeTimeRange(m_usdattr, m_time_start, m_time_end);
+    m_time_range_synced = true;
+}
+
+void Attribute::syncTimeRangeIfNeeded()
+{
+    if (!m_time_range_synced) {
+        syncTimeRange();
+    }
+}
+
+void Attribute::rebind(UsdAttribute usdattr)
+{
+    m_usdattr = usdattr;
+    for (auto& c : m_converters) {
+        c->rebind(usdattr);
+    }
+    invalidate();
+}
+
+void Attribute::invalidate()
+{
+    m_time_range_synced = false;
+    m_time_prev = usdiInvalidTime;
+    for (auto& c : m_converters) {
+        c->invalidate();
     }
 }
 
@@ -112,6 +147,7 @@ Attribute::~Attribute()
 UsdAttribute    Attribute::getUSDAttribute() const  { return m_usdattr; }
 Schema*         Attribute::getParent() const        { return m_parent; }
 const char*     Attribute::getName() const          { return m_usdattr.GetName().GetText(); }
+const TfToken&  Attribute::getNameToken() const     { return m_usdattr.GetName(); }
 const char*     Attribute::getTypeName() const      { return m_usdattr.GetTypeName().GetAsToken().GetText(); }
 AttributeType   Attribute::getType() const          { return m_type; }
 bool            Attribute::isConstant() const       { return !m_usdattr.ValueMightBeTimeVarying(); }
@@ -120,12 +156,14 @@ size_t          Attribute::getNumSamples() const    { return m_usdattr.GetNumTim
 
 void Attribute::getTimeRange(Time& start, Time& end)
 {
+    syncTimeRangeIfNeeded();
     start = m_time_start;
     end = m_time_end;
 }
 
 AttributeSummary Attribute::getSummary()
 {
+    syncTimeRangeIfNeeded();
     AttributeSummary ret;
     ret.start = m_time_start;
     ret.end = m_time_end;
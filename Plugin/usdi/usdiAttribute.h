@@ -11,12 +11,17 @@ public:
     UsdAttribute    getUSDAttribute() const;
     Schema*         getParent() const;
     const char*     getName() const;
+    const TfToken&  getNameToken() const;
     const char*     getTypeName() const;
     AttributeType   getType() const;
     bool            isConstant() const;
     bool            hasValue() const;
     size_t          getNumSamples() const;
     void            getTimeRange(Time& start, Time& end);
+    // re-read time range and discard cached sample. called when value of the attribute is changed on the stage.
+    void            invalidate();
+    // replace handle of the attribute. called when the prim is re-composed on the stage.
+    void            rebind(UsdAttribute usdattr);
 
     AttributeSummary getSummary();
     virtual void    updateSample(Time t) = 0;
@@ -45,9 +50,14 @@ protected:
     using AttributePtr = std::unique_ptr<Attribute>;
     using Attributes = std::vector<AttributePtr>;
 
+    // time range is computed on first request
+    void syncTimeRange();
+    void syncTimeRangeIfNeeded();
+
     Schema *m_parent = nullptr;
     UsdAttribute m_usdattr;
     AttributeType m_type = AttributeType::Unknown;
+    bool m_time_range_synced = false;
     Time m_time_start = usdiInvalidTime;
     Time m_time_end = usdiInvalidTime;
     Time m_time_prev = usdiInvalidTime;
@@ -59,6 +69,9 @@ protected:
 #endif
 };
 
+// start and end are set to usdiInvalidTime if attr has no time samples
+void GetAttributeTimeRange(const UsdAttribute& attr, Time& start, Time& end);
+
 Attribute* WrapExistingAttribute(Schema *parent, UsdAttribute usd);
 Attribute* WrapExistingAttribute(Schema *parent, const char *name);
 
@@ -0,0 +1,636 @@
+#include "pch.h"
+#include "usdiInternal.h"
+#include "usdiSchema.h"
+#include "usdiXform.h"
+#include "usdiCamera.h"
+#include "usdiMesh.h"
+#include "usdiPoints.h"
+#include "usdiContext.h"
+#include "usdiBakedCache.h"
+#include "usdiUtils.h"
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+#endif
+
+namespace usdi {
+
+namespace {
+
+const size_t BakeAlignment = 16;
+
+class BakeWriter
+{
+public:
+    // stream written in previous frame. identical streams are shared between frames.
+    struct Stream
+    {
+        std::vector<char> data;
+        uint64_t offset = 0;
+    };
+
+    BakeWriter(FILE *f) : m_file(f) {}
+
+    // return offset of data. 0 if data is empty.
+    uint64_t write(const void *data, size_t size)
+    {
+        if (!data || size == 0) { return 0; }
+
+        static const char s_zeros[BakeAlignment] = {};
+        size_t pad = (BakeAlignment - (size_t)(m_pos % BakeAlignment)) % BakeAlignment;
+        if (pad > 0) {
+            fwrite(s_zeros, 1, pad, m_file);
+            m_pos += pad;
+        }
+        uint64_t ret = m_pos;
+        fwrite(data, 1, size, m_file);
+        m_pos += size;
+        return ret;
+    }
+
+    uint64_t write(const void *data, size_t size, Stream& prev)
+    {
+        if (!data || size == 0) { return 0; }
+
+        if (prev.offset != 0 && prev.data.size() == size && memcmp(prev.data.data(), data, size) == 0) {
+            return prev.offset;
+        }
+        prev.data.assign((const char*)data, (const char*)data + size);
+        prev.offset = write(data, size);
+        return prev.offset;
+    }
+
+    uint64_t write(const std::string& str)
+    {
+        return str.empty() ? 0 : write(str.c_str(), str.size() + 1);
+    }
+
+private:
+    FILE *m_file = nullptr;
+    uint64_t m_pos = 0;
+};
+
+struct BakeEntry
+{
+    Schema *schema = nullptr;
+    Xform *xform = nullptr;
+    Mesh *mesh = nullptr;
+    Points *points = nullptr;
+
+    std::vector<uint64_t> xform_records;
+    std::vector<uint64_t> mesh_records;
+    std::vector<uint64_t> points_records;
+    std::vector<BakeWriter::Stream> streams;
+
+    std::string bones; // null-terminated strings
+    std::string root_bone;
+    uint32_t num_bones = 0;
+
+    BakeWriter::Stream& stream(size_t i)
+    {
+        if (i >= streams.size()) { streams.resize(i + 1); }
+        return streams[i];
+    }
+};
+
+// stream slots
+enum
+{
+    SlotXform,
+    SlotRecord,
+    SlotSubmeshRecords,
+    SlotPoints,
+    SlotNormals,
+    SlotColors,
+    SlotUVs,
+    SlotTangents,
+    SlotVelocities,
+    SlotCounts,
+    SlotIndices,
+    SlotIndicesTriangulated,
+    SlotWeights,
+    SlotBindposes,
+    SlotWidths,
+    SlotIDs64,
+    SlotIDs32,
+    SlotSubmeshBegin,
+    NumSubmeshSlots = 8,
+};
+
+static size_t GetWeightsSize(uint max_bone_weights)
+{
+    return max_bone_weights == 4 ? sizeof(Weights4) : max_bone_weights == 8 ? sizeof(Weights8) : 0;
+}
+
+static void BakeMesh(BakeWriter& w, BakeEntry& e, Time t, std::vector<SubmeshData>& submeshes, std::vector<BakedCache::SubmeshRecord>& srecords)
+{
+    // first read to get number of submeshes
+    MeshData data;
+    e.mesh->releaseSample(e.mesh->acquireSample(data, t));
+    submeshes.assign(data.num_submeshes, SubmeshData());
+    data.submeshes = submeshes.data();
+    int handle = e.mesh->acquireSample(data, t);
+
+    BakedCache::MeshRecord r;
+    r.num_points = data.num_points;
+    r.num_counts = data.num_counts;
+    r.num_indices = data.num_indices;
+    r.num_indices_triangulated = data.num_indices_triangulated;
+    r.num_submeshes = data.num_submeshes;
+    r.max_bone_weights = data.max_bone_weights;
+    r.center = data.center;
+    r.extents = data.extents;
+
+    size_t weights_size = GetWeightsSize(data.max_bone_weights);
+    const void *weights = data.max_bone_weights == 8 ? (const void*)data.weights8 : (const void*)data.weights4;
+    r.points = w.write(data.points, sizeof(float3) * data.num_points, e.stream(SlotPoints));
+    r.normals = w.write(data.normals, sizeof(float3) * data.num_points, e.stream(SlotNormals));
+    r.colors = w.write(data.colors, sizeof(float4) * data.num_points, e.stream(SlotColors));
+    r.uvs = w.write(data.uvs, sizeof(float2) * data.num_points, e.stream(SlotUVs));
+    r.tangents = w.write(data.tangents, sizeof(float4) * data.num_points, e.stream(SlotTangents));
+    r.velocities = w.write(data.velocities, sizeof(float3) * data.num_points, e.stream(SlotVelocities));
+    r.counts = w.write(data.counts, sizeof(int) * data.num_counts, e.stream(SlotCounts));
+    r.indices = w.write(data.indices, sizeof(int) * data.num_indices, e.stream(SlotIndices));
+    r.indices_triangulated = w.write(data.indices_triangulated, sizeof(int) * data.num_indices_triangulated, e.stream(SlotIndicesTriangulated));
+    r.weights = w.write(weights, weights_size * data.num_points, e.stream(SlotWeights));
+    r.bindposes = w.write(data.bindposes, sizeof(float4x4) * data.num_bones, e.stream(SlotBindposes));
+
+    srecords.resize(data.num_submeshes);
+    for (uint si = 0; si < data.num_submeshes; ++si) {
+        const auto& src = submeshes[si];
+        auto& dst = srecords[si];
+        size_t slot = SlotSubmeshBegin + si * NumSubmeshSlots;
+        dst.num_points = src.num_points;
+        dst.num_indices = src.num_indices;
+        dst.center = src.center;
+        dst.extents = src.extents;
+        dst.points = w.write(src.points, sizeof(float3) * src.num_points, e.stream(slot + 0));
+        dst.normals = w.write(src.normals, sizeof(float3) * src.num_points, e.stream(slot + 1));
+        dst.colors = w.write(src.colors, sizeof(float4) * src.num_points, e.stream(slot + 2));
+        dst.uvs = w.write(src.uvs, sizeof(float2) * src.num_points, e.stream(slot + 3));
+        dst.tangents = w.write(src.tangents, sizeof(float4) * src.num_points, e.stream(slot + 4));
+        dst.velocities = w.write(src.velocities, sizeof(float3) * src.num_points, e.stream(slot + 5));
+        dst.indices = w.write(src.indices, sizeof(int) * src.num_indices, e.stream(slot + 6));
+        const void *sweights = data.max_bone_weights == 8 ? (const void*)src.weights8 : (const void*)src.weights4;
+        dst.weights = w.write(sweights, weights_size * src.num_points, e.stream(slot + 7));
+    }
+    r.submeshes = w.write(srecords.data(), sizeof(BakedCache::SubmeshRecord) * srecords.size(), e.stream(SlotSubmeshRecords));
+
+    // bones are assumed to be constant
+    if (e.num_bones == 0 && data.num_bones > 0 && data.bones) {
+        for (uint bi = 0; bi < data.num_bones; ++bi) {
+            e.bones += data.bones[bi] ? data.bones[bi] : "";
+            e.bones += '\0';
+        }
+        e.num_bones = data.num_bones;
+        if (data.root_bone) { e.root_bone = data.root_bone; }
+    }
+
+    e.mesh_records.push_back(w.write(&r, sizeof(r), e.stream(SlotRecord)));
+    e.mesh->releaseSample(handle);
+}
+
+static void BakePoints(BakeWriter& w, BakeEntry& e, Time t)
+{
+    PointsData data;
+    int handle = e.points->acquireSample(data, t);
+
+    BakedCache::PointsRecord r;
+    r.num_points = data.num_points;
+    r.points = w.write(data.points, sizeof(float3) * data.num_points, e.stream(SlotPoints));
+    r.velocities = w.write(data.velocities, sizeof(float3) * data.num_points, e.stream(SlotVelocities));
+    r.widths = w.write(data.widths, sizeof(float) * data.num_points, e.stream(SlotWidths));
+    r.ids64 = w.write(data.ids64, sizeof(int64_t) * data.num_points, e.stream(SlotIDs64));
+    r.ids32 = w.write(data.ids32, sizeof(int32_t) * data.num_points, e.stream(SlotIDs32));
+
+    e.points_records.push_back(w.write(&r, sizeof(r), e.stream(SlotRecord)));
+    e.points->releaseSample(handle);
+}
+
+} // namespace
+
+
+bool BakedCache::bake(Context *ctx, const char *path, const Time *times_, int num_times)
+{
+    if (!ctx || !ctx->valid() || !path) { return false; }
+
+    std::vector<Time> times;
+    if (times_) {
+        times.assign(times_, times_ + num_times);
+    }
+    else {
+        ctx->eachTimeSample([&times](Time t) { times.push_back(t); });
+    }
+    // default time is meaningful only if there are no time samples
+    times.erase(std::remove_if(times.begin(), times.end(), [](Time t) { return std::isnan(t); }), times.end());
+    std::sort(times.begin(), times.end());
+    times.erase(std::unique(times.begin(), times.end()), times.end());
+    if (times.empty()) {
+        times.push_back(usdiDefaultTime());
+    }
+
+    FILE *f = fopen(path, "wb");
+    if (!f) {
+        usdiLogError("BakedCache::bake(): failed to open %s\n", path);
+        return false;
+    }
+
+    // cameras are left to be read from the stage. camera data is not baked.
+    std::vector<BakeEntry> entries;
+    int num_schemas = ctx->getNumSchemas();
+    for (int i = 0; i < num_schemas; ++i) {
+        auto *schema = ctx->getSchema(i);
+        BakeEntry e;
+        e.schema = schema;
+        e.xform = dynamic_cast<Xform*>(schema);
+        e.mesh = dynamic_cast<Mesh*>(schema);
+        e.points = dynamic_cast<Points*>(schema);
+        if (e.xform && !dynamic_cast<Camera*>(schema)) {
+            entries.push_back(std::move(e));
+        }
+    }
+
+    BakeWriter w(f);
+    FileHeader header;
+    w.write(&header, sizeof(header));
+
+    std::vector<SubmeshData> submeshes;
+    std::vector<SubmeshRecord> srecords;
+    for (auto t : times) {
+        ctx->updateAllSamples(t);
+        for (auto& e : entries) {
+            XformData xd;
+            e.xform->readSample(xd, t);
+            // update flags are decided on playback
+            xd.flags &= ~(int)XformData::Flags::UpdatedMask;
+            e.xform_records.push_back(w.write(&xd, sizeof(xd), e.stream(SlotXform)));
+
+            if (e.mesh) {
+                BakeMesh(w, e, t, submeshes, srecords);
+            }
+            else if (e.points) {
+                BakePoints(w, e, t);
+            }
+        }
+    }
+
+    header.num_frames = (uint32_t)times.size();
+    header.num_entries = (uint32_t)entries.size();
+    header.times = w.write(times.data(), sizeof(Time) * times.size());
+
+    std::vector<Entry> dst_entries(entries.size());
+    for (size_t i = 0; i < entries.size(); ++i) {
+        auto& src = entries[i];
+        auto& dst = dst_entries[i];
+        dst.path = w.write(std::string(src.schema->getPath()));
+        dst.xforms = w.write(src.xform_records.data(), sizeof(uint64_t) * src.xform_records.size());
+        dst.meshes = w.write(src.mesh_records.data(), sizeof(uint64_t) * src.mesh_records.size());
+        dst.points = w.write(src.points_records.data(), sizeof(uint64_t) * src.points_records.size());
+        dst.bones = w.write(src.bones.data(), src.bones.size());
+        dst.root_bone = w.write(src.root_bone);
+        dst.num_bones = src.num_bones;
+    }
+    header.entries = w.write(dst_entries.data(), sizeof(Entry) * dst_entries.size());
+
+    fseek(f, 0, SEEK_SET);
+    fwrite(&header, sizeof(header), 1, f);
+    bool ret = ferror(f) == 0;
+    fclose(f);
+
+    if (ret) {
+        usdiLogInfo("BakedCache::bake(): %d entries, %d frames -> %s\n", (int)header.num_entries, (int)header.num_frames, path);
+    }
+    else {
+        usdiLogError("BakedCache::bake(): failed to write %s\n", path);
+    }
+    return ret;
+}
+
+
+BakedCache::BakedCache()
+{
+}
+
+BakedCache::~BakedCache()
+{
+    close();
+}
+
+bool BakedCache::open(const char *path)
+{
+    close();
+    if (!path) { return false; }
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        usdiLogError("BakedCache::open(): failed to open %s\n", path);
+        return false;
+    }
+    m_file = file;
+
+    LARGE_INTEGER size;
+    if (GetFileSizeEx(file, &size) && size.QuadPart > 0) {
+        m_mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (m_mapping) {
+            m_data = (char*)MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+            m_size = (size_t)size.QuadPart;
+        }
+    }
+#else
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0) {
+        usdiLogError("BakedCache::open(): failed to open %s\n", path);
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        void *data = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data != MAP_FAILED) {
+            m_data = (char*)data;
+            m_size = (size_t)st.st_size;
+        }
+    }
+    // the mapping stays valid after closing the descriptor
+    ::close(fd);
+#endif
+    if (!m_data) {
+        usdiLogError("BakedCache::open(): failed to map %s\n", path);
+        close();
+        return false;
+    }
+
+    // validate header and tables
+    m_header = (const FileHeader*)m_data;
+    bool valid = m_size >= sizeof(FileHeader) &&
+        memcmp(m_header->magic, FileHeader().magic, sizeof(m_header->magic)) == 0 &&
+        m_header->version == Version &&
+        m_header->num_frames > 0 &&
+        m_header->times != 0 && inRange(m_header->times, sizeof(Time) * m_header->num_frames) &&
+        inRange(m_header->entries, sizeof(Entry) * m_header->num_entries);
+    if (!valid) {
+        usdiLogError("BakedCache::open(): %s is not a valid baked cache\n", path);
+        close();
+        return false;
+    }
+
+    m_times = get<Time>(m_header->times);
+    m_entries = get<Entry>(m_header->entries);
+    for (uint32_t i = 0; i < m_header->num_entries; ++i) {
+        if (!validateEntry(m_entries[i])) {
+            usdiLogError("BakedCache::open(): %s is truncated or corrupted\n", path);
+            close();
+            return false;
+        }
+    }
+
+    m_bones.resize(m_header->num_entries);
+    for (uint32_t i = 0; i < m_header->num_entries; ++i) {
+        const auto& e = m_entries[i];
+        if (e.path) {
+            m_entry_index.emplace(get<char>(e.path), (int)i);
+        }
+
+        auto& bones = m_bones[i];
+        char *name = get<char>(e.bones);
+        for (uint32_t bi = 0; name && bi < e.num_bones; ++bi) {
+            bones.push_back(name);
+            name += strlen(name) + 1;
+        }
+        bones.push_back(nullptr);
+    }
+    return true;
+}
+
+void BakedCache::close()
+{
+#ifdef _WIN32
+    if (m_data) { UnmapViewOfFile(m_data); }
+    if (m_mapping) { CloseHandle((HANDLE)m_mapping); }
+    if (m_file) { CloseHandle((HANDLE)m_file); }
+    m_mapping = nullptr;
+    m_file = nullptr;
+#else
+    if (m_data) { munmap(m_data, m_size); }
+#endif
+    m_data = nullptr;
+    m_size = 0;
+    m_header = nullptr;
+    m_times = nullptr;
+    m_entries = nullptr;
+    m_entry_index.clear();
+    m_bones.clear();
+}
+
+bool BakedCache::valid() const
+{
+    return m_header != nullptr;
+}
+
+bool BakedCache::inRange(uint64_t offset, uint64_t size) const
+{
+    return offset == 0 || (offset < m_size && size <= m_size - offset);
+}
+
+bool BakedCache::validateEntry(const Entry& e) const
+{
+    // strings must be terminated within the file
+    auto validString = [this](uint64_t offset) {
+        return offset == 0 || (offset < m_size && memchr(m_data + offset, '\0', m_size - offset) != nullptr);
+    };
+    if (!validString(e.path) || !validString(e.root_bone)) { return false; }
+    if (e.bones != 0) {
+        uint64_t pos = e.bones;
+        for (uint32_t bi = 0; bi < e.num_bones; ++bi) {
+            if (!validString(pos)) { return false; }
+            pos += strlen(m_data + pos) + 1;
+        }
+    }
+
+    // per-frame offset tables and records they point
+    uint64_t table_size = sizeof(uint64_t) * m_header->num_frames;
+    if (!inRange(e.xforms, table_size) || !inRange(e.meshes, table_size) || !inRange(e.points, table_size)) {
+        return false;
+    }
+    for (uint32_t fi = 0; fi < m_header->num_frames; ++fi) {
+        if (e.xforms && !inRange(get<uint64_t>(e.xforms)[fi], sizeof(XformData))) {
+            return false;
+        }
+        if (e.meshes) {
+            uint64_t offset = get<uint64_t>(e.meshes)[fi];
+            if (!inRange(offset, sizeof(MeshRecord))) { return false; }
+            if (auto *r = get<MeshRecord>(offset)) {
+                size_t weights_size = GetWeightsSize(r->max_bone_weights);
+                bool valid =
+                    inRange(r->points, sizeof(float3) * r->num_points) &&
+                    inRange(r->normals, sizeof(float3) * r->num_points) &&
+                    inRange(r->colors, sizeof(float4) * r->num_points) &&
+                    inRange(r->uvs, sizeof(float2) * r->num_points) &&
+                    inRange(r->tangents, sizeof(float4) * r->num_points) &&
+                    inRange(r->velocities, sizeof(float3) * r->num_points) &&
+                    inRange(r->counts, sizeof(int) * r->num_counts) &&
+                    inRange(r->indices, sizeof(int) * r->num_indices) &&
+                    inRange(r->indices_triangulated, sizeof(int) * r->num_indices_triangulated) &&
+                    inRange(r->weights, weights_size * r->num_points) &&
+                    inRange(r->bindposes, sizeof(float4x4) * e.num_bones) &&
+                    inRange(r->submeshes, sizeof(SubmeshRecord) * r->num_submeshes);
+                if (!valid) { return false; }
+                auto *srecords = get<SubmeshRecord>(r->submeshes);
+                for (uint32_t si = 0; srecords && si < r->num_submeshes; ++si) {
+                    const auto& s = srecords[si];
+                    valid =
+                        inRange(s.points, sizeof(float3) * s.num_points) &&
+                        inRange(s.normals, sizeof(float3) * s.num_points) &&
+                        inRange(s.colors, sizeof(float4) * s.num_points) &&
+                        inRange(s.uvs, sizeof(float2) * s.num_points) &&
+                        inRange(s.tangents, sizeof(float4) * s.num_points) &&
+                        inRange(s.velocities, sizeof(float3) * s.num_points) &&
+                        inRange(s.indices, sizeof(int) * s.num_indices) &&
+                        inRange(s.weights, weights_size * s.num_points);
+                    if (!valid) { return false; }
+                }
+            }
+        }
+        if (e.points) {
+            uint64_t offset = get<uint64_t>(e.points)[fi];
+            if (!inRange(offset, sizeof(PointsRecord))) { return false; }
+            if (auto *r = get<PointsRecord>(offset)) {
+                bool valid =
+                    inRange(r->points, sizeof(float3) * r->num_points) &&
+                    inRange(r->velocities, sizeof(float3) * r->num_points) &&
+                    inRange(r->widths, sizeof(float) * r->num_points) &&
+                    inRange(r->ids64, sizeof(int64_t) * r->num_points) &&
+                    inRange(r->ids32, sizeof(int32_t) * r->num_points);
+                if (!valid) { return false; }
+            }
+        }
+    }
+    return true;
+}
+
+int BakedCache::findEntry(const std::string& path) const
+{
+    auto it = m_entry_index.find(path);
+    return it != m_entry_index.end() ? it->second : -1;
+}
+
+int BakedCache::getFrame(Time t) const
+{
+    int n = (int)m_header->num_frames;
+    if (n == 1 || std::isnan(t)) { return 0; }
+    auto it = std::upper_bound(m_times, m_times + n, t);
+    return std::max<int>((int)std::distance(m_times, it) - 1, 0);
+}
+
+uint64_t BakedCache::getRecord(uint64_t table, Time t) const
+{
+    if (!valid() || table == 0) { return 0; }
+    return get<uint64_t>(table)[getFrame(t)];
+}
+
+template<class T>
+static inline void Assign(T *&dst, T *src, size_t num, bool copy)
+{
+    if (copy) {
+        if (dst && src) {
+            memcpy(dst, src, sizeof(T) * num);
+        }
+    }
+    else {
+        dst = src;
+    }
+}
+
+bool BakedCache::readXform(int entry, XformData& dst, Time t) const
+{
+    auto *r = get<XformData>(getRecord(m_entries[entry].xforms, t));
+    if (!r) { return false; }
+    dst = *r;
+    return true;
+}
+
+bool BakedCache::readMesh(int entry, MeshData& dst, Time t, bool copy) const
+{
+    const auto& e = m_entries[entry];
+    auto *r = get<MeshRecord>(getRecord(e.meshes, t));
+    if (!r) { return false; }
+
+    dst.num_points = r->num_points;
+    dst.num_counts = r->num_counts;
+    dst.num_indices = r->num_indices;
+    dst.num_indices_triangulated = r->num_indices_triangulated;
+    dst.num_submeshes = r->num_submeshes;
+    dst.num_lods = 0; // LODs are not baked
+    dst.center = r->center;
+    dst.extents = r->extents;
+
+    dst.max_bone_weights = r->max_bone_weights;
+    dst.bones = (char**)m_bones[entry].data();
+    dst.root_bone = get<char>(e.root_bone);
+    dst.num_bones = e.num_bones;
+
+    Assign(dst.points, get<float3>(r->points), dst.num_points, copy);
+    Assign(dst.normals, get<float3>(r->normals), dst.num_points, copy);
+    Assign(dst.colors, get<float4>(r->colors), dst.num_points, copy);
+    Assign(dst.uvs, get<float2>(r->uvs), dst.num_points, copy);
+    Assign(dst.tangents, get<float4>(r->tangents), dst.num_points, copy);
+    Assign(dst.velocities, get<float3>(r->velocities), dst.num_points, copy);
+    Assign(dst.counts, get<int>(r->counts), dst.num_counts, copy);
+    Assign(dst.indices, get<int>(r->indices), dst.num_indices, copy);
+    Assign(dst.indices_triangulated, get<int>(r->indices_triangulated), dst.num_indices_triangulated, copy);
+    if (r->max_bone_weights == 4) {
+        Assign(dst.weights4, get<Weights4>(r->weights), dst.num_points, copy);
+    }
+    else if (r->max_bone_weights == 8) {
+        Assign(dst.weights8, get<Weights8>(r->weights), dst.num_points, copy);
+    }
+    Assign(dst.bindposes, get<float4x4>(r->bindposes), dst.num_bones, copy);
+
+    if (dst.submeshes) {
+        auto *srecords = get<SubmeshRecord>(r->submeshes);
+        for (uint si = 0; si < dst.num_submeshes; ++si) {
+            const auto& ssrc = srecords[si];
+            auto& sdst = dst.submeshes[si];
+            sdst.num_points = ssrc.num_points;
+            sdst.num_indices = ssrc.num_indices;
+            sdst.center = ssrc.center;
+            sdst.extents = ssrc.extents;
+
+            Assign(sdst.indices, get<int>(ssrc.indices), sdst.num_indices, copy);
+            Assign(sdst.points, get<float3>(ssrc.points), sdst.num_points, copy);
+            Assign(sdst.normals, get<float3>(ssrc.normals), sdst.num_points, copy);
+            Assign(sdst.colors, get<float4>(ssrc.colors), sdst.num_points, copy);
+            Assign(sdst.uvs, get<float2>(ssrc.uvs), sdst.num_points, copy);
+            Assign(sdst.tangents, get<float4>(ssrc.tangents), sdst.num_points, copy);
+            Assign(sdst.velocities, get<float3>(ssrc.velocities), sdst.num_points, copy);
+            if (r->max_bone_weights == 4) {
+                Assign(sdst.weights4, get<Weights4>(ssrc.weights), sdst.num_points, copy);
+            }
+            else if (r->max_bone_weights == 8) {
+                Assign(sdst.weights8, get<Weights8>(ssrc.weights), sdst.num_points, copy);
+            }
+        }
+    }
+    return dst.num_points > 0;
+}
+
+bool BakedCache::readPoints(int entry, PointsData& dst, Time t, bool copy) const
+{
+    auto *r = get<PointsRecord>(getRecord(m_entries[entry].points, t));
+    if (!r) { return false; }
+
+    dst.num_points = r->num_points;
+    Assign(dst.points, get<float3>(r->points), dst.num_points, copy);
+    Assign(dst.velocities, get<float3>(r->velocities), dst.num_points, copy);
+    Assign(dst.widths, get<float>(r->widths), dst.num_points, copy);
+    Assign(dst.ids64, get<int64_t>(r->ids64), dst.num_points, copy);
+    Assign(dst.ids32, get<int32_t>(r->ids32), dst.num_points, copy);
+    return dst.num_points > 0;
+}
+
+} // namespace usdi
@@ -0,0 +1,118 @@
+#pragma once
+
+namespace usdi {
+
+// flat binary file that stores fully processed samples (result of readSample()) of Xform / Mesh / Points per frame.
+// the file is memory mapped on playback and readSample() with copy=false returns pointers into the mapping.
+// so pointers returned in that case point read-only memory.
+//
+// layout:
+//  FileHeader
+//  records: XformData / MeshRecord (+ SubmeshRecord[]) / PointsRecord and their streams.
+//      each stream is stored contiguously and 16 byte aligned. streams identical to previous frame are shared.
+//  times: Time[num_frames]
+//  tables: uint64_t[num_frames] per entry. offsets to records of each frame.
+//  strings: paths and bone names
+//  entries: Entry[num_entries]
+class BakedCache
+{
+public:
+    static const uint32_t Version = 2;
+
+    struct FileHeader
+    {
+        char     magic[8] = { 'U', 'S', 'D', 'I', 'B', 'A', 'K', 'E' };
+        uint32_t version = Version;
+        uint32_t num_frames = 0;
+        uint32_t num_entries = 0;
+        uint32_t reserved = 0;
+        uint64_t times = 0;
+        uint64_t entries = 0;
+    };
+
+    struct Entry
+    {
+        uint64_t path = 0;
+        uint64_t xforms = 0;    // offsets to XformData. 0 if not Xform
+        uint64_t meshes = 0;    // offsets to MeshRecord. 0 if not Mesh
+        uint64_t points = 0;    // offsets to PointsRecord. 0 if not Points
+        uint64_t bones = 0;     // num_bones null-terminated strings
+        uint64_t root_bone = 0;
+        uint32_t num_bones = 0;
+        uint32_t reserved = 0;
+    };
+
+    // offsets are from head of the file. 0 means no data.
+    struct SubmeshRecord
+    {
+        uint32_t num_points = 0;
+        uint32_t num_indices = 0;
+        float3   center = {}, extents = {};
+        uint64_t points = 0, normals = 0, colors = 0, uvs = 0, tangents = 0, velocities = 0, indices = 0, weights = 0;
+    };
+
+    struct MeshRecord
+    {
+        uint32_t num_points = 0;
+        uint32_t num_counts = 0;
+        uint32_t num_indices = 0;
+        uint32_t num_indices_triangulated = 0;
+        uint32_t num_submeshes = 0;
+        uint32_t max_bone_weights = 0;
+        float3   center = {}, extents = {};
+        uint64_t points = 0, normals = 0, colors = 0, uvs = 0, tangents = 0, velocities = 0;
+        uint64_t counts = 0, indices = 0, indices_triangulated = 0;
+        uint64_t weights = 0, bindposes = 0;
+        uint64_t submeshes = 0;
+    };
+
+    struct PointsRecord
+    {
+        uint32_t num_points = 0;
+        uint32_t reserved = 0;
+        uint64_t points = 0, velocities = 0, widths = 0, ids64 = 0, ids32 = 0;
+    };
+
+    // bake all Xform / Mesh / Points in ctx at given times.
+    // if times is null, all time samples in the stage (Context::eachTimeSample()) are baked.
+    static bool bake(Context *ctx, const char *path, const Time *times, int num_times);
+
+    BakedCache();
+    ~BakedCache();
+    bool    open(const char *path);
+    void    close();
+    bool    valid() const;
+
+    // return index of entry or -1 if not found
+    int     findEntry(const std::string& path) const;
+    bool    readXform(int entry, XformData& dst, Time t) const;
+    bool    readMesh(int entry, MeshData& dst, Time t, bool copy) const;
+    bool    readPoints(int entry, PointsData& dst, Time t, bool copy) const;
+
+private:
+    // offset + size must be within the file. offset 0 (no data) is always valid.
+    bool    inRange(uint64_t offset, uint64_t size) const;
+    // range-check tables, records and streams of the entry so that truncated or corrupted files can't be read out of bounds
+    bool    validateEntry(const Entry& e) const;
+    // last frame at or before t
+    int     getFrame(Time t) const;
+    uint64_t getRecord(uint64_t table, Time t) const;
+    template<class T> T* get(uint64_t offset) const
+    {
+        return offset == 0 ? nullptr : (T*)(m_data + offset);
+    }
+
+    char                *m_data = nullptr;
+    size_t              m_size = 0;
+#ifdef _WIN32
+    void                *m_file = nullptr;
+    void                *m_mapping = nullptr;
+#endif
+    const FileHeader    *m_header = nullptr;
+    const Time          *m_times = nullptr;
+    const Entry         *m_entries = nullptr;
+    std::unordered_map<std::string, int> m_entry_index;
+    std::vector<std::vector<char*>> m_bones;
+};
+
+} // namespace usdi
@@ -42,11 +42,20 @@ const usdi::CameraSummary& Camera::getSummary() const
     return m_summary;
 }
 
+void Camera::resync(bool attributes, const TfTokenVector& changed)
+{
+    super::resync(attributes, changed);
+    m_summary_needs_update = true;
+    if (attributes) {
+        m_cam = UsdGeomCamera(m_prim);
+    }
+}
+
 void Camera::updateSample(Time t_)
 {
     super::updateSample(t_);
-    if (m_update_flag.bits == 0) { return; }
-    if (m_update_flag.variant_set_changed) { m_summary_needs_update = true; }
+    if (updateFlag().bits == 0) { return; }
+    if (updateFlag().variant_set_changed) { m_summary_needs_update = true; }
 
     auto t = UsdTimeCode(t_);
     auto& sample = m_sample;
@@ -78,7 +87,7 @@ void Camera::updateSample(Time t_)
 
 bool Camera::readSample(CameraData& dst, Time t)
 {
-    if (t != m_time_prev) { updateSample(t); }
+    if (t != timePrev()) { updateSample(t); }
 
     dst = m_sample;
     return true;
@@ -86,6 +95,7 @@ bool Camera::readSample(CameraData& dst, Time t)
 
 bool Camera::writeSample(const CameraData& src, Time t_)
 {
+    if (!m_ctx->checkStageEditable("Camera::writeSample()")) { return false; }
     auto t = UsdTimeCode(t_);
 
     {
@@ -13,6 +13,7 @@ public:
     ~Camera() override;
 
     void                updateSample(Time t) override;
+    void                resync(bool attributes, const TfTokenVector& changed) override;
 
     const CameraSummary& getSummary() const;
     bool                readSample(CameraData& dst, Time t);
@@ -6,8 +6,12 @@
 #include "usdiMesh.h"
 #include "usdiPoints.h"
 #include "usdiContext.h"
+#include "usdiPayloadManager.h"
+#include "usdiBakedCache.h"
+#include "usdiStageCache.h"
+#include "usdiTaskArena.h"
+#include "usdiOpenTask.h"
 #include "usdiUtils.h"
-#include "usdiRT/usdiRT.h"
 
 void mDetachAllThreads();
 
@@ -21,12 +25,38 @@ namespace fs =
     std::experimental::filesystem;
 #endif
 
-#define UsdSearchPathName "PXR_AR_DEFAULT_SEARCH_PATH"
-
 static int g_ctx_count;
+static std::mutex g_search_paths_mutex;
+static std::vector<std::string> g_search_paths;
+
+static void ApplyInterpolation(const UsdStageRefPtr& stage, InterpolationType v)
+{
+    switch (v) {
+    case InterpolationType::None: stage->SetInterpolationType(UsdInterpolationTypeHeld); break;
+    case InterpolationType::Linear: stage->SetInterpolationType(UsdInterpolationTypeLinear); break;
+    }
+}
+
+// asset path -> directory that contains it
+static std::string ToSearchPath(const char *path)
+{
+    fs::path fp{ path };
+    if (fp.has_extension()) {
+        fp.remove_filename();
+    }
+    return fp.string();
+}
+
+static void AddSearchPath(std::vector<std::string>& dst, const std::string& path)
+{
+    if (!path.empty() && std::find(dst.begin(), dst.end(), path) == dst.end()) {
+        dst.push_back(path);
+    }
+}
 
 
 Context::Context()
+    : m_task_arena(new TaskArena())
 {
     ++g_ctx_count;
 
@@ -37,6 +67,9 @@ Context::Context()
 Context::~Context()
 {
     initialize();
+    // payload worker may be running in the arena
+    m_payload_manager.reset();
+    m_task_arena.reset();
     usdiLogTrace("Context::~Context()\n");
     --g_ctx_count;
 }
@@ -48,18 +81,41 @@ bool Context::valid() const
 
 void Context::initialize()
 {
-    if (m_stage) {
+    if (m_payload_manager) {
+        m_payload_manager->clear();
+    }
+    TfNotice::Revoke(m_notice_key);
+    {
+        std::unique_lock<std::mutex> lock(m_changes_mutex);
+        m_resynced_paths.clear();
+        m_changed_paths.clear();
+    }
+    if (m_stage && !isStageShared()) {
         m_stage->Close();
     }
     m_stage = UsdStageRefPtr();
+    if (isStageShared()) {
+        StageCache::getInstance().release(m_stage_key);
+        m_stage_key.clear();
+    }
+    m_baked_cache.reset();
 
     // delete USD objects in reverse order
+    m_detached.clear();
+    m_detached_reported.clear();
     for (auto i = m_schemas.rbegin(); i != m_schemas.rend(); ++i) { i->reset(); }
     m_schemas.clear();
+    clearSchemaPools();
+    m_update_lists_dirty = true;
+    m_masters.clear();
+    m_root = nullptr;
+    clearIndex();
 
     m_id_seed = 0;
     m_start_time = 0.0;
     m_end_time = 0.0;
+    m_type_filter = (int)SchemaTypeFilter::All;
+    m_payload_policy = PayloadLoadPolicy::Default;
 }
 
 bool Context::createStage(const char *identifier)
@@ -82,10 +138,11 @@ bool Context::createStage(const char *identifier)
         }
     }
 
-    m_stage = UsdStage::CreateNew(identifier);
+    m_stage = UsdStage::CreateNew(identifier, makeResolverContext(identifier));
     if (m_stage) {
         usdiLogInfo("Context::createStage(): succeeded to create %s\n", identifier);
         rebuildSchemaTree();
+        listenNotices();
     }
     else {
         usdiLogInfo("Context::createStage(): failed to create %s\n", identifier);
@@ -96,39 +153,65 @@ bool Context::createStage(const char *identifier)
 
 void Context::applyImportConfig()
 {
-    if (!m_stage) { return; }
+    // interpolation of shared stage is decided by the context that opened it
+    if (!m_stage || isStageShared()) { return; }
 
-    switch (m_import_settings.interpolation) {
-    case InterpolationType::None: m_stage->SetInterpolationType(UsdInterpolationTypeHeld); break;
-    case InterpolationType::Linear: m_stage->SetInterpolationType(UsdInterpolationTypeLinear); break;
+    ApplyInterpolation(m_stage, m_import_settings.interpolation);
+}
+
+bool Context::isStageShared() const
+{
+    return !m_stage_key.empty();
+}
+
+bool Context::checkStageEditable(const char *caller) const
+{
+    if (isStageShared()) {
+        usdiLogError("%s: the stage is shared with other contexts and read-only\n", caller);
+        return false;
     }
+    return true;
 }
 
 void Context::addAssetSearchPath(const char *path)
 {
     if (!path) { return; }
 
-    auto *search_paths_ = GetEnv(UsdSearchPathName);
-    std::string search_paths = search_paths_ ? search_paths_ : "";
+    std::unique_lock<std::mutex> lock(g_search_paths_mutex);
+    AddSearchPath(g_search_paths, ToSearchPath(path));
+}
 
-    fs::path fp{ path };
-    if (fp.has_extension()) {
-        fp.remove_filename();
-    }
-    auto str = fp.string();
+void Context::clearAssetSearchPath()
+{
+    std::unique_lock<std::mutex> lock(g_search_paths_mutex);
+    g_search_paths.clear();
+}
 
-    if (search_paths.find(str.c_str(), 0, str.size()) == std::string::npos) {
-        if (!search_paths.empty()) {
-            search_paths += ":";
-        }
-        search_paths += str;
-        SetEnv(UsdSearchPathName, search_paths.c_str());
-    }
+void Context::addSearchPath(const char *path)
+{
+    if (!path) { return; }
+    AddSearchPath(m_search_paths, ToSearchPath(path));
 }
 
-void Context::clearAssetSearchPath()
+void Context::clearSearchPaths()
+{
+    m_search_paths.clear();
+}
+
+ArResolverContext Context::makeResolverContext(const char *path) const
 {
-    SetEnv(UsdSearchPathName, "");
+    std::vector<std::string> search_paths;
+    AddSearchPath(search_paths, ToSearchPath(path));
+    for (auto& p : m_search_paths) {
+        AddSearchPath(search_paths, p);
+    }
+    {
+        std::unique_lock<std::mutex> lock(g_search_paths_mutex);
+        for (auto& p : g_search_paths) {
+            AddSearchPath(search_paths, p);
+        }
+    }
+    return ArResolverContext(ArDefaultResolverContext(search_paths));
 }
 
 bool Context::convertUSDToAlembic(const char *src_usd, const char *dst_abc)
@@ -142,31 +225,120 @@ bool Context::convertUSDToAlembic(const char *src_usd, const char *dst_abc)
 }
 
 
-bool Context::open(const char *path)
+// open root layer and its sublayers recursively. resolver context must be bound.
+static void OpenLayerStack(const std::string& path, SdfLayerRefPtrVector& dst, OpenTask *task)
+{
+    if (task->isCanceled()) { return; }
+    auto layer = SdfLayer::FindOrOpen(path);
+    if (!layer || std::find(dst.begin(), dst.end(), layer) != dst.end()) { return; }
+    dst.push_back(layer);
+    task->addLayer();
+    for (const std::string& sub : layer->GetSubLayerPaths()) {
+        OpenLayerStack(SdfComputeAssetPathRelativeToLayer(layer, sub), dst, task);
+    }
+}
+
+bool Context::open(const char *path, const OpenSettings& settings, OpenTask *task)
 {
     initialize();
 
     usdiLogInfo( "Context::open(): %s\n", path);
 
-    // set USD's asset resolve paths
-    addAssetSearchPath(path);
+    m_type_filter = settings.type_filter;
+    m_payload_policy = settings.payload_policy;
 
-    m_stage = UsdStage::Open(path);
-    clearAssetSearchPath();
+    // excluded prims are never composed
+    UsdStagePopulationMask mask;
+    if (settings.prim_paths) {
+        for (int i = 0; i < settings.num_prim_paths; ++i) {
+            if (settings.prim_paths[i]) {
+                mask.Add(SdfPath(settings.prim_paths[i]));
+            }
+        }
+    }
+    auto load = m_payload_policy == PayloadLoadPolicy::LoadNone ? UsdStage::LoadNone : UsdStage::LoadAll;
+    // search paths are given by the resolver context of this stage, not by process-wide environment variable.
+    // so stages can be opened from multiple threads concurrently.
+    auto resolver_context = makeResolverContext(path);
+    auto open_stage = [&]() {
+        // async open loads layers before composition to report progress and check cancellation in between.
+        // composition finds them in the layer registry. they must be kept alive until then.
+        SdfLayerRefPtrVector layers;
+        if (task) {
+            task->setPhase(OpenPhase::LoadingLayers);
+            {
+                ArResolverContextBinder binder(resolver_context);
+                OpenLayerStack(path, layers, task);
+            }
+            if (task->isCanceled()) { return UsdStageRefPtr(); }
+            task->setPhase(OpenPhase::Composing);
+        }
+
+        auto open_ = [&]() {
+            return mask.IsEmpty() ?
+                UsdStage::Open(path, resolver_context, load) :
+                UsdStage::OpenMasked(path, resolver_context, mask, load);
+        };
+        auto ret = open_();
+        if (!ret) {
+            // first try to open .abc often fails (likely Windows-only problem)
+            // try again for workaround.
+            ret = open_();
+        }
+        return ret;
+    };
+
+    // cache resolved asset paths while opening and building schema tree.
+    // the same asset is typically referenced many times.
+    ArResolverScopedCache resolver_cache;
+
+    if (settings.share_stage) {
+        // composition depends on all of these
+        std::string key = path;
+        key += "\n" + std::to_string((int)load);
+        for (auto& p : mask.GetPaths()) {
+            key += "\n" + p.GetString();
+        }
+        key += "\n" + resolver_context.GetDebugString();
+
+        auto interpolation = m_import_settings.interpolation;
+        m_stage = StageCache::getInstance().acquire(key, [&]() {
+            auto ret = open_stage();
+            if (ret) { ApplyInterpolation(ret, interpolation); }
+            return ret;
+        });
+        if (m_stage) {
+            m_stage_key = key;
+        }
+    }
+    else {
+        m_stage = open_stage();
+    }
     if (!m_stage) {
-        // first try to open .abc often fails (likely Windows-only problem)
-        // try again for workaround.
-        m_stage = UsdStage::Open(path);
-        if (!m_stage) {
+        if (task && task->isCanceled()) {
+            usdiLogInfo("Context::open(): canceled %s\n", path);
+        }
+        else {
             usdiLogWarning("Context::open(): failed to load %s\n", path);
-            return false;
         }
+        return false;
     }
 
     applyImportConfig();
     m_start_time = m_stage->GetStartTimeCode();
     m_end_time = m_stage->GetEndTimeCode();
-    rebuildSchemaTree();
+    if (task) {
+        task->setPhase(OpenPhase::BuildingSchemas);
+    }
+    rebuildSchemaTree(task);
+    if (task && task->isCanceled()) {
+        usdiLogInfo("Context::open(): canceled %s\n", path);
+        // unpublish completed subtrees before destroying them
+        task->clearCompletedSubtrees();
+        initialize();
+        return false;
+    }
+    listenNotices();
     return true;
 }
 
@@ -233,13 +405,325 @@ Schema*         Context::getSchema(int i) const { return m_schemas[i].get(); }
 int             Context::getNumMasters() const  { return (int)m_masters.size(); }
 Schema*         Context::getMaster(int i) const { return m_masters[i]; }
 
-Schema* Context::findSchema(const char *path) const
+Schema* Context::findSchema(const char *path)
 {
-    if (auto *p = FindSchema(m_masters, path)) { return p; }
-    if (auto *p = FindSchema(m_schemas, path)) { return p; }
+    if (!path) { return nullptr; }
+
+    std::unique_lock<std::recursive_mutex> lock(m_mutex);
+    if (path[0] == '/') {
+        if (auto *ret = findIndexed(path)) { return ret; }
+        if (m_lazy_tree) { return materializePath(path); }
+    }
+    else {
+        auto it = m_name_index.find(path);
+        if (it != m_name_index.end() && !it->second.empty()) { return it->second.front(); }
+    }
     return nullptr;
 }
 
+Schema* Context::findChild(Schema *parent, const char *path, bool recursive)
+{
+    if (!parent || !path) { return nullptr; }
+
+    std::unique_lock<std::recursive_mutex> lock(m_mutex);
+    materializeChildren(parent);
+
+    auto is_child = [parent, recursive](const Schema *s) {
+        if (s->m_parent == parent) { return true; }
+        if (recursive) {
+            for (auto *p = s->m_parent; p; p = p->m_parent) {
+                if (p == parent) { return true; }
+            }
+        }
+        return false;
+    };
+
+    if (path[0] == '/') {
+        auto *ret = findIndexed(path);
+        if (!ret && m_lazy_tree && recursive) { ret = materializePath(path); }
+        return ret && is_child(ret) ? ret : nullptr;
+    }
+
+    auto find_by_name = [&]() -> Schema* {
+        auto it = m_name_index.find(path);
+        if (it == m_name_index.end()) { return nullptr; }
+        auto& candidates = it->second;
+
+        // direct children first. scan whichever is shorter (common names like "mesh" can have many candidates).
+        if (parent->m_children.size() < candidates.size()) {
+            for (auto *c : parent->m_children) {
+                if (strcmp(c->getName(), path) == 0) { return c; }
+            }
+        }
+        else {
+            for (auto *c : candidates) {
+                if (c->m_parent == parent) { return c; }
+            }
+        }
+        if (recursive) {
+            for (auto *c : candidates) {
+                if (is_child(c)) { return c; }
+            }
+        }
+        return nullptr;
+    };
+
+    auto *ret = find_by_name();
+    if (!ret && m_lazy_tree && recursive) {
+        // name can be anywhere in the subtree. there is no way but materializing all of it.
+        parent->eachChildR([](Schema*) {});
+        ret = find_by_name();
+    }
+    return ret;
+}
+
+Schema* Context::findIndexed(const std::string& path) const
+{
+    auto it = m_path_index.find(path);
+    return it != m_path_index.end() ? it->second : nullptr;
+}
+
+Schema* Context::materializePath(const std::string& path)
+{
+    for (;;) {
+        if (auto *ret = findIndexed(path)) { return ret; }
+
+        // find nearest ancestor that has schema.
+        // ancestors can be missing if excluded by type filter. in that case descendants are attached to upper one.
+        Schema *ancestor = nullptr;
+        std::string apath = path;
+        while (!ancestor) {
+            auto pos = apath.find_last_of('/');
+            if (pos == std::string::npos || apath.size() <= 1) { return nullptr; }
+            apath = pos == 0 ? std::string("/") : apath.substr(0, pos);
+            ancestor = findIndexed(apath);
+        }
+
+        // if the ancestor already has children, path doesn't exist or is excluded.
+        if (ancestor->m_children_materialized) { return nullptr; }
+        materializeChildren(ancestor);
+    }
+}
+
+bool Context::isExcluded(const UsdPrim& prim) const
+{
+    if (m_type_filter == (int)SchemaTypeFilter::All) { return false; }
+
+    // same order as schema handlers (most derived first)
+    SchemaTypeFilter type = SchemaTypeFilter::Other;
+    if (prim.IsA<UsdGeomMesh>()) { type = SchemaTypeFilter::Mesh; }
+    else if (prim.IsA<UsdGeomPoints>()) { type = SchemaTypeFilter::Points; }
+    else if (prim.IsA<UsdGeomCamera>()) { type = SchemaTypeFilter::Camera; }
+    else if (prim.IsA<UsdGeomXformable>()) { type = SchemaTypeFilter::Xform; }
+    return (m_type_filter & (int)type) == 0;
+}
+
+void Context::materializeChildren(Schema *schema)
+{
+    if (schema->m_children_materialized) { return; }
+
+    std::unique_lock<std::recursive_mutex> lock(m_mutex);
+    if (schema->m_children_materialized) { return; }
+
+    size_t num_existing = schema->m_children.size();
+    int id_base = m_id_seed;
+    buildChildren(schema);
+    m_id_seed = id_base;
+    auto& children = schema->m_children;
+    for (size_t i = num_existing; i < children.size(); ++i) {
+        registerSchemaTree(children[i]);
+    }
+}
+
+void Context::addToIndex(Schema *schema)
+{
+    // emplace() doesn't overwrite existing one. this keeps first registered one as result of findSchema() as before.
+    m_path_index.emplace(schema->getPath(), schema);
+    m_name_index[schema->getName()].push_back(schema);
+}
+
+void Context::removeFromIndex(Schema *schema)
+{
+    // prim may be already expired. take name from the path.
+    const auto& path = schema->m_path;
+    auto pit = m_path_index.find(path);
+    if (pit != m_path_index.end() && pit->second == schema) {
+        m_path_index.erase(pit);
+    }
+    auto nit = m_name_index.find(path.substr(path.find_last_of('/') + 1));
+    if (nit != m_name_index.end()) {
+        auto& v = nit->second;
+        v.erase(std::remove(v.begin(), v.end(), schema), v.end());
+        if (v.empty()) { m_name_index.erase(nit); }
+    }
+    for (auto *c : schema->m_children) {
+        removeFromIndex(c);
+    }
+}
+
+void Context::clearIndex()
+{
+    m_path_index.clear();
+    m_name_index.clear();
+}
+
+void Context::detachDeadChildren(Schema *schema)
+{
+    // schemas themselves are kept alive until the change is reported because user may still hold pointers to them.
+    // see destroyDetachedSchemas().
+    auto& children = schema->m_children;
+    children.erase(std::remove_if(children.begin(), children.end(), [this](Schema *c) {
+        if (c->m_prim.IsValid()) { return false; }
+        removeFromIndex(c);
+        m_detached.push_back(c);
+        m_update_lists_dirty = true;
+        return true;
+    }), children.end());
+}
+
+void Context::destroyDetachedSchemas()
+{
+    if (m_detached_reported.empty()) { return; }
+
+    std::unordered_set<Schema*> dead;
+    std::function<void(Schema*)> gather = [&](Schema *s) {
+        if (!dead.insert(s).second) { return; }
+        for (auto *c : s->m_children) { gather(c); }
+    };
+    for (auto *s : m_detached_reported) { gather(s); }
+    m_detached_reported.clear();
+
+    // requests of payloads in the subtrees are meaningless now
+    if (m_payload_manager) {
+        m_payload_manager->forgetSchemas(dead);
+    }
+    auto is_dead = [&dead](Schema *s) { return dead.find(s) != dead.end(); };
+    for (auto *s : dead) {
+        if (s->m_master && !is_dead(s->m_master)) {
+            auto& instances = s->m_master->m_instances;
+            instances.erase(std::remove(instances.begin(), instances.end(), s), instances.end());
+        }
+        for (auto *i : s->m_instances) {
+            if (!is_dead(i)) { i->m_master = nullptr; }
+        }
+    }
+    m_masters.erase(std::remove_if(m_masters.begin(), m_masters.end(), is_dead), m_masters.end());
+
+    // delete USD objects in reverse order. slots in the pools are reused by schemas created later.
+    for (auto i = m_schemas.rbegin(); i != m_schemas.rend(); ++i) {
+        if (is_dead(i->get())) { i->reset(); }
+    }
+    m_schemas.erase(std::remove_if(m_schemas.begin(), m_schemas.end(), [](const SchemaPtr& s) { return !s; }), m_schemas.end());
+    m_update_lists_dirty = true;
+}
+
+void Context::setConcurrencySettings(const ConcurrencySettings& v)
+{
+    // the arena is destroyed and re-created. nothing can be running on it.
+    if (m_async_opens > 0) {
+        usdiLogError("Context::setConcurrencySettings(): can't change while an asynchronous open is running\n");
+        return;
+    }
+    // the worker takes m_mutex to attach payloads. stop it before locking.
+    if (m_payload_manager) {
+        m_payload_manager->clear();
+    }
+    std::unique_lock<std::recursive_mutex> lock(m_mutex);
+    m_task_arena->setSettings(v);
+}
+
+const ConcurrencySettings& Context::getConcurrencySettings() const
+{
+    return m_task_arena->getSettings();
+}
+
+void Context::beginAsyncOpen()
+{
+    ++m_async_opens;
+}
+
+void Context::endAsyncOpen()
+{
+    --m_async_opens;
+}
+
+TaskArena& Context::getTaskArena()
+{
+    return *m_task_arena;
+}
+
+PayloadManager* Context::getPayloadManager()
+{
+    // loading / unloading payloads re-composes the stage under other contexts
+    if (!checkStageEditable("Context::getPayloadManager()")) { return nullptr; }
+    if (!m_payload_manager) {
+        m_payload_manager.reset(new PayloadManager(this));
+    }
+    return m_payload_manager.get();
+}
+
+void Context::attachPayload(Schema *schema)
+{
+    std::unique_lock<std::recursive_mutex> lock(m_mutex);
+
+    detachDeadChildren(schema);
+    schema->m_children_materialized = false;
+    if (!m_lazy_tree) {
+        materializeChildren(schema);
+    }
+    schema->updateFlagNext().payload_loaded = 1;
+}
+
+void Context::detachPayload(Schema *schema)
+{
+    std::unique_lock<std::recursive_mutex> lock(m_mutex);
+
+    detachDeadChildren(schema);
+    schema->updateFlagNext().payload_unloaded = 1;
+}
+
+bool Context::bake(const char *path, const Time *times, int num_times)
+{
+    // samples must be read from the stage
+    closeBakedCache();
+    return BakedCache::bake(this, path, times, num_times);
+}
+
+bool Context::openBakedCache(const char *path)
+{
+    std::unique_lock<std::recursive_mutex> lock(m_mutex);
+
+    closeBakedCache();
+    std::unique_ptr<BakedCache> cache(new BakedCache());
+    if (!cache->open(path)) { return false; }
+
+    m_baked_cache = std::move(cache);
+    for (auto& s : m_schemas) {
+        s->m_baked_entry = m_baked_cache->findEntry(s->m_path);
+    }
+    m_update_lists_dirty = true;
+    return true;
+}
+
+void Context::closeBakedCache()
+{
+    std::unique_lock<std::recursive_mutex> lock(m_mutex);
+
+    if (!m_baked_cache) { return; }
+    for (auto& s : m_schemas) {
+        s->m_baked_entry = -1;
+        // make sure samples are re-read from the stage
+        s->timePrev() = usdiInvalidTime;
+    }
+    m_baked_cache.reset();
+    m_update_lists_dirty = true;
+}
+
+const BakedCache* Context::getBakedCache() const
+{
+    return m_baked_cache.get();
+}
+
 
 void Context::addSchema(Schema *schema)
 {
@@ -249,7 +733,14 @@ void Context::addSchema(Schema *schema)
     }
     usdiLogTrace("Context::addSchema(): %s\n", schema->getName());
     schema->setup();
+    if (m_baked_cache) {
+        schema->m_baked_entry = m_baked_cache->findEntry(schema->m_path);
+    }
     m_schemas.emplace_back(schema);
+    m_update_lists_dirty = true;
+    addToIndex(schema);
+    if (schema->m_parent) { schema->m_parent->addChild(schema); }
+    if (schema->m_master) { schema->m_master->addInstance(schema); }
 }
 
 Schema* Context::createSchema(Schema *parent, const UsdPrim& prim)
@@ -261,54 +752,180 @@ Schema* Context::createSchema(Schema *parent, const UsdPrim& prim)
     return ret;
 }
 
-Schema* Context::createSchemaRecursive(Schema *parent, UsdPrim prim)
+template<class Body>
+static inline void EachChildPrim(size_t n, const Body& body)
 {
-    if (!prim.IsValid()) { return nullptr; }
+#ifdef usdiDbgForceSingleThread
+    for (size_t i = 0; i < n; ++i) { body(i); }
+#else
+    if (n <= 1) {
+        for (size_t i = 0; i < n; ++i) { body(i); }
+        return;
+    }
+    size_t grain = std::max<size_t>(n / 32, 1);
+    using range_t = tbb::blocked_range<size_t>;
+    tbb::parallel_for(range_t(0, n, grain), [&body](const range_t& r) {
+        for (size_t i = r.begin(); i != r.end(); ++i) {
+            body(i);
+        }
+    });
+#endif
+}
 
-    auto *ret = createSchema(parent, prim);
+Schema* Context::buildSchemaTree(Schema *parent, const UsdPrim& prim, bool instance_proxy)
+{
+    Schema *ret = nullptr;
+    if (instance_proxy) {
+        // masters are already registered at this point. so lookup is safe here.
+        Schema *master = findIndexed(prim.GetPath().GetString());
+
+        std::string path = parent ? parent->getPath() : "/";
+        if (path.back() != '/') {
+            path += '/';
+        }
+        path += prim.GetName();
 
-    // handling payload
-    if (m_import_settings.load_all_payloads && prim.HasPayload()) {
-        prim.Load();
+        ret = NewSchema<Schema>(this, parent, master, path, prim);
     }
+    else {
+        ret = CreateSchema(this, parent, prim);
+    }
+    if (!ret) { return nullptr; }
 
-    // handling instance
-    if (prim.IsInstance()) {
-        auto children = prim.GetMaster().GetChildren();
-        for (auto c : children) {
-            createInstanceSchemaRecursive(ret, c);
-        }
+    if (m_lazy_tree) {
+        // leave it to materializeChildren()
+        ret->m_children_materialized = false;
     }
     else {
-        auto children = prim.GetChildren();
-        for (auto c : children) {
-            createSchemaRecursive(ret, c);
+        buildChildren(ret);
+    }
+    return ret;
+}
+
+void Context::buildChildren(Schema *schema, OpenTask *task)
+{
+    struct ChildPrim
+    {
+        UsdPrim prim;
+        bool instance_proxy;
+    };
+    std::vector<ChildPrim> children;
+
+    // gather child prims. prims excluded by type filter don't have schemas and their children are gathered instead.
+    std::function<void(const UsdPrim&, bool)> gather = [&](const UsdPrim& prim, bool proxy) {
+        // handling instance
+        bool instance = !proxy && prim.IsInstance();
+        auto range = instance ? prim.GetMaster().GetChildren() : prim.GetChildren();
+        for (auto c : range) {
+            if (isExcluded(c)) {
+                gather(c, proxy || instance);
+            }
+            else {
+                children.push_back({ c, proxy || instance });
+            }
+        }
+    };
+    gather(schema->m_prim, schema->m_instance_proxy);
+
+    // schemas created by createSchema() before materialization are already linked. keep them.
+    auto& dst = schema->m_children;
+    size_t num_existing = dst.size();
+    if (num_existing > 0) {
+        children.erase(std::remove_if(children.begin(), children.end(), [&dst](const ChildPrim& c) {
+            for (auto *e : dst) {
+                if (e->m_prim.GetName() == c.prim.GetName()) { return true; }
+            }
+            return false;
+        }), children.end());
+    }
+
+    if (m_lazy_tree) {
+        // make sure counterparts in master are materialized. it can't be done on worker threads.
+        for (auto& c : children) {
+            if (c.instance_proxy) {
+                materializePath(c.prim.GetPath().GetString());
+            }
+        }
+    }
+
+    // each child writes its own slot. this keeps order of children same as prim's.
+    dst.resize(num_existing + children.size());
+    if (task) {
+        // subtrees are built in parallel internally and registered one by one in order.
+        // so IDs and order of schemas are same as serial construction.
+        for (size_t i = 0; i < children.size() && !task->isCanceled(); ++i) {
+            int id_base = m_id_seed;
+            auto *c = buildSchemaTree(schema, children[i].prim, children[i].instance_proxy);
+            dst[num_existing + i] = c;
+            if (c) {
+                m_id_seed = id_base;
+                registerSchemaTree(c);
+                task->addCompletedSubtree(c, getNumSchemas());
+            }
+            task->setPhaseProgress(float(i + 1) / float(children.size()));
         }
     }
+    else {
+        m_task_arena->execute([&]() {
+            EachChildPrim(children.size(), [&](size_t i) {
+                dst[num_existing + i] = buildSchemaTree(schema, children[i].prim, children[i].instance_proxy);
+            });
+        });
+    }
+    dst.erase(std::remove(dst.begin(), dst.end(), nullptr), dst.end());
+    schema->m_children_materialized = true;
+}
+
+void Context::registerSchemaTree(Schema *schema)
+{
+    // pre-order, same as serial construction.
+    // IDs given by constructors depend on thread scheduling. re-assign them here.
+    if (schema->m_id != 0) {
+        schema->m_id = generateID();
+    }
+    usdiLogTrace("Context::registerSchemaTree(): %s\n", schema->getName());
+    schema->setup();
+    m_schemas.emplace_back(schema);
+    m_update_lists_dirty = true;
+    addToIndex(schema);
+    if (schema->m_master) { schema->m_master->addInstance(schema); }
+
+    for (auto *c : schema->m_children) {
+        registerSchemaTree(c);
+    }
+}
+
+Schema* Context::createSchemaRecursive(Schema *parent, UsdPrim prim)
+{
+    if (!prim.IsValid()) { return nullptr; }
+
+    int id_base = m_id_seed;
+    auto *ret = buildSchemaTree(parent, prim, false);
+    if (ret) {
+        m_id_seed = id_base;
+        registerSchemaTree(ret);
+        if (parent) { parent->addChild(ret); }
+    }
     return ret;
 }
 
 Schema* Context::createInstanceSchema(Schema *parent, Schema *master, const std::string& path, UsdPrim prim)
 {
-    auto *ret = new Schema(this, parent, master, path, prim);
+    auto *ret = NewSchema<Schema>(this, parent, master, path, prim);
     addSchema(ret);
     return ret;
 }
 
 Schema* Context::createInstanceSchemaRecursive(Schema *parent, UsdPrim prim)
 {
-    Schema *master = findSchema(prim.GetPath().GetText());
-
-    std::string path = parent ? parent->getPath() : "/";
-    if (path.back() != '/') {
-        path += '/';
-    }
-    path += prim.GetName();
+    if (!prim.IsValid()) { return nullptr; }
 
-    auto *ret = createInstanceSchema(parent, master, path, prim);
-    auto children = prim.GetChildren();
-    for (auto c : children) {
-        createInstanceSchemaRecursive(ret, c);
+    int id_base = m_id_seed;
+    auto *ret = buildSchemaTree(parent, prim, true);
+    if (ret) {
+        m_id_seed = id_base;
+        registerSchemaTree(ret);
+        if (parent) { parent->addChild(ret); }
     }
     return ret;
 }
@@ -323,9 +940,11 @@ Schema* Context::createOverride(const char *prim_path)
     if (auto *p = findSchema(prim_path)) {
         return p;
     }
+    if (!checkStageEditable("Context::createOverride()")) { return nullptr; }
 
+    NoticeBlocker blocker(this);
     if (auto prim = m_stage->OverridePrim(SdfPath(prim_path))) {
-        auto *ret = new Schema(this, nullptr, prim);
+        auto *ret = NewSchema<Schema>(this, nullptr, prim);
         addSchema(ret);
         return ret;
     }
@@ -338,6 +957,7 @@ void Context::flatten()
         usdiLogError("Context::flatten(): m_stage is null\n");
         return;
     }
+    if (!checkStageEditable("Context::flatten()")) { return; }
 
     m_stage->Flatten();
 }
@@ -357,22 +977,64 @@ void Context::endEdit()
     }
 }
 
-void Context::rebuildSchemaTree()
+void Context::rebuildSchemaTree(OpenTask *task)
 {
+    std::unique_lock<std::recursive_mutex> lock(m_mutex);
+    NoticeBlocker blocker(this);
+    {
+        // the tree is built from current state of the stage
+        std::unique_lock<std::mutex> lock(m_changes_mutex);
+        m_resynced_paths.clear();
+        m_changed_paths.clear();
+    }
+
+    if (m_payload_manager) {
+        m_payload_manager->clear();
+    }
+    m_lazy_tree = m_import_settings.lazy_schema_tree;
     m_masters.clear();
+    m_detached.clear();
+    m_detached_reported.clear();
     m_schemas.clear();
+    clearSchemaPools();
+    m_update_lists_dirty = true;
     m_root = nullptr;
     m_id_seed = 0;
+    clearIndex();
+
+    // load payloads before building tree. loading payload changes composition and
+    // it can't be done while worker threads are traversing prims.
+    bool load_payloads = m_payload_policy == PayloadLoadPolicy::LoadAll ||
+        (m_payload_policy == PayloadLoadPolicy::Default && m_import_settings.load_all_payloads);
+    // shared stage is opened with all payloads loaded unless LoadNone. it must not be modified here.
+    if (load_payloads && !isStageShared()) {
+        m_stage->Load(SdfPath::AbsoluteRootPath());
+    }
 
+    // masters are built one by one because instances in a master may refer preceding masters.
     {
         auto masters = m_stage->GetMasters();
         for (auto& m : masters) {
+            if (task && task->isCanceled()) { return; }
             m_masters.push_back(createSchemaRecursive(nullptr, m));
         }
     }
     {
         auto root_prim = m_stage->GetPseudoRoot();
-        if (root_prim.IsValid()) {
+        if (!root_prim.IsValid()) {
+            // nothing to do
+        }
+        else if (task && !m_lazy_tree) {
+            // register the root first and then subtrees under it one by one, so that completed ones can be used early.
+            int id_base = m_id_seed;
+            m_root = CreateSchema(this, nullptr, root_prim);
+            if (m_root) {
+                m_id_seed = id_base;
+                registerSchemaTree(m_root);
+                buildChildren(m_root, task);
+            }
+        }
+        else {
             m_root = createSchemaRecursive(nullptr, root_prim);
         }
     }
@@ -390,25 +1052,273 @@ void Context::notifyForceUpdate()
     }
 }
 
-void Context::updateAllSamples(Time t)
+void* AllocateSchema(Context *ctx, const std::type_info& type, size_t size, SchemaUpdateStates *&states, int& slot)
 {
-#ifdef usdiDbgForceSingleThread
-    for (auto& s : m_schemas) {
-        s->updateSample(t);
+    return ctx->allocateSchema(type, size, states, slot);
+}
+
+void* Context::allocateSchema(const std::type_info& type, size_t size, SchemaUpdateStates *&states, int& slot)
+{
+    SchemaPool *pool = nullptr;
+    {
+        std::unique_lock<std::mutex> lock(m_schema_pools_mutex);
+        for (auto& p : m_schema_pools) {
+            if (p->getType() == type) { pool = p.get(); break; }
+        }
+        if (!pool) {
+            m_schema_pools.emplace_back(new SchemaPool(type, size));
+            pool = m_schema_pools.back().get();
+        }
+    }
+    return pool->allocate(states, slot);
+}
+
+void Context::freeSchema(const std::type_info& type, SchemaUpdateStates *states, int slot)
+{
+    std::unique_lock<std::mutex> lock(m_schema_pools_mutex);
+    for (auto& p : m_schema_pools) {
+        if (p->getType() == type) {
+            p->free(states, slot);
+            return;
+        }
     }
+}
+
+void Context::clearSchemaPools()
+{
+    // all schemas must be destroyed at this point
+    std::unique_lock<std::mutex> lock(m_schema_pools_mutex);
+    m_update_lists.clear();
+    m_update_lists_dirty = true;
+    m_schema_pools.clear();
+}
+
+template<class T> static inline void UpdateSchema(Schema *s, Time t) { static_cast<T*>(s)->T::updateSample(t); }
+template<> inline void UpdateSchema<Schema>(Schema *s, Time t) { s->updateSample(t); }
+
+// schemas in the pool have exactly the same type T (Schema: any other type. dispatched virtually).
+// schemas that have nothing to update are skipped by looking at SchemaUpdateStates only.
+template<class T>
+static void UpdateSchemaList(const SchemaPool& pool, const SchemaPool::Slots& slots, Time t)
+{
+    auto body = [&pool, &slots, t](size_t i) {
+        const auto& slot = slots[i];
+        auto& states = slot.block->states;
+        int si = slot.index;
+        if (states.isUpToDate(si, t)) {
+            // this is all Schema::updateSample() would do
+            states.flags_prev[si].bits = 0;
+            states.time_prev[si] = t;
+            return;
+        }
+        UpdateSchema<T>(pool.getObject(*slot.block, si), t);
+    };
+
+    size_t n = slots.size();
+#ifdef usdiDbgForceSingleThread
+    for (size_t i = 0; i < n; ++i) { body(i); }
 #else
-    size_t grain = std::max<size_t>(m_schemas.size() / 32, 1);
+    // cost per schema varies a lot (a mesh vs. an up-to-date xform). keep chunks small so that they are balanced.
+    size_t grain = std::max<size_t>(n / 32, 1);
     using range_t = tbb::blocked_range<size_t>;
-    tbb::parallel_for(range_t(0, m_schemas.size(), grain), [t, this](const range_t& r) {
+    tbb::parallel_for(range_t(0, n, grain), [&body](const range_t& r) {
         for (size_t i = r.begin(); i != r.end(); ++i) {
-            m_schemas[i]->updateSample(t);
+            body(i);
         }
     });
 #endif
 }
 
+void Context::listenNotices()
+{
+    TfNotice::Revoke(m_notice_key);
+    m_notice_key = TfNotice::Register(TfCreateWeakPtr(this), &Context::onObjectsChanged, UsdStageWeakPtr(m_stage));
+}
+
+void Context::onObjectsChanged(const UsdNotice::ObjectsChanged& notice, const UsdStageWeakPtr& sender)
+{
+    // this can be called from any thread that edits the stage. just record paths here.
+    if (m_notice_block > 0) { return; }
+
+    std::unique_lock<std::mutex> lock(m_changes_mutex);
+    for (const auto& path : notice.GetResyncedPaths()) {
+        m_resynced_paths.push_back(path);
+    }
+    for (const auto& path : notice.GetChangedInfoOnlyPaths()) {
+        m_changed_paths.push_back(path);
+    }
+}
+
+void Context::resyncSubtree(Schema *schema)
+{
+    // prims under resynced path are re-composed and old handles are expired
+    if (schema->m_instance_proxy) {
+        if (schema->m_master) {
+            schema->m_prim = schema->m_master->m_prim;
+        }
+    }
+    else {
+        schema->m_prim = m_stage->GetPrimAtPath(SdfPath(schema->m_path));
+    }
+    detachDeadChildren(schema);
+    schema->resync(true, TfTokenVector());
+
+    auto children = schema->m_children;
+    if (schema->m_children_materialized) {
+        // pick up added children. existing ones are kept.
+        schema->m_children_materialized = false;
+        if (!m_lazy_tree) {
+            materializeChildren(schema);
+        }
+    }
+    for (auto *c : children) {
+        resyncSubtree(c);
+    }
+}
+
+void Context::processChanges()
+{
+    SdfPathVector resynced, changed;
+    {
+        std::unique_lock<std::mutex> lock(m_changes_mutex);
+        resynced.swap(m_resynced_paths);
+        changed.swap(m_changed_paths);
+    }
+    if (!m_stage || (resynced.empty() && changed.empty())) { return; }
+
+    std::unique_lock<std::recursive_mutex> lock(m_mutex);
+    NoticeBlocker blocker(this);
+
+    // changed attributes per schema. all: the prim itself is changed (metadata etc).
+    struct Changes
+    {
+        bool all = false;
+        TfTokenVector names;
+    };
+    using ChangesMap = std::map<Schema*, Changes>;
+    auto add_change = [this](ChangesMap& dst, const SdfPath& path) {
+        if (auto *s = findIndexed(path.GetPrimPath().GetString())) {
+            auto& c = dst[s];
+            if (path.IsPropertyPath()) { c.names.push_back(path.GetNameToken()); }
+            else { c.all = true; }
+        }
+    };
+    auto resync = [](ChangesMap& changes, bool attributes) {
+        for (auto& kvp : changes) {
+            kvp.first->resync(attributes, kvp.second.all ? TfTokenVector() : kvp.second.names);
+        }
+    };
+
+    // structural changes. subtrees of nearest schemas are re-synced.
+    SdfPath::RemoveDescendentPaths(&resynced);
+    ChangesMap added_or_removed;
+    for (auto& path : resynced) {
+        if (path.IsPropertyPath()) {
+            // attribute is added or removed
+            add_change(added_or_removed, path);
+            continue;
+        }
+
+        // prims excluded by type filter, not materialized or removed have no (valid) schema. go up.
+        Schema *schema = nullptr;
+        for (auto p = path; !p.IsEmpty(); p = p.GetParentPath()) {
+            auto *s = findIndexed(p.GetString());
+            if (s && (s->m_prim.IsValid() || s->m_instance_proxy)) {
+                schema = s;
+                break;
+            }
+        }
+        if (schema) {
+            resyncSubtree(schema);
+        }
+    }
+
+    resync(added_or_removed, true);
+
+    // value or metadata changes. only time ranges and cached samples of the schemas need update
+    // (and topology of meshes if counts or indices are edited).
+    ChangesMap edited;
+    for (auto& path : changed) {
+        add_change(edited, path);
+    }
+    resync(edited, false);
+}
+
+void Context::updateAllSamples(Time t)
+{
+    // schemas can be added by materialization. wait for it.
+    std::unique_lock<std::recursive_mutex> lock(m_mutex);
+
+    // subtrees whose detachment was reported by the previous update
+    destroyDetachedSchemas();
+    processChanges();
+
+    // nothing else is accessing the stage here. compose payloads loaded in background.
+    if (m_payload_manager) {
+        m_payload_manager->update();
+    }
+
+    if (m_update_lists_dirty) {
+        buildUpdateLists();
+    }
+
+    // schemas don't depend on each other. all types are updated concurrently.
+    m_task_arena->execute([&]() {
+        auto body = [this, t](size_t i) {
+            auto& l = m_update_lists[i];
+            l.update(*l.pool, l.slots, t);
+        };
+#ifdef usdiDbgForceSingleThread
+        for (size_t i = 0; i < m_update_lists.size(); ++i) { body(i); }
+#else
+        tbb::parallel_for(size_t(0), m_update_lists.size(), body);
+#endif
+    });
+
+    // parents of these have reported the change by now. destroyed by next update.
+    m_detached_reported.insert(m_detached_reported.end(), m_detached.begin(), m_detached.end());
+    m_detached.clear();
+}
+
+void Context::buildUpdateLists()
+{
+    m_update_lists.clear();
+    for (auto& p : m_schema_pools) {
+        UpdateList l;
+        l.pool = p.get();
+        const auto& type = p->getType();
+        if (type == typeid(Xform))       { l.update = &UpdateSchemaList<Xform>; }
+        else if (type == typeid(Camera)) { l.update = &UpdateSchemaList<Camera>; }
+        else if (type == typeid(Mesh))   { l.update = &UpdateSchemaList<Mesh>; }
+        else if (type == typeid(Points)) { l.update = &UpdateSchemaList<Points>; }
+        else                             { l.update = &UpdateSchemaList<Schema>; }
+        m_update_lists.push_back(std::move(l));
+    }
+
+    for (auto& sp : m_schemas) {
+        auto *s = sp.get();
+        // baked schemas are read directly from the cache. nothing to do here.
+        if (s->m_baked_entry >= 0) { continue; }
+        // schemas detached by resync are still in m_schemas until destroyed. skip them.
+        if (!s->m_prim.IsValid()) { continue; }
+
+        const auto& type = typeid(*s);
+        for (auto& l : m_update_lists) {
+            if (l.pool->getType() == type) {
+                l.slots.push_back({ SchemaPool::getBlockOf(s->m_states), s->m_slot });
+                break;
+            }
+        }
+    }
+    m_update_lists.erase(std::remove_if(m_update_lists.begin(), m_update_lists.end(),
+        [](const UpdateList& l) { return l.slots.empty(); }), m_update_lists.end());
+    m_update_lists_dirty = false;
+}
+
 int Context::eachTimeSample(const TimeSampleCallback& cb)
 {
+    std::unique_lock<std::recursive_mutex> lock(m_mutex);
+
     using Times = std::set<Time>;
     tls<Times> times;
 
@@ -438,12 +1348,14 @@ int Context::eachTimeSample(const TimeSampleCallback& cb)
         }
     };
 
-    size_t grain = std::max<size_t>(m_schemas.size() / 32, 1);
-    using range_t = tbb::blocked_range<size_t>;
-    tbb::parallel_for(range_t(0, m_schemas.size(), grain), [this, &gather_times](const range_t& r) {
-        for (size_t i = r.begin(); i != r.end(); ++i) {
-            gather_times(m_schemas[i].get());
-        }
+    m_task_arena->execute([&]() {
+        size_t grain = std::max<size_t>(m_schemas.size() / 32, 1);
+        using range_t = tbb::blocked_range<size_t>;
+        tbb::parallel_for(range_t(0, m_schemas.size(), grain), [this, &gather_times](const range_t& r) {
+            for (size_t i = r.begin(); i != r.end(); ++i) {
+                gather_times(m_schemas[i].get());
+            }
+        });
     });
 
     Times merged;
@@ -474,7 +1386,10 @@ static void precomputeNormalsAllImpl(Schema *schema, bool gen_tangents, bool ove
 }
 void Context::precomputeNormalsAll(bool gen_tangents, bool overwrite, const precomputeNormalsCallback& cb)
 {
-    precomputeNormalsAllImpl(getRoot(), gen_tangents, overwrite, cb);
+    if (!checkStageEditable("Context::precomputeNormalsAll()")) { return; }
+    m_task_arena->execute([&]() {
+        precomputeNormalsAllImpl(getRoot(), gen_tangents, overwrite, cb);
+    });
 }
 
 } // namespace usdi
@@ -2,9 +2,25 @@
 
 namespace usdi {
 
-class Context
+class PayloadManager;
+class BakedCache;
+class TaskArena;
+
+class Context : public TfWeakBase
 {
 public:
+    // structural changes made by Context itself are reflected to the schema tree directly.
+    // change notices from the stage are ignored while this is alive.
+    class NoticeBlocker
+    {
+    public:
+        NoticeBlocker(Context *ctx) : m_ctx(ctx) { ++m_ctx->m_notice_block; }
+        ~NoticeBlocker() { --m_ctx->m_notice_block; }
+    private:
+        Context *m_ctx;
+    };
+
+    // search paths shared by all contexts. these are used by subsequent open() / createStage().
     static void addAssetSearchPath(const char *path);
     static void clearAssetSearchPath();
 
@@ -16,8 +32,12 @@ public:
 
     bool                valid() const;
     void                initialize();
+    // search paths of this context. used in addition to global ones by subsequent open() / createStage().
+    void                addSearchPath(const char *path);
+    void                clearSearchPaths();
     bool                createStage(const char *identifier);
-    bool                open(const char *path);
+    // if task is given, progress is reported to it and it can cancel open. see OpenTask.
+    bool                open(const char *path, const OpenSettings& settings = OpenSettings(), OpenTask *task = nullptr);
     bool                save() const;
     // path must *not* be same as identifier (parameter of createStage() or open())
     bool                saveAs(const char *path) const;
@@ -28,17 +48,53 @@ public:
     void                    setExportSettings(const ExportSettings& v);
 
     UsdStageRefPtr      getUsdStage() const;
+    // shared stage (OpenSettings::share_stage) is read-only.
+    bool                isStageShared() const;
+    // log error and return false if the stage is shared. caller is used in the message.
+    bool                checkStageEditable(const char *caller) const;
     Schema*             getRoot() const;
     int                 getNumSchemas() const;
     Schema*             getSchema(int i) const;
     int                 getNumMasters() const;
     Schema*             getMaster(int i) const;
-    Schema*             findSchema(const char *path) const;
+    // path_or_name: absolute path if starts with '/'. otherwise name.
+    // in lazy mode (ImportSettings::lazy_schema_tree), path lookup materializes ancestors of the path.
+    // name lookup only finds materialized schemas.
+    Schema*             findSchema(const char *path_or_name);
+    // find child of parent (or descendant if recursive) by path or name.
+    Schema*             findChild(Schema *parent, const char *path_or_name, bool recursive);
+    // create children of schema if not yet. only meaningful in lazy mode.
+    void                materializeChildren(Schema *schema);
+
+    // async payload loading. created on first call. null if the stage is shared.
+    PayloadManager*     getPayloadManager();
+
+    // re-creates the task arena. payload streaming is stopped and reset (PayloadManager::clear()).
+    // refused while an asynchronous open is running.
+    void                setConcurrencySettings(const ConcurrencySettings& v);
+    const ConcurrencySettings& getConcurrencySettings() const;
+    // called by OpenTask while it is queued or running on the arena
+    void                beginAsyncOpen();
+    void                endAsyncOpen();
+    // parallel work of this context must run in this arena
+    TaskArena&          getTaskArena();
+    // link subtree of payload that is just loaded / unloaded to the schema tree.
+    // unlinked subtrees are destroyed in the updateAllSamples() after the one that reports payload_unloaded.
+    void                attachPayload(Schema *schema);
+    void                detachPayload(Schema *schema);
+
+    // baked playback cache (see BakedCache). if times is null, all time samples are baked.
+    bool                bake(const char *path, const Time *times, int num_times);
+    // while the cache is open, Xform / Mesh / Points in it are read from the cache and not updated from the stage.
+    bool                openBakedCache(const char *path);
+    void                closeBakedCache();
+    const BakedCache*   getBakedCache() const;
 
     // SchemaType: Xform, Camera, Mesh, etc
     template<class SchemaType>
     SchemaType*         createSchema(Schema *parent, const char *name);
     Schema*             createSchema(Schema *parent, const UsdPrim& prim);
+    // subtrees are built in parallel. resulting order and IDs of schemas are same as serial construction.
     Schema*             createSchemaRecursive(Schema *parent, UsdPrim prim);
     Schema*             createInstanceSchema(Schema *parent, Schema *master, const std::string& path, UsdPrim prim);
     Schema*             createInstanceSchemaRecursive(Schema *parent, UsdPrim prim);
@@ -48,9 +104,12 @@ public:
     void                beginEdit(const UsdEditTarget& t);
     void                endEdit();
 
-    void                rebuildSchemaTree();
+    void                rebuildSchemaTree(OpenTask *task = nullptr);
     int                 generateID();
     void                notifyForceUpdate();
+    // apply changes of the stage notified by UsdNotice::ObjectsChanged.
+    // only schemas under changed paths are re-synced. updateAllSamples() calls this.
+    void                processChanges();
     void                updateAllSamples(Time t);
 
     using TimeSampleCallback = std::function<void(Time t)>;
@@ -59,28 +118,98 @@ public:
     using precomputeNormalsCallback = std::function<void(Mesh*, bool)>;
     void                precomputeNormalsAll(bool gen_tangents, bool overwrite, const precomputeNormalsCallback& cb);
 
+    // memory for schemas. use NewSchema() instead of calling this directly. thread-safe.
+    void*               allocateSchema(const std::type_info& type, size_t size, SchemaUpdateStates *&states, int& slot);
+    // called by SchemaDeleter
+    void                freeSchema(const std::type_info& type, SchemaUpdateStates *states, int slot);
+
 private:
     void    addSchema(Schema *schema);
     void    applyImportConfig();
+    // each context has its own resolver context. directory of path comes first.
+    ArResolverContext makeResolverContext(const char *path) const;
+
+    // build*() can be called from multiple threads. these create schemas and link children but don't register them.
+    // registerSchemaTree() must be called from single thread after build.
+    Schema* buildSchemaTree(Schema *parent, const UsdPrim& prim, bool instance_proxy);
+    // if task is given, subtrees are built and registered one by one (see rebuildSchemaTree())
+    void    buildChildren(Schema *schema, OpenTask *task = nullptr);
+    void    registerSchemaTree(Schema *schema);
+    Schema* findIndexed(const std::string& path) const;
+    Schema* materializePath(const std::string& path);
+    bool    isExcluded(const UsdPrim& prim) const;
+    void    addToIndex(Schema *schema);
+    void    removeFromIndex(Schema *schema); // recursive
+    void    detachDeadChildren(Schema *schema);
+    void    destroyDetachedSchemas();
+    void    resyncSubtree(Schema *schema);
+    void    listenNotices();
+    void    onObjectsChanged(const UsdNotice::ObjectsChanged& notice, const UsdStageWeakPtr& sender);
+    void    clearIndex();
+    void    buildUpdateLists();
+    void    clearSchemaPools();
 
 private:
-    using SchemaPtr = std::unique_ptr<Schema>;
+    using SchemaPoolPtr = std::unique_ptr<SchemaPool>;
+    using SchemaPools = std::vector<SchemaPoolPtr>;
+    using SchemaPtr = std::unique_ptr<Schema, SchemaDeleter>;
     using Schemas = std::vector<SchemaPtr>;
     using Masters = std::vector<Schema*>;
     using EditTargets = std::vector<UsdEditTarget>;
+    using PathIndex = std::unordered_map<std::string, Schema*>;
+    // name -> schemas. schemas that have same name are stored in registration order
+    using NameIndex = std::unordered_map<std::string, std::vector<Schema*>>;
 
     UsdStageRefPtr  m_stage;
+    std::string     m_stage_key; // key in StageCache if the stage is shared
+    std::vector<std::string> m_search_paths;
+    // one pool per concrete schema type. must be declared before m_schemas (schemas are destroyed first)
+    SchemaPools     m_schema_pools;
+    std::mutex      m_schema_pools_mutex;
     Schemas         m_schemas;
     Schema*         m_root = nullptr;
     Masters         m_masters;
+    PathIndex       m_path_index;
+    NameIndex       m_name_index;
+
+    // roots of subtrees unlinked by detachDeadChildren(). destroyed by the second updateAllSamples() after that,
+    // so that the update that reports the change (payload_unloaded etc) to the parent runs in between.
+    std::vector<Schema*> m_detached;
+    std::vector<Schema*> m_detached_reported;
+
+    // slots of schemas to update in a pool. all of them have the same type, so update is a non-virtual call.
+    struct UpdateList
+    {
+        SchemaPool *pool = nullptr;
+        void (*update)(const SchemaPool& pool, const SchemaPool::Slots& slots, Time t) = nullptr;
+        SchemaPool::Slots slots;
+    };
+    std::vector<UpdateList> m_update_lists;
+    // true if m_update_lists need to be rebuilt (schemas are added, baked, detached or destroyed)
+    std::atomic_bool m_update_lists_dirty = { true };
 
     ImportSettings  m_import_settings;
     ExportSettings  m_export_settings;
-
-    int             m_id_seed = 0;
+    int             m_type_filter = (int)SchemaTypeFilter::All;
+    PayloadLoadPolicy m_payload_policy = PayloadLoadPolicy::Default;
+
+    std::atomic_int m_id_seed = { 0 };
+    std::atomic_int m_async_opens = { 0 };
+    bool            m_lazy_tree = false;
+    // guards schema list and indices while materializing
+    std::recursive_mutex m_mutex;
     double          m_start_time = 0.0;
     double          m_end_time = 0.0;
     EditTargets     m_edit_targets;
+    std::unique_ptr<TaskArena> m_task_arena;
+    std::unique_ptr<PayloadManager> m_payload_manager;
+    std::unique_ptr<BakedCache> m_baked_cache;
+
+    TfNotice::Key   m_notice_key;
+    std::atomic_int m_notice_block = { 0 };
+    std::mutex      m_changes_mutex;
+    SdfPathVector   m_resynced_paths;
+    SdfPathVector   m_changed_paths;
 };
 
 } // namespace usdi
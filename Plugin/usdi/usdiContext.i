@@ -3,9 +3,10 @@ namespace usdi {
 template<class T>
 T* Context::createSchema(Schema *parent, const char *name)
 {
-    T *ret = new T(this, parent, name);
+    if (!checkStageEditable("Context::createSchema()")) { return nullptr; }
+    NoticeBlocker blocker(this);
+    T *ret = NewSchema<T>(this, parent, name);
     addSchema(ret);
-    if (parent) { parent->addChild(ret); }
     return ret;
 }
 
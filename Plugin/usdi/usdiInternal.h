@@ -40,6 +40,7 @@ namespace usdi {
     using namespace mu;
 
     class Context;
+    class OpenTask;
     class Attribute;
     class Schema;
     class Xform;
@@ -97,5 +98,102 @@ inline IArray<float> ToIArray(const VtArray<float>& v) { return{ (float*)v.cdata
 inline IArray<float2> ToIArray(const VtArray<GfVec2f>& v) { return{ (float2*)v.cdata(), v.size() }; }
 inline IArray<float3> ToIArray(const VtArray<GfVec3f>& v) { return{ (float3*)v.cdata(), v.size() }; }
 inline IArray<float4> ToIArray(const VtArray<GfVec4f>& v) { return{ (float4*)v.cdata(), v.size() }; }
+// usdi::Weights and mu::Weights have the same layout
+template<int N> inline IArray<mu::Weights<N>> ToIArray(const VtArray<Weights<N>>& v) { return{ (mu::Weights<N>*)v.cdata(), v.size() }; }
+// data() detaches shared buffer of VtArray before writing
+template<int N> inline IArray<mu::Weights<N>> ToWritableIArray(VtArray<Weights<N>>& v) { return{ (mu::Weights<N>*)v.data(), v.size() }; }
+
+// lock-free multiple buffering of samples.
+// the writer (updateSample()) fills a buffer that is neither the latest one nor acquired by readers,
+// and publishes it atomically. readers acquire the latest published buffer.
+// acquired buffer is never overwritten until it is released.
+// buffers are allocated on demand. usually 2 or 3 buffers are enough.
+// only one writer is allowed at a time. any number of readers are allowed.
+template<class T>
+class SampleBuffer
+{
+public:
+    static const int MaxBuffers = 8;
+    // how many times beginWrite() yields waiting for readers to release a buffer before giving up
+    static const int MaxWaitCount = 1000;
+    // handle of samples that are not in this buffer (e.g. baked cache). release() ignores it.
+    static const int ExternalHandle = MaxBuffers;
+
+    SampleBuffer()
+    {
+        for (auto& r : m_readers) { r = 0; }
+    }
+
+    // writer side. return null if all buffers are held by readers for too long.
+    // in_place: reuse the latest buffer if no one is reading it (no double buffering).
+    //   the buffer is unpublished while it is written. readers get nothing until endWrite().
+    T* beginWrite(bool in_place)
+    {
+        int latest = m_latest;
+        if (in_place && latest >= 0) {
+            // unpublish first so that no reader can acquire it after the check below.
+            // a reader that got it before is seen by the check. (acquire() re-checks m_latest after counting itself)
+            m_latest = -1;
+            if (m_readers[latest] == 0) {
+                m_writing = latest;
+                return m_buffers[latest].get();
+            }
+            // someone is reading it. re-publish and fall back to double buffering.
+            m_latest = latest;
+        }
+        for (int wait = 0; wait < MaxWaitCount; ++wait) {
+            for (int i = 0; i < MaxBuffers; ++i) {
+                if (i == latest) { continue; }
+                if (!m_buffers[i]) { m_buffers[i].reset(new T()); }
+                if (m_readers[i] == 0) {
+                    m_writing = i;
+                    return m_buffers[i].get();
+                }
+            }
+            // all buffers are held by readers. wait for one of them to be released.
+            std::this_thread::yield();
+        }
+        return nullptr;
+    }
+
+    void endWrite()
+    {
+        m_latest = m_writing;
+    }
+
+    // latest published buffer. writer side only. null if nothing is published yet.
+    const T* getLatest() const
+    {
+        int latest = m_latest;
+        return latest >= 0 ? m_buffers[latest].get() : nullptr;
+    }
+
+
+    // reader side. return -1 if nothing is published yet.
+    int acquire()
+    {
+        for (;;) {
+            int i = m_latest;
+            if (i < 0) { return -1; }
+            ++m_readers[i];
+            // the writer may have published another buffer and started to write to i. retry in that case.
+            if (m_latest == i) { return i; }
+            --m_readers[i];
+        }
+    }
+
+    void release(int i)
+    {
+        if (i >= 0 && i < MaxBuffers) { --m_readers[i]; }
+    }
+
+    const T& get(int i) const { return *m_buffers[i]; }
+
+private:
+    std::unique_ptr<T>  m_buffers[MaxBuffers];
+    std::atomic_int     m_readers[MaxBuffers];
+    std::atomic_int     m_latest = { -1 };
+    int                 m_writing = -1;
+};
 
 } // namespace usdi
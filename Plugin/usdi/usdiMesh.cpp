@@ -7,88 +7,129 @@
 #include "usdiUtils.h"
 #include "usdiContext.h"
 #include "usdiContext.i"
+#include "usdiBakedCache.h"
+#include "usdiTaskArena.h"
+#include "MeshUtils/Parallel.h"
 
 namespace usdi {
 
 const int usdiMaxVertices = 64998;
 
-static inline void CountIndices(
-    const VtArray<int> &counts,
-    VtArray<int>& offsets,
-    int& num_indices,
-    int& num_indices_triangulated)
+// resize dst and add a stream that gathers src into it. dst is cleared if src is empty.
+template<class T>
+static inline void AddGatherStream(RawVector<GatherStream>& streams, VtArray<T>& dst, const VtArray<T>& src, size_t num)
 {
-    int reti = 0, rett = 0;
-    size_t num_faces = counts.size();
-    offsets.resize(num_faces);
-    for (size_t fi = 0; fi < num_faces; ++fi)
-    {
-        auto f = counts[fi];
-        offsets[fi] = reti;
-        reti += f;
-        rett += (f - 2) * 3;
+    if (src.empty()) {
+        dst.clear();
+        return;
     }
-    num_indices = reti;
-    num_indices_triangulated = rett;
+    dst.resize(num);
+    streams.push_back({ dst.data(), src.cdata(), (int)sizeof(T) });
 }
 
-static inline void TriangulateIndices(
-    VtArray<int>& triangulated,
-    const VtArray<int> &counts,
-    const VtArray<int> *indices,
-    bool swap_face)
+// gather vertices of a submesh or a LOD from sample. indices are copied only when the remap table is updated.
+static void GatherSubmesh(SubmeshSample& dst, const MeshSample& src,
+    const RawVector<int>& vertices, const RawVector<int>& indices, uint32_t gen)
 {
-    const int i1 = swap_face ? 2 : 1;
-    const int i2 = swap_face ? 1 : 2;
-    size_t num_faces = counts.size();
-
-    int n = 0;
-    int i = 0;
-    if (indices) {
-        for (size_t fi = 0; fi < num_faces; ++fi) {
-            int ngon = counts[fi];
-            for (int ni = 0; ni < ngon - 2; ++ni) {
-                triangulated[i + 0] = (*indices)[n + 0];
-                triangulated[i + 1] = (*indices)[n + ni + i1];
-                triangulated[i + 2] = (*indices)[n + ni + i2];
-                i += 3;
-            }
-            n += ngon;
-        }
-    }
-    else {
-        for (size_t fi = 0; fi < num_faces; ++fi) {
-            int ngon = counts[fi];
-            for (int ni = 0; ni < ngon - 2; ++ni) {
-                triangulated[i + 0] = n + 0;
-                triangulated[i + 1] = n + ni + i1;
-                triangulated[i + 2] = n + ni + i2;
-                i += 3;
-            }
-            n += ngon;
-        }
+    size_t num_vertices = vertices.size();
+    if (dst.split_gen != gen) {
+        dst.indices.resize(indices.size());
+        memcpy(dst.indices.data(), indices.data(), sizeof(int) * indices.size());
+        dst.split_gen = gen;
     }
+
+    // all streams are gathered in one pass over the remap table
+    RawVector<GatherStream> streams;
+    AddGatherStream(streams, dst.points, src.points, num_vertices);
+    AddGatherStream(streams, dst.normals, src.normals, num_vertices);
+    AddGatherStream(streams, dst.colors, src.colors, num_vertices);
+    AddGatherStream(streams, dst.uvs, src.uvs, num_vertices);
+    AddGatherStream(streams, dst.tangents, src.tangents, num_vertices);
+    AddGatherStream(streams, dst.velocities, src.velocities, num_vertices);
+    AddGatherStream(streams, dst.weights4, src.weights4, num_vertices);
+    AddGatherStream(streams, dst.weights8, src.weights8, num_vertices);
+    GatherParallel(streams.data(), streams.size(), vertices.data(), num_vertices);
+
+    MinMax((float3*)dst.points.cdata(), dst.points.size(), dst.bounds_min, dst.bounds_max);
+    dst.center = (dst.bounds_min + dst.bounds_max) * 0.5f;
+    dst.extents = dst.bounds_max - dst.bounds_min;
 }
 
-static inline void assign(Weights4& dst, const Weights8& src)
+static void CopySubmesh(SubmeshData& dst, const SubmeshSample& src)
 {
-    // maybe need to sort weights..
-    memcpy(dst.weight, src.weight, sizeof(float) * 4);
-    memcpy(dst.indices, src.indices, sizeof(int) * 4);
+    dst.num_points = (uint)src.points.size();
+    dst.num_indices = (uint)src.indices.size();
+    dst.center = src.center;
+    dst.extents = src.extents;
+
+    if (dst.indices && !src.indices.empty()) {
+        memcpy(dst.indices, src.indices.cdata(), sizeof(int) * dst.num_indices);
+    }
+    if (dst.points && !src.points.empty()) {
+        memcpy(dst.points, src.points.cdata(), sizeof(float3) * dst.num_points);
+    }
+    if (dst.normals && !src.normals.empty()) {
+        memcpy(dst.normals, src.normals.cdata(), sizeof(float3) * dst.num_points);
+    }
+    if (dst.colors && !src.colors.empty()) {
+        memcpy(dst.colors, src.colors.cdata(), sizeof(float4) * dst.num_points);
+    }
+    if (dst.uvs && !src.uvs.empty()) {
+        memcpy(dst.uvs, src.uvs.cdata(), sizeof(float2) * dst.num_points);
+    }
+    if (dst.tangents && !src.tangents.empty()) {
+        memcpy(dst.tangents, src.tangents.cdata(), sizeof(float4) * dst.num_points);
+    }
+    if (dst.velocities && !src.velocities.empty()) {
+        memcpy(dst.velocities, src.velocities.cdata(), sizeof(float3) * dst.num_points);
+    }
 
-    // normalize
-    float scale = 1.0f / (src.weight[0] + src.weight[1] + src.weight[2] + src.weight[3]);
-    for (float& w : dst.weight) {
-        w *= scale;
+    if (dst.weights4 && !src.weights4.empty()) {
+        memcpy(dst.weights4, src.weights4.cdata(), sizeof(Weights4) * dst.num_points);
+    }
+    if (dst.weights8 && !src.weights8.empty()) {
+        memcpy(dst.weights8, src.weights8.cdata(), sizeof(Weights8) * dst.num_points);
     }
 }
 
-static inline void assign(Weights8& dst, const Weights4& src)
+static void AssignSubmesh(SubmeshData& dst, const SubmeshSample& src, int max_bone_weights)
 {
-    memcpy(dst.weight, src.weight, sizeof(float) * 4);
-    memcpy(dst.indices, src.indices, sizeof(int) * 4);
-    memset(dst.weight + 4, 0, sizeof(float) * 4);
-    memset(dst.indices + 4, 0, sizeof(int) * 4);
+    dst.num_points = (uint)src.points.size();
+    dst.num_indices = (uint)src.indices.size();
+    dst.indices = (int*)src.indices.cdata();
+    dst.points = (float3*)src.points.cdata();
+    dst.normals = (float3*)src.normals.cdata();
+    dst.colors = (float4*)src.colors.cdata();
+    dst.uvs = (float2*)src.uvs.cdata();
+    dst.tangents = (float4*)src.tangents.cdata();
+    dst.velocities = (float3*)src.velocities.cdata();
+    if (!src.weights4.empty() && max_bone_weights == 4) {
+        dst.weights4 = (Weights4*)src.weights4.cdata();
+    }
+    else if (!src.weights8.empty() && max_bone_weights == 8) {
+        dst.weights8 = (Weights8*)src.weights8.cdata();
+    }
+}
+
+static inline void CountIndices(
+    const VtArray<int> &counts,
+    VtArray<int>& offsets,
+    int& num_indices,
+    int& num_indices_triangulated)
+{
+    offsets.resize(counts.size());
+    CountIndicesParallel(ToIArray(counts), IArray<int>(offsets.data(), offsets.size()),
+        num_indices, num_indices_triangulated);
+}
+
+static inline void TriangulateIndices(
+    VtArray<int>& triangulated,
+    const VtArray<int> &counts,
+    const VtArray<int> *indices,
+    bool swap_face)
+{
+    TriangulateParallel(IArray<int>(triangulated.data(), triangulated.size()), ToIArray(counts),
+        indices ? ToIArray(*indices) : IArray<int>(), swap_face);
 }
 
 
@@ -100,7 +141,11 @@ Mesh::Mesh(Context *ctx, Schema *parent, const UsdPrim& prim)
 {
     usdiLogTrace("Mesh::Mesh(): %s\n", getPath());
     if (!m_mesh) { usdiLogError("Mesh::Mesh(): m_mesh is invalid\n"); }
+    findAttributes();
+}
 
+void Mesh::findAttributes()
+{
     m_attr_colors = findAttribute(usdiColorAttrName, AttributeType::Float4Array);
     m_attr_uv = findAttribute(usdiUVAttrName, AttributeType::Float2Array);
     if (!m_attr_uv) { m_attr_uv = findAttribute(usdiUVAttrName2, AttributeType::Float2Array); }
@@ -175,38 +220,205 @@ const MeshSummary& Mesh::getSummary() const
 }
 
 
+void MeshVariantData::assign(const MeshSample& src)
+{
+    counts = src.counts;
+    offsets = src.offsets;
+    indices = src.indices;
+    indices_triangulated = src.indices_triangulated;
+    indices_flattened_triangulated = src.indices_flattened_triangulated;
+    bindposes = src.bindposes;
+    bones = src.bones;
+    bones_ = src.bones_;
+    root_bone = src.root_bone;
+    weights4 = src.weights4;
+    weights8 = src.weights8;
+    max_bone_weights = src.max_bone_weights;
+    size = calcSize();
+}
+
+void MeshVariantData::restore(MeshSample& dst) const
+{
+    // VtArray is copy-on-write. these don't copy actual data.
+    dst.counts = counts;
+    dst.offsets = offsets;
+    dst.indices = indices;
+    dst.indices_triangulated = indices_triangulated;
+    dst.indices_flattened_triangulated = indices_flattened_triangulated;
+    dst.bindposes = bindposes;
+    dst.bones = bones;
+    dst.bones_ = bones_;
+    dst.root_bone = root_bone;
+    dst.weights4 = weights4;
+    dst.weights8 = weights8;
+    dst.max_bone_weights = max_bone_weights;
+}
+
+size_t MeshVariantData::calcSize() const
+{
+    size_t ret = sizeof(*this);
+    ret += sizeof(int) * (counts.size() + offsets.size() + indices.size() +
+        indices_triangulated.size() + indices_flattened_triangulated.size());
+    ret += sizeof(GfMatrix4f) * bindposes.size();
+    ret += (sizeof(TfToken) + sizeof(const char*)) * bones.size();
+    ret += sizeof(Weights4) * weights4.size();
+    ret += sizeof(Weights8) * weights8.size();
+    if (splits) {
+        for (auto& s : *splits) { ret += sizeof(int) * (s.vertices.size() + s.indices.size()); }
+    }
+    if (lods) {
+        for (auto& l : *lods) { ret += sizeof(int) * (l.vertices.size() + l.indices.size()); }
+    }
+    return ret;
+}
+
+
+std::string Mesh::makeVariantKey() const
+{
+    // composed prim stack reflects variant selections of this prim and its ancestors.
+    std::string ret;
+    for (auto& spec : m_prim.GetPrimStack()) {
+        ret += spec->GetLayer()->GetIdentifier();
+        ret += spec->GetPath().GetString();
+        ret += '\n';
+    }
+    return ret;
+}
+
+const MeshVariantData* Mesh::findVariantCache(const std::string& key)
+{
+    for (auto i = m_variant_cache.begin(); i != m_variant_cache.end(); ++i) {
+        if (i->first == key) {
+            m_variant_cache.splice(m_variant_cache.begin(), m_variant_cache, i);
+            return &m_variant_cache.front().second;
+        }
+    }
+    return nullptr;
+}
+
+void Mesh::addVariantCache(const std::string& key, const MeshSample& sample, size_t budget)
+{
+    MeshVariantData data;
+    data.assign(sample);
+    data.summary = getSummary();
+    data.num_indices = m_num_indices;
+    data.num_indices_triangulated = m_num_indices_triangulated;
+    data.topology_gen = sample.topology_gen;
+    if (m_splits_gen == sample.topology_gen) { data.splits = m_splits; }
+    if (m_lods_gen == sample.topology_gen) { data.lods = m_lods; }
+    data.size = data.calcSize();
+    if (data.size > budget) { return; }
+
+    m_variant_cache_size += data.size;
+    m_variant_cache.emplace_front(key, std::move(data));
+
+    // evict least recently used
+    while (m_variant_cache_size > budget) {
+        m_variant_cache_size -= m_variant_cache.back().second.size;
+        m_variant_cache.pop_back();
+    }
+}
+
+void Mesh::clearVariantCache()
+{
+    m_variant_cache.clear();
+    m_variant_cache_size = 0;
+    m_variant_key.clear();
+}
+
+void Mesh::resync(bool attributes, const TfTokenVector& changed)
+{
+    super::resync(attributes, changed);
+    if (attributes) {
+        m_mesh = UsdGeomMesh(m_prim);
+        findAttributes();
+    }
+    // triangulated indices and tables made from them are rebuilt only if counts or indices may be changed
+    bool topology = changed.empty();
+    for (auto& name : changed) {
+        if (name == UsdGeomTokens->faceVertexCounts || name == UsdGeomTokens->faceVertexIndices) {
+            topology = true;
+        }
+    }
+    if (topology) {
+        m_topology_dirty = true;
+    }
+    // cached data of current variant may be obsolete
+    clearVariantCache();
+    m_summary_needs_update = true;
+    // bones and weights are assumed to be constant and read only once. re-read them.
+    ++m_constant_gen;
+}
+
 void Mesh::updateSample(Time t_)
 {
     super::updateSample(t_);
-    if (m_update_flag.bits == 0) { return; }
-    if (m_update_flag.variant_set_changed) { m_summary_needs_update = true; }
+    if (updateFlag().bits == 0) { return; }
+    if (updateFlag().variant_set_changed) { m_summary_needs_update = true; }
 
 
     auto t = UsdTimeCode(t_);
     const auto& conf = getImportSettings();
 
-    // swap front sample
-    if (!m_front_sample) {
-        m_front_sample = &m_sample[0];
-        m_front_submesh = &m_submeshes[0];
+    // per-variant cache
+    const MeshVariantData *cached = nullptr;
+    bool store_variant = false;
+    if (updateFlag().import_settings_updated || conf.variant_cache_kb <= 0) {
+        clearVariantCache();
+    }
+    if (updateFlag().variant_set_changed) {
+        // constant data may differ between variants
+        ++m_constant_gen;
     }
-    else if(conf.double_buffering) {
-        if (m_front_sample == &m_sample[0]) {
-            m_front_sample = &m_sample[1];
-            m_front_submesh = &m_submeshes[1];
+    if (conf.variant_cache_kb > 0 && (updateFlag().variant_set_changed || m_variant_key.empty())) {
+        m_variant_key = makeVariantKey();
+        cached = findVariantCache(m_variant_key);
+        if (cached) {
+            m_summary = cached->summary;
+            m_summary_needs_update = false;
+            m_num_indices = cached->num_indices;
+            m_num_indices_triangulated = cached->num_indices_triangulated;
         }
         else {
-            m_front_sample = &m_sample[0];
-            m_front_submesh = &m_submeshes[0];
+            store_variant = true;
         }
     }
-    auto& sample = *m_front_sample;
-    auto& submeshes = *m_front_submesh;
+
+    // pick a buffer that no readers are holding. published by endWrite() at the end.
+    const MeshSample *prev = m_samples.getLatest();
+    auto *psample = m_samples.beginWrite(!conf.double_buffering);
+    if (!psample) {
+        usdiLogWarning("Mesh::updateSample(): all sample buffers of %s are held by readers. skipped\n", getPath());
+        // retry on next update
+        updateFlagNext().sample_updated = 1;
+        return;
+    }
+    auto& sample = *psample;
+    auto& submeshes = sample.submeshes;
+
+    if (sample.constant_gen != m_constant_gen) {
+        // constant data in this buffer is obsolete. restore from variant cache if possible, or let them be re-read.
+        auto *v = cached;
+        if (!v && !m_variant_key.empty()) { v = findVariantCache(m_variant_key); }
+        if (v) {
+            v->restore(sample);
+        }
+        else {
+            sample.weights4.clear();
+            sample.weights8.clear();
+            sample.bones.clear();
+            sample.root_bone = TfToken();
+            sample.bindposes.clear();
+        }
+        sample.constant_gen = m_constant_gen;
+    }
 
     m_mesh.GetPointsAttr().Get(&sample.points, t);
     m_mesh.GetVelocitiesAttr().Get(&sample.velocities, t);
-    m_mesh.GetFaceVertexCountsAttr().Get(&sample.counts, t);
-    m_mesh.GetFaceVertexIndicesAttr().Get(&sample.indices, t);
+    if (!cached) {
+        m_mesh.GetFaceVertexCountsAttr().Get(&sample.counts, t);
+        m_mesh.GetFaceVertexIndicesAttr().Get(&sample.indices, t);
+    }
     if (m_attr_colors) {
         m_attr_colors->getImmediate(&sample.colors, t_);
     }
@@ -267,35 +479,72 @@ void Mesh::updateSample(Time t_)
     bool update_indices =
         m_num_indices_triangulated == 0 ||
         getSummary().topology_variance == TopologyVariance::Heterogenous ||
-        m_update_flag.import_settings_updated || m_update_flag.variant_set_changed;
-    bool copy_indices =
-        sample.indices_triangulated.size() != m_sample[0].indices_triangulated.size() ||
-        m_update_flag_prev.variant_set_changed;
-    if (update_indices) {
+        updateFlag().import_settings_updated || updateFlag().variant_set_changed || m_topology_dirty;
+    if (cached) {
+        // restored from variant cache. so are the tables made from it.
+        m_topology_gen = cached->topology_gen;
+        sample.topology_gen = m_topology_gen;
+        if (cached->splits) {
+            m_splits = cached->splits;
+            m_splits_gen = m_topology_gen;
+        }
+        if (cached->lods) {
+            m_lods = cached->lods;
+            m_lods_gen = m_topology_gen;
+        }
+    }
+    else if (update_indices) {
         CountIndices(sample.counts, sample.offsets, m_num_indices, m_num_indices_triangulated);
         if (conf.triangulate || gen_normals) {
             sample.indices_triangulated.resize(m_num_indices_triangulated);
             TriangulateIndices(sample.indices_triangulated, sample.counts, &sample.indices, conf.swap_faces);
         }
+        m_topology_gen = ++m_topology_gen_seed;
+        sample.topology_gen = m_topology_gen;
+        m_topology_dirty = false;
     }
-    else if (copy_indices) {
-        sample.indices_triangulated = m_sample[0].indices_triangulated;
-        sample.offsets = m_sample[0].offsets;
+    else if (sample.topology_gen != m_topology_gen && prev) {
+        // this buffer has obsolete topology. the latest one always has up-to-date one.
+        sample.offsets = prev->offsets;
+        sample.indices_triangulated = prev->indices_triangulated;
+        sample.indices_flattened_triangulated = prev->indices_flattened_triangulated;
+        sample.topology_gen = m_topology_gen;
     }
 
     // normals
+    if ((gen_normals || gen_tangents) && m_connection_gen != sample.topology_gen) {
+        m_connection.clear();
+        m_connection_gen = sample.topology_gen;
+    }
     if (gen_normals) {
         sample.normals.resize(sample.points.size());
-        GenerateNormals(ToIArray(sample.normals),
-            ToIArray(sample.points), ToIArray(sample.counts), ToIArray(sample.offsets), ToIArray(sample.indices));
+        if (ShouldRunParallel(sample.counts.size())) {
+            GenerateNormalsParallel(ToIArray(sample.normals),
+                ToIArray(sample.points), ToIArray(sample.counts), ToIArray(sample.offsets), ToIArray(sample.indices),
+                m_connection);
+        }
+        else {
+            // building connection costs far more than serial GenerateNormals()
+            GenerateNormals(ToIArray(sample.normals),
+                ToIArray(sample.points), ToIArray(sample.counts), ToIArray(sample.offsets), ToIArray(sample.indices));
+        }
     }
 
     // tangents
     if (gen_tangents) {
         sample.tangents.resize(sample.points.size());
-        GenerateTangents(ToIArray(sample.tangents),
-            ToIArray(sample.points), ToIArray(sample.normals), ToIArray(sample.uvs),
-            ToIArray(sample.counts), ToIArray(sample.offsets), ToIArray(sample.indices));
+        if (conf.fast_tangents) {
+            GenerateTangentsFast(ToIArray(sample.tangents),
+                ToIArray(sample.points), ToIArray(sample.normals), ToIArray(sample.uvs),
+                ToIArray(sample.counts), ToIArray(sample.offsets), ToIArray(sample.indices),
+                m_connection);
+        }
+        else {
+            GenerateTangentsParallel(ToIArray(sample.tangents),
+                ToIArray(sample.points), ToIArray(sample.normals), ToIArray(sample.uvs),
+                ToIArray(sample.counts), ToIArray(sample.offsets), ToIArray(sample.indices),
+                m_connection);
+        }
     }
 
     // bone & weights
@@ -321,45 +570,28 @@ void Mesh::updateSample(Time t_)
 
         // weight array & index array -> weight4 array or weight8 array
         if (sample.max_bone_weights == 4) {
-            const size_t nweights = 4;
-            const size_t npoints = sample.bone_weights.size() / nweights;
+            const size_t npoints = sample.bone_weights.size() / 4;
             sample.weights4.resize(npoints);
-            for (size_t ip = 0; ip < npoints; ++ip) {
-                size_t ip4 = ip * nweights;
-                auto& w = sample.weights4[ip];
-                for (size_t iw = 0; iw < nweights; ++iw) {
-                    w.weight[iw] = sample.bone_weights[ip4 + iw];
-                    w.indices[iw] = sample.bone_indices[ip4 + iw];
-                }
-            }
+            GenerateWeightsN(ToWritableIArray(sample.weights4),
+                ToIArray(sample.bone_indices), ToIArray(sample.bone_weights), 4);
 
             if (conf.max_bone_weights == 8) {
                 sample.max_bone_weights = 8;
                 sample.weights8.resize(npoints);
-                for (size_t ip = 0; ip < npoints; ++ip) {
-                    assign(sample.weights8[ip], sample.weights4[ip]);
-                }
+                ConvertWeights(ToWritableIArray(sample.weights8), ToIArray(sample.weights4));
             }
         }
         else if (sample.max_bone_weights == 8) {
-            const size_t nweights = 8;
-            const size_t npoints = sample.bone_weights.size() / nweights;
+            const size_t npoints = sample.bone_weights.size() / 8;
             sample.weights8.resize(npoints);
-            for (size_t ip = 0; ip < npoints; ++ip) {
-                size_t ip8 = ip * nweights;
-                auto& w = sample.weights8[ip];
-                for (size_t iw = 0; iw < nweights; ++iw) {
-                    w.weight[iw] = sample.bone_weights[ip8 + iw];
-                    w.indices[iw] = sample.bone_indices[ip8 + iw];
-                }
-            }
+            GenerateWeightsN(ToWritableIArray(sample.weights8),
+                ToIArray(sample.bone_indices), ToIArray(sample.bone_weights), 8);
 
             if (conf.max_bone_weights == 4) {
+                // 4 most influential bones are selected and normalized
                 sample.max_bone_weights = 4;
                 sample.weights4.resize(npoints);
-                for (size_t ip = 0; ip < npoints; ++ip) {
-                    assign(sample.weights4[ip], sample.weights8[ip]);
-                }
+                ConvertWeights(ToWritableIArray(sample.weights4), ToIArray(sample.weights8));
             }
         }
 
@@ -404,68 +636,138 @@ void Mesh::updateSample(Time t_)
         flattened.any ||
         (conf.split_mesh && sample.points.size() > usdiMaxVertices);
 
-    if (!make_submesh) {
-        m_num_current_submeshes = 0;
+    // if all attributes are per-vertex, split faces into chunks and keep vertices shared.
+    bool keep_shared_vertices =
+        !flattened.any &&
+        sample.indices_triangulated.size() == m_num_indices_triangulated;
+
+    int num_submeshes = 0;
+    if (make_submesh && keep_shared_vertices) {
+        // remap tables depend only on topology, so they are rebuilt only when it changes.
+        if (!m_splits || m_splits_gen != sample.topology_gen) {
+            // may be shared with variant cache. make new one.
+            m_splits = std::make_shared<std::vector<MeshSplit>>();
+            SplitMesh(*m_splits, ToIArray(sample.counts), ToIArray(sample.indices), ToIArray(sample.indices_triangulated),
+                sample.points.size(), usdiMaxVertices);
+            m_splits_gen = sample.topology_gen;
+        }
+        num_submeshes = (int)m_splits->size();
+        if (num_submeshes > (int)submeshes.size()) {
+            submeshes.resize(num_submeshes);
+        }
+
+        for (int nth = 0; nth < num_submeshes; ++nth) {
+            const auto& split = (*m_splits)[nth];
+            GatherSubmesh(submeshes[nth], sample, split.vertices, split.indices, m_splits_gen);
+        }
     }
-    else {
-        m_num_current_submeshes = ceildiv(m_num_indices_triangulated, usdiMaxVertices);
-        if (m_num_current_submeshes > submeshes.size()) {
-            submeshes.resize(m_num_current_submeshes);
+    else if (make_submesh) {
+        num_submeshes = ceildiv(m_num_indices_triangulated, usdiMaxVertices);
+        if (num_submeshes > (int)submeshes.size()) {
+            submeshes.resize(num_submeshes);
         }
 
         if (flattened.any &&
-            (sample.indices_flattened_triangulated.size() != sample.indices_triangulated.size() || update_indices))
+            (sample.indices_flattened_triangulated.size() != sample.indices_triangulated.size() || (update_indices && !cached)))
         {
             sample.indices_flattened_triangulated.resize(m_num_indices_triangulated);
             TriangulateIndices(sample.indices_flattened_triangulated, sample.counts, nullptr, conf.swap_faces);
         }
 
         // split meshes and flatten vertices
-        for (int nth = 0; nth < m_num_current_submeshes; ++nth) {
+        for (int nth = 0; nth < num_submeshes; ++nth) {
             auto& sms = submeshes[nth];
             int ibegin = usdiMaxVertices * nth;
             int iend = std::min<int>(usdiMaxVertices * (nth + 1), m_num_indices_triangulated);
             int isize = iend - ibegin;
 
-            sms.indices.resize(isize);
-            for (int i = 0; i < isize; ++i) { sms.indices[i] = i; }
-
-#define Sel(C) ToIArray(C ? sample.indices_flattened_triangulated : sample.indices_triangulated)
-            CopyWithIndices(sms.points, sample.points, Sel(flattened.points), ibegin, iend);
-            CopyWithIndices(sms.normals, sample.normals, Sel(flattened.normals), ibegin, iend);
-            CopyWithIndices(sms.colors, sample.colors, Sel(flattened.colors), ibegin, iend);
-            CopyWithIndices(sms.uvs, sample.uvs, Sel(flattened.uvs), ibegin, iend);
-            CopyWithIndices(sms.tangents, sample.tangents, Sel(flattened.tangents), ibegin, iend);
-            CopyWithIndices(sms.velocities, sample.velocities, Sel(flattened.velocities), ibegin, iend);
-            if (!sample.weights4.empty()) {
-                CopyWithIndices(sms.weights4, sample.weights4, Sel(flattened.weights), ibegin, iend);
+            if (sms.indices.size() != isize || sms.split_gen != 0) {
+                sms.indices.resize(isize);
+                for (int i = 0; i < isize; ++i) { sms.indices[i] = i; }
+                sms.split_gen = 0;
             }
-            if (!sample.weights8.empty()) {
-                CopyWithIndices(sms.weights8, sample.weights8, Sel(flattened.weights), ibegin, iend);
+
+            // streams are grouped by index array and each group is gathered in one pass
+            RawVector<GatherStream> vstreams, fstreams;
+#define Add(C, Dst, Src) AddGatherStream(C ? fstreams : vstreams, Dst, Src, isize)
+            Add(flattened.points, sms.points, sample.points);
+            Add(flattened.normals, sms.normals, sample.normals);
+            Add(flattened.colors, sms.colors, sample.colors);
+            Add(flattened.uvs, sms.uvs, sample.uvs);
+            Add(flattened.tangents, sms.tangents, sample.tangents);
+            Add(flattened.velocities, sms.velocities, sample.velocities);
+            Add(flattened.weights, sms.weights4, sample.weights4);
+            Add(flattened.weights, sms.weights8, sample.weights8);
+#undef Add
+            if (!vstreams.empty()) {
+                GatherParallel(vstreams.data(), vstreams.size(), sample.indices_triangulated.cdata() + ibegin, isize);
+            }
+            if (!fstreams.empty()) {
+                GatherParallel(fstreams.data(), fstreams.size(), sample.indices_flattened_triangulated.cdata() + ibegin, isize);
             }
-#undef Sel
 
             MinMax((float3*)sms.points.cdata(), sms.points.size(), sms.bounds_min, sms.bounds_max);
             sms.center = (sms.bounds_min + sms.bounds_max) * 0.5f;
             sms.extents = sms.bounds_max - sms.bounds_min;
         }
     }
-}
 
-bool Mesh::readSample(MeshData& dst, Time t, bool copy)
-{
-    if (t != m_time_prev) { updateSample(t); }
+    // levels of detail
+    int num_lods = 0;
+    if (conf.lod_count > 0 && keep_shared_vertices && getSummary().topology_variance != TopologyVariance::Heterogenous) {
+        // collapses are decided only when topology changes. animated meshes apply them to points of every sample.
+        if (!m_lods || m_lods_gen != sample.topology_gen) {
+            MeshSimplifier simplifier;
+            simplifier.prepare(ToIArray(sample.indices_triangulated), ToIArray(sample.points));
+            simplifier.normals = ToIArray(sample.normals);
+            simplifier.uv = ToIArray(sample.uvs);
+            if (sample.max_bone_weights == 8 && sample.weights8.size() == sample.points.size()) {
+                simplifier.weights8 = ToIArray(sample.weights8);
+            }
+            else if (sample.weights4.size() == sample.points.size()) {
+                simplifier.weights4 = ToIArray(sample.weights4);
+            }
+            // may be shared with variant cache. make new one.
+            m_lods = std::make_shared<std::vector<MeshLOD>>();
+            if (!simplifier.simplify(*m_lods, conf.lod_count, conf.lod_ratio)) {
+                usdiLogWarning("Mesh::updateSample(): failed to make LODs of %s\n", getPath());
+            }
+            m_lods_gen = sample.topology_gen;
+        }
+        num_lods = (int)m_lods->size();
+        if (num_lods > (int)sample.lods.size()) {
+            sample.lods.resize(num_lods);
+        }
+        for (int nth = 0; nth < num_lods; ++nth) {
+            const auto& lod = (*m_lods)[nth];
+            GatherSubmesh(sample.lods[nth], sample, lod.vertices, lod.indices, m_lods_gen);
+        }
+    }
+
+    sample.num_indices_triangulated = m_num_indices_triangulated;
+    sample.num_submeshes = num_submeshes;
+    sample.num_lods = num_lods;
+
+    // topology varies by time can't be cached per variant
+    if (store_variant && getSummary().topology_variance != TopologyVariance::Heterogenous) {
+        addVariantCache(m_variant_key, sample, (size_t)conf.variant_cache_kb * 1024);
+    }
 
-    if (!m_front_sample) { return false; }
+    m_samples.endWrite();
+}
 
-    const auto& sample = *m_front_sample;
-    const auto& submeshes = *m_front_submesh;
+// fill dst with sample. if copy is false, dst points to the sample's memory.
+static void ReadMeshSample(MeshData& dst, const MeshSample& sample, bool copy)
+{
+    const auto& submeshes = sample.submeshes;
+    const auto& lods = sample.lods;
 
     dst.num_points = (uint)sample.points.size();
     dst.num_counts = (uint)sample.counts.size();
     dst.num_indices = (uint)sample.indices.size();
-    dst.num_indices_triangulated = m_num_indices_triangulated;
-    dst.num_submeshes = (uint)m_num_current_submeshes;
+    dst.num_indices_triangulated = sample.num_indices_triangulated;
+    dst.num_submeshes = (uint)sample.num_submeshes;
+    dst.num_lods = (uint)sample.num_lods;
     dst.center = sample.center;
     dst.extents = sample.extents;
 
@@ -500,7 +802,7 @@ bool Mesh::readSample(MeshData& dst, Time t, bool copy)
             memcpy(dst.indices, sample.indices.cdata(), sizeof(int) * dst.num_indices);
         }
         if (dst.indices_triangulated && !sample.indices_triangulated.empty()) {
-            memcpy(dst.indices_triangulated, sample.indices_triangulated.cdata(), sizeof(int) * m_num_indices_triangulated);
+            memcpy(dst.indices_triangulated, sample.indices_triangulated.cdata(), sizeof(int) * dst.num_indices_triangulated);
         }
 
         if (dst.weights4 && !sample.weights4.empty() && sample.max_bone_weights == 4) {
@@ -515,40 +817,12 @@ bool Mesh::readSample(MeshData& dst, Time t, bool copy)
 
         if (dst.submeshes) {
             for (size_t i = 0; i < dst.num_submeshes; ++i) {
-                const auto& ssrc = submeshes[i];
-                auto& sdst = dst.submeshes[i];
-                sdst.num_points = (uint)ssrc.points.size();
-                sdst.center = ssrc.center;
-                sdst.extents = ssrc.extents;
-
-                if (sdst.indices && !ssrc.indices.empty()) {
-                    memcpy(sdst.indices, ssrc.indices.cdata(), sizeof(int) * sdst.num_points);
-                }
-                if (sdst.points && !ssrc.points.empty()) {
-                    memcpy(sdst.points, ssrc.points.cdata(), sizeof(float3) * sdst.num_points);
-                }
-                if (sdst.normals && !ssrc.normals.empty()) {
-                    memcpy(sdst.normals, ssrc.normals.cdata(), sizeof(float3) * sdst.num_points);
-                }
-                if (sdst.colors && !ssrc.colors.empty()) {
-                    memcpy(sdst.colors, ssrc.colors.cdata(), sizeof(float4) * sdst.num_points);
-                }
-                if (sdst.uvs && !ssrc.uvs.empty()) {
-                    memcpy(sdst.uvs, ssrc.uvs.cdata(), sizeof(float2) * sdst.num_points);
-                }
-                if (sdst.tangents && !ssrc.tangents.empty()) {
-                    memcpy(sdst.tangents, ssrc.tangents.cdata(), sizeof(float4) * sdst.num_points);
-                }
-                if (sdst.velocities && !ssrc.velocities.empty()) {
-                    memcpy(sdst.velocities, ssrc.velocities.cdata(), sizeof(float3) * sdst.num_points);
-                }
-
-                if (sdst.weights4 && !ssrc.weights4.empty()) {
-                    memcpy(sdst.weights4, ssrc.weights4.cdata(), sizeof(Weights4) * sdst.num_points);
-                }
-                if (sdst.weights8 && !ssrc.weights8.empty()) {
-                    memcpy(sdst.weights8, ssrc.weights8.cdata(), sizeof(Weights8) * sdst.num_points);
-                }
+                CopySubmesh(dst.submeshes[i], submeshes[i]);
+            }
+        }
+        if (dst.lods) {
+            for (size_t i = 0; i < dst.num_lods; ++i) {
+                CopySubmesh(dst.lods[i], lods[i]);
             }
         }
     }
@@ -563,41 +837,77 @@ bool Mesh::readSample(MeshData& dst, Time t, bool copy)
         dst.indices = (int*)sample.indices.cdata();
         dst.indices_triangulated = (int*)sample.indices_triangulated.cdata();
 
-        if (!sample.weights4.empty()) {
+        if (!sample.weights4.empty() && sample.max_bone_weights == 4) {
             dst.weights4 = (Weights4*)sample.weights4.cdata();
         }
-        else if (!sample.weights8.empty()) {
+        else if (!sample.weights8.empty() && sample.max_bone_weights == 8) {
             dst.weights8 = (Weights8*)sample.weights8.cdata();
         }
         dst.bindposes = (float4x4*)sample.bindposes.cdata();
 
         if (dst.submeshes) {
             for (size_t i = 0; i < dst.num_submeshes; ++i) {
-                const auto& ssrc = submeshes[i];
-                auto& sdst = dst.submeshes[i];
-                sdst.num_points = (uint)ssrc.points.size();
-                sdst.indices = (int*)ssrc.indices.cdata();
-                sdst.points = (float3*)ssrc.points.cdata();
-                sdst.normals = (float3*)ssrc.normals.cdata();
-                sdst.colors = (float4*)ssrc.colors.cdata();
-                sdst.uvs = (float2*)ssrc.uvs.cdata();
-                sdst.tangents = (float4*)ssrc.tangents.cdata();
-                sdst.velocities = (float3*)ssrc.velocities.cdata();
+                AssignSubmesh(dst.submeshes[i], submeshes[i], sample.max_bone_weights);
+            }
+        }
+        if (dst.lods) {
+            for (size_t i = 0; i < dst.num_lods; ++i) {
+                AssignSubmesh(dst.lods[i], lods[i], sample.max_bone_weights);
             }
         }
     }
+}
 
+bool Mesh::readSample(MeshData& dst, Time t, bool copy)
+{
+    if (m_baked_entry >= 0) {
+        return m_ctx->getBakedCache()->readMesh(m_baked_entry, dst, t, copy);
+    }
+
+    if (copy) {
+        // the buffer is never overwritten while acquired
+        int ibuf = m_samples.acquire();
+        if (ibuf < 0) { return false; }
+        ReadMeshSample(dst, m_samples.get(ibuf), true);
+        m_samples.release(ibuf);
+    }
+    else {
+        // keep holding until next readSample(copy=false). the hold is shared by all callers.
+        int ibuf = acquireSample(dst, t);
+        m_samples.release(m_read_buffer.exchange(ibuf));
+        if (ibuf < 0) { return false; }
+    }
     return dst.num_points > 0;
 }
 
+int Mesh::acquireSample(MeshData& dst, Time t)
+{
+    if (m_baked_entry >= 0) {
+        // baked samples stay valid until the cache is closed
+        if (!m_ctx->getBakedCache()->readMesh(m_baked_entry, dst, t, false)) { return -1; }
+        return m_samples.ExternalHandle;
+    }
+
+    int ibuf = m_samples.acquire();
+    if (ibuf < 0) { return -1; }
+    ReadMeshSample(dst, m_samples.get(ibuf), false);
+    return ibuf;
+}
+
+void Mesh::releaseSample(int handle)
+{
+    m_samples.release(handle);
+}
+
 #define CreateAttributeIfNeeded(VName, ...) if(!VName) { VName=createAttribute(__VA_ARGS__); }
 
 bool Mesh::writeSample(const MeshData& src, Time t_)
 {
+    if (!m_ctx->checkStageEditable("Mesh::writeSample()")) { return false; }
     auto t = UsdTimeCode(t_);
     const auto& conf = getExportSettings();
 
-    MeshSample& sample = m_sample[0];
+    MeshSample& sample = m_export_sample;
 
 
     bool  ret = false;
@@ -690,29 +1000,19 @@ bool Mesh::writeSample(const MeshData& src, Time t_)
 
     // bone & weight attributes
 
-    if ((src.weights4 || src.weights4) &&
-        (src.max_bone_weights == 4 || src.max_bone_weights == 8))
+    if ((src.max_bone_weights == 4 && src.weights4) ||
+        (src.max_bone_weights == 8 && src.weights8))
     {
         sample.max_bone_weights = src.max_bone_weights;
         sample.bone_weights.resize(src.num_points * src.max_bone_weights);
         sample.bone_indices.resize(src.num_points * src.max_bone_weights);
+        IArray<int> bone_indices(sample.bone_indices.data(), sample.bone_indices.size());
+        IArray<float> bone_weights(sample.bone_weights.data(), sample.bone_weights.size());
         if (src.max_bone_weights == 4) {
-            for (uint pi = 0; pi < src.num_points; ++pi) {
-                int pix = pi * 4;
-                for (int i = 0; i < 4; ++i) {
-                    sample.bone_weights[pix + i] = src.weights4[pi].weight[i];
-                    sample.bone_indices[pix + i] = src.weights4[pi].indices[i];
-                }
-            }
+            FlattenWeightsN(bone_indices, bone_weights, IArray<mu::Weights4>((mu::Weights4*)src.weights4, src.num_points));
         }
         else if (src.max_bone_weights == 8) {
-            for (uint pi = 0; pi < src.num_points; ++pi) {
-                int pix = pi * 8;
-                for (int i = 0; i < 8; ++i) {
-                    sample.bone_weights[pix + i] = src.weights8[pi].weight[i];
-                    sample.bone_indices[pix + i] = src.weights8[pi].indices[i];
-                }
-            }
+            FlattenWeightsN(bone_indices, bone_weights, IArray<mu::Weights8>((mu::Weights8*)src.weights8, src.num_points));
         }
 
         CreateAttributeIfNeeded(m_attr_bone_weights, usdiBoneWeightsAttrName, AttributeType::FloatArray);
@@ -781,8 +1081,11 @@ int Mesh::eachSample(const SampleCallback & cb)
 
     MeshData data;
     for (const auto& t : times) {
-        readSample(data, t.first, false);
+        // readSample() doesn't update. decode each time here (baked samples are read as is).
+        if (m_baked_entry < 0) { updateSample(t.first); }
+        int handle = acquireSample(data, t.first);
         cb(data, t.first);
+        releaseSample(handle);
     }
     return (int)times.size();
 }
@@ -791,7 +1094,7 @@ int Mesh::eachSample(const SampleCallback & cb)
 
 bool Mesh::precomputeNormals(bool gen_tangents, bool overwrite)
 {
-    if (!isEditable()) {
+    if (!isEditable() || !m_ctx->checkStageEditable("Mesh::precomputeNormals()")) {
         return false;
     }
 
@@ -858,42 +1161,44 @@ bool Mesh::precomputeNormals(bool gen_tangents, bool overwrite)
         int bend = std::min<int>((bi + 1) * block_size, num_frames);
         int bsize = bend - bbegin;
 
-        tbb::parallel_for(0, bsize, [&](int i) {
-            auto& t = times[bbegin + i];
-            auto& indices = _indices[i];
-            auto& counts = _counts[i];
-            auto& offsets = _offsets[i];
-            auto& points = _points[i];
-            auto& normals = _normals[i];
-            auto& tangents = _tangents[i];
-            auto& uv = _uv[i];
-            auto& num_indices = _num_indices[i];
-
-            // setup indices
-            attr_indices.Get(&indices, t);
-            attr_counts.Get(&counts, t);
-            int num_indices_triangulated;
-            CountIndices(counts, offsets, num_indices, num_indices_triangulated);
-
-            // generate normals
-            attr_points.Get(&points, t);
-            if (gen_normals) {
-                normals.resize(points.size());
-                GenerateNormals(ToIArray(normals),
-                    ToIArray(points), ToIArray(counts), ToIArray(offsets), ToIArray(indices));
-            }
-            else {
-                attr_normals.Get(&normals, t);
-            }
+        m_ctx->getTaskArena().execute([&]() {
+            tbb::parallel_for(0, bsize, [&](int i) {
+                auto& t = times[bbegin + i];
+                auto& indices = _indices[i];
+                auto& counts = _counts[i];
+                auto& offsets = _offsets[i];
+                auto& points = _points[i];
+                auto& normals = _normals[i];
+                auto& tangents = _tangents[i];
+                auto& uv = _uv[i];
+                auto& num_indices = _num_indices[i];
+
+                // setup indices
+                attr_indices.Get(&indices, t);
+                attr_counts.Get(&counts, t);
+                int num_indices_triangulated;
+                CountIndices(counts, offsets, num_indices, num_indices_triangulated);
+
+                // generate normals
+                attr_points.Get(&points, t);
+                if (gen_normals) {
+                    normals.resize(points.size());
+                    GenerateNormals(ToIArray(normals),
+                        ToIArray(points), ToIArray(counts), ToIArray(offsets), ToIArray(indices));
+                }
+                else {
+                    attr_normals.Get(&normals, t);
+                }
 
-            // generate tangents
-            if (gen_tangents) {
-                attr_uv.Get(&uv, t);
-                tangents.resize(points.size());
-                GenerateTangents(ToIArray(tangents),
-                    ToIArray(points), ToIArray(normals), ToIArray(uv),
-                    ToIArray(counts), ToIArray(offsets), ToIArray(indices));
-            }
+                // generate tangents
+                if (gen_tangents) {
+                    attr_uv.Get(&uv, t);
+                    tangents.resize(points.size());
+                    GenerateTangents(ToIArray(tangents),
+                        ToIArray(points), ToIArray(normals), ToIArray(uv),
+                        ToIArray(counts), ToIArray(offsets), ToIArray(indices));
+                }
+            });
         });
 
         for (int i = 0; i < bsize; ++i) {
@@ -916,14 +1221,14 @@ bool Mesh::precomputeNormals(bool gen_tangents, bool overwrite)
 
 void Mesh::assignRootBone(MeshData& dst, const char *v)
 {
-    MeshSample& sample = m_sample[0];
+    MeshSample& sample = m_export_sample;
     sample.root_bone = TfToken(v);
     dst.root_bone = (char*)sample.root_bone.GetText();
 }
 
 void Mesh::assignBones(MeshData& dst, const char **v, int n)
 {
-    MeshSample& sample = m_sample[0];
+    MeshSample& sample = m_export_sample;
     sample.bones.resize(n);
     sample.bones_.resize(n);
     for (int i = 0; i < n; ++i) {
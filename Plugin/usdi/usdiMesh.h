@@ -29,6 +29,7 @@ struct SubmeshSample
     VtArray<Weights8> weights8;
     float3           bounds_min = {}, bounds_max = {};
     float3           center = {}, extents = {};
+    uint32_t         split_gen = 0; // generation of remap table (Mesh::m_splits or m_lods) indices are copied from. 0 if flattened
 };
 
 struct MeshSample
@@ -57,6 +58,51 @@ struct MeshSample
 
     float3           bounds_min = {}, bounds_max = {};
     float3           center = {}, extents = {};
+
+    std::vector<SubmeshSample> submeshes;
+    std::vector<SubmeshSample> lods;
+    int              num_indices_triangulated = 0;
+    int              num_submeshes = 0;
+    int              num_lods = 0;
+    // generations of topology and constant data in this buffer (see Mesh::updateSample())
+    uint32_t         topology_gen = 0;
+    uint32_t         constant_gen = 0;
+};
+
+using MeshSplitsPtr = std::shared_ptr<std::vector<MeshSplit>>;
+using MeshLODsPtr = std::shared_ptr<std::vector<MeshLOD>>;
+
+// topology and constant data decoded for a variant selection
+struct MeshVariantData
+{
+    MeshSummary      summary;
+    VtArray<int>     counts;
+    VtArray<int>     offsets;
+    VtArray<int>     indices;
+    VtArray<int>     indices_triangulated;
+    VtArray<int>     indices_flattened_triangulated;
+    int              num_indices = 0;
+    int              num_indices_triangulated = 0;
+
+    VtArray<GfMatrix4f> bindposes;
+    VtArray<TfToken>    bones;
+    VtArray<const char*> bones_;
+    TfToken          root_bone;
+    VtArray<Weights4> weights4;
+    VtArray<Weights8> weights8;
+    int              max_bone_weights = 4;
+
+    // generation of the topology and remap tables made from it. restored on cache hit so that switching variants
+    // doesn't rebuild them. tables are immutable and shared with Mesh.
+    uint32_t         topology_gen = 0;
+    MeshSplitsPtr    splits;
+    MeshLODsPtr      lods;
+
+    size_t           size = 0; // in bytes
+
+    void assign(const MeshSample& src);
+    void restore(MeshSample& dst) const;
+    size_t calcSize() const;
 };
 
 
@@ -71,9 +117,17 @@ public:
     ~Mesh() override;
 
     void                updateSample(Time t) override;
+    void                resync(bool attributes, const TfTokenVector& changed) override;
 
     const MeshSummary&  getSummary() const;
+    // read the sample made by the last updateSample(). never updates by itself. t is used only by baked caches.
+    // if copy is false, pointers in dst stay valid until next readSample(copy=false) of this mesh by any caller
+    // even if updateSample() is running on other threads. use acquireSample() to hold several samples.
     bool                readSample(MeshData& dst, Time t, bool copy);
+    // same as readSample(copy=false) but pointers in dst stay valid until releaseSample(handle).
+    // any number of handles can be held at the same time. return -1 if no sample is available.
+    int                 acquireSample(MeshData& dst, Time t);
+    void                releaseSample(int handle);
     bool                writeSample(const MeshData& src, Time t);
 
     using SampleCallback = std::function<void(const MeshData& data, Time t)>;
@@ -87,11 +141,32 @@ public:
     void                assignBones(MeshData& dst, const char **v, int n);
 
 private:
-    typedef std::vector<SubmeshSample> SubmeshSamples;
+    typedef std::list<std::pair<std::string, MeshVariantData>> VariantCache; // front is most recently used
+
+    void                findAttributes();
+    std::string         makeVariantKey() const;
+    const MeshVariantData* findVariantCache(const std::string& key);
+    void                addVariantCache(const std::string& key, const MeshSample& sample, size_t budget);
+    void                clearVariantCache();
 
     UsdGeomMesh         m_mesh;
-    MeshSample          m_sample[2], *m_front_sample = nullptr;
-    SubmeshSamples      m_submeshes[2], *m_front_submesh = nullptr;
+    SampleBuffer<MeshSample> m_samples;
+    std::atomic_int     m_read_buffer = { -1 }; // buffer held by last readSample(copy=false)
+    MeshSample          m_export_sample;
+    uint32_t            m_topology_gen = 1; // topology of the latest sample
+    uint32_t            m_topology_gen_seed = 1;
+    uint32_t            m_constant_gen = 1;
+    // counts or indices are edited on the stage. see resync()
+    bool                m_topology_dirty = false;
+    // vertex -> faces connection for normal generation. valid while m_connection_gen == topology_gen of the sample.
+    MeshConnectionInfo  m_connection;
+    uint32_t            m_connection_gen = 0;
+    // vertex remap of submeshes for split_mesh. valid while m_splits_gen == topology_gen of the sample.
+    MeshSplitsPtr       m_splits;
+    uint32_t            m_splits_gen = 0;
+    // collapse results of levels of detail. decided once per topology and applied to points of every sample.
+    MeshLODsPtr         m_lods;
+    uint32_t            m_lods_gen = 0;
     Attribute           *m_attr_colors = nullptr;
     Attribute           *m_attr_uv = nullptr;
     Attribute           *m_attr_tangents = nullptr;
@@ -108,7 +183,10 @@ private:
     mutable MeshSummary m_summary;
     int                 m_num_indices = 0;
     int                 m_num_indices_triangulated = 0;
-    int                 m_num_current_submeshes = 0;
+
+    VariantCache        m_variant_cache;
+    size_t              m_variant_cache_size = 0;
+    std::string         m_variant_key;
 };
 
 } // namespace usdi
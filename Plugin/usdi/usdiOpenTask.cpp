@@ -0,0 +1,139 @@
+#include "pch.h"
+#include "usdiInternal.h"
+#include "usdiSchema.h"
+#include "usdiContext.h"
+#include "usdiOpenTask.h"
+#include "usdiTaskArena.h"
+
+namespace usdi {
+
+OpenTask::OpenTask(Context *ctx, const char *path, const OpenSettings *settings)
+    : m_ctx(ctx)
+    , m_path(path)
+{
+    if (settings) {
+        m_settings = *settings;
+        // prim paths must outlive the caller's array
+        if (settings->prim_paths) {
+            for (int i = 0; i < settings->num_prim_paths; ++i) {
+                if (settings->prim_paths[i]) {
+                    m_prim_paths.push_back(settings->prim_paths[i]);
+                }
+            }
+        }
+        for (auto& p : m_prim_paths) {
+            m_prim_path_ptrs.push_back(p.c_str());
+        }
+        m_settings.prim_paths = m_prim_path_ptrs.empty() ? nullptr : m_prim_path_ptrs.data();
+        m_settings.num_prim_paths = (int)m_prim_path_ptrs.size();
+    }
+}
+
+OpenTask::~OpenTask()
+{
+    cancel();
+    wait();
+}
+
+void OpenTask::start()
+{
+    {
+        lock_t lock(m_mutex);
+        if (m_running) { return; }
+        m_running = true;
+        m_succeeded = false;
+        m_progress = OpenProgress();
+        m_completed.clear();
+    }
+    m_canceled = false;
+    m_ctx->beginAsyncOpen();
+    m_ctx->getTaskArena().enqueue([this]() { process(); });
+}
+
+void OpenTask::cancel()
+{
+    m_canceled = true;
+}
+
+bool OpenTask::wait()
+{
+    lock_t lock(m_mutex);
+    m_cond.wait(lock, [this]() { return !m_running; });
+    return m_succeeded;
+}
+
+void OpenTask::getProgress(OpenProgress& dst)
+{
+    lock_t lock(m_mutex);
+    dst = m_progress;
+}
+
+Schema* OpenTask::getCompletedSubtree(int i)
+{
+    lock_t lock(m_mutex);
+    return i >= 0 && i < (int)m_completed.size() ? m_completed[i] : nullptr;
+}
+
+bool OpenTask::isCanceled() const
+{
+    return m_canceled;
+}
+
+void OpenTask::setPhase(OpenPhase v)
+{
+    lock_t lock(m_mutex);
+    m_progress.phase = v;
+    m_progress.phase_progress = 0.0f;
+}
+
+void OpenTask::setPhaseProgress(float v)
+{
+    lock_t lock(m_mutex);
+    m_progress.phase_progress = v;
+}
+
+void OpenTask::addLayer()
+{
+    lock_t lock(m_mutex);
+    ++m_progress.num_layers;
+}
+
+void OpenTask::addCompletedSubtree(Schema *schema, int num_schemas)
+{
+    lock_t lock(m_mutex);
+    m_completed.push_back(schema);
+    m_progress.num_completed_subtrees = (int)m_completed.size();
+    m_progress.num_schemas = num_schemas;
+}
+
+void OpenTask::clearCompletedSubtrees()
+{
+    lock_t lock(m_mutex);
+    m_completed.clear();
+    m_progress.num_completed_subtrees = 0;
+}
+
+void OpenTask::process()
+{
+    bool ret = m_ctx->open(m_path.c_str(), m_settings, this);
+
+    lock_t lock(m_mutex);
+    m_succeeded = ret;
+    if (ret) {
+        m_progress.phase = OpenPhase::Completed;
+        m_progress.phase_progress = 1.0f;
+        m_progress.num_schemas = m_ctx->getNumSchemas();
+    }
+    else {
+        // schemas are already unpublished and destroyed by Context::open()
+        m_progress.phase = m_canceled ? OpenPhase::Canceled : OpenPhase::Failed;
+        m_progress.num_schemas = 0;
+        m_progress.num_completed_subtrees = 0;
+        m_completed.clear();
+    }
+    m_ctx->endAsyncOpen();
+    m_running = false;
+    m_cond.notify_all();
+}
+
+} // namespace usdi
@@ -0,0 +1,56 @@
+#pragma once
+
+namespace usdi {
+
+// asynchronous Context::open() (usdiOpenAsync()).
+// the stage is opened and the schema tree is built on a worker of the context's arena. progress is reported by phases and
+// subtrees under the root are published as soon as they are registered.
+// no other APIs of the context can be called until the task finishes.
+class OpenTask
+{
+public:
+    OpenTask(Context *ctx, const char *path, const OpenSettings *settings);
+    // cancels and waits the task
+    ~OpenTask();
+
+    void    start();
+    void    cancel();
+    // returns true if the stage is opened and the schema tree is completely built
+    bool    wait();
+    void    getProgress(OpenProgress& dst);
+    // subtrees under the root that are completely built and registered. they can be used while the rest is being built,
+    // but the context is locked during the build. per-schema APIs (update, read, summaries, attributes, children that
+    // are already linked) don't need the lock, but Context::findSchema() / findChild() etc block until the build ends.
+    // all of them are destroyed if the task is canceled or failed. they are unpublished (this returns null) first.
+    Schema* getCompletedSubtree(int i);
+
+    // called by Context on the worker
+    bool    isCanceled() const;
+    void    setPhase(OpenPhase v);
+    void    setPhaseProgress(float v);
+    void    addLayer();
+    void    addCompletedSubtree(Schema *schema, int num_schemas);
+    void    clearCompletedSubtrees();
+
+private:
+    using lock_t = std::unique_lock<std::mutex>;
+
+    void    process();
+
+private:
+    Context *m_ctx = nullptr;
+    std::string m_path;
+    OpenSettings m_settings;
+    std::vector<std::string> m_prim_paths;
+    std::vector<const char*> m_prim_path_ptrs;
+
+    std::mutex m_mutex;
+    std::condition_variable m_cond;
+    bool    m_running = false;
+    bool    m_succeeded = false;
+    std::atomic_bool m_canceled = { false };
+    OpenProgress m_progress;
+    std::vector<Schema*> m_completed;
+};
+
+} // namespace usdi
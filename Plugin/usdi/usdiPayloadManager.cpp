@@ -0,0 +1,383 @@
+#include "pch.h"
+#include "usdiInternal.h"
+#include "usdiSchema.h"
+#include "usdiContext.h"
+#include "usdiPayloadManager.h"
+#include "usdiTaskArena.h"
+#include "usdiUtils.h"
+
+namespace usdi {
+
+PayloadManager::PayloadManager(Context *ctx)
+    : m_ctx(ctx)
+{
+}
+
+PayloadManager::~PayloadManager()
+{
+    clear();
+}
+
+void PayloadManager::setCameraPosition(const float3& pos)
+{
+    lock_t lock(m_mutex);
+    m_camera_position = pos;
+    // requests postponed by budget may fit now
+    kickWorker();
+}
+
+void PayloadManager::setMemoryBudget(size_t size)
+{
+    lock_t lock(m_mutex);
+    m_budget = size;
+    kickWorker();
+}
+
+void PayloadManager::requestLoadAll()
+{
+    {
+        lock_t lock(m_mutex);
+        m_load_all = true;
+    }
+    queueLoadables(SdfPath::AbsoluteRootPath());
+}
+
+void PayloadManager::requestLoad(Schema *schema)
+{
+    if (!schema || !schema->hasPayload()) { return; }
+
+    auto same = [schema](const Request& r) { return r.schema == schema; };
+    {
+        lock_t lock(m_mutex);
+        // cancel unload if it is not done yet
+        auto it = std::find_if(m_unload.begin(), m_unload.end(), same);
+        if (it != m_unload.end()) {
+            m_used += it->size;
+            m_loaded.push_back(std::move(*it));
+            m_unload.erase(it);
+            return;
+        }
+        // being opened. revive it if unload was requested meanwhile
+        if (m_in_flight == schema) {
+            m_in_flight_dropped = false;
+            return;
+        }
+        if (std::any_of(m_pending.begin(), m_pending.end(), same) ||
+            std::any_of(m_ready.begin(), m_ready.end(), same) ||
+            std::any_of(m_loaded.begin(), m_loaded.end(), same))
+        {
+            return;
+        }
+    }
+
+    Request r;
+    if (!makeRequest(schema, r)) { return; }
+
+    lock_t lock(m_mutex);
+    m_pending.push_back(std::move(r));
+    kickWorker();
+}
+
+void PayloadManager::requestUnload(Schema *schema)
+{
+    if (!schema || !schema->hasPayload()) { return; }
+
+    auto same = [schema](const Request& r) { return r.schema == schema; };
+    lock_t lock(m_mutex);
+    m_pending.erase(std::remove_if(m_pending.begin(), m_pending.end(), same), m_pending.end());
+    unloadDescendants(schema->getUsdPrim().GetPath());
+    if (m_in_flight == schema) {
+        // not composed into the stage yet. the worker discards it.
+        m_in_flight_dropped = true;
+        return;
+    }
+
+    // not composed into the stage yet. just discard it.
+    auto rit = std::find_if(m_ready.begin(), m_ready.end(), same);
+    if (rit != m_ready.end()) {
+        m_used -= rit->size;
+        m_ready.erase(rit);
+        return;
+    }
+
+    if (std::any_of(m_unload.begin(), m_unload.end(), same)) { return; }
+    auto lit = std::find_if(m_loaded.begin(), m_loaded.end(), same);
+    if (lit != m_loaded.end()) {
+        m_used -= lit->size;
+        m_unload.push_back(std::move(*lit));
+        m_loaded.erase(lit);
+    }
+    else {
+        // loaded on open or by Schema::loadPayload()
+        Request r;
+        r.schema = schema;
+        r.path = schema->getUsdPrim().GetPath();
+        m_unload.push_back(std::move(r));
+    }
+}
+
+int PayloadManager::getNumPending()
+{
+    lock_t lock(m_mutex);
+    return (int)(m_pending.size() + m_ready.size());
+}
+
+void PayloadManager::update()
+{
+    Requests ready, unload;
+    {
+        lock_t lock(m_mutex);
+        ready.swap(m_ready);
+        unload.swap(m_unload);
+    }
+    if (ready.empty() && unload.empty()) { return; }
+
+    auto stage = m_ctx->getUsdStage();
+    if (!stage) { return; }
+
+    // compose all at once. this is much faster than loading payloads one by one
+    // because each Load() triggers recomposition.
+    SdfPathSet load_set, unload_set;
+    for (auto& r : ready) { load_set.insert(r.path); }
+    for (auto& r : unload) { unload_set.insert(r.path); }
+    ArResolverScopedCache resolver_cache;
+    Context::NoticeBlocker blocker(m_ctx);
+    stage->LoadAndUnload(load_set, unload_set);
+
+    for (auto& r : unload) {
+        m_ctx->detachPayload(r.schema);
+    }
+    for (auto& r : ready) {
+        m_ctx->attachPayload(r.schema);
+        // the stage holds the layer now
+        r.layer = SdfLayerRefPtr();
+    }
+
+    bool load_all;
+    {
+        lock_t lock(m_mutex);
+        for (auto& r : ready) { m_loaded.push_back(std::move(r)); }
+        load_all = m_load_all;
+    }
+
+    // payloads can contain payloads
+    if (load_all) {
+        for (auto& path : load_set) {
+            queueLoadables(path);
+        }
+    }
+}
+
+void PayloadManager::clear()
+{
+    lock_t lock(m_mutex);
+    m_canceled = true;
+    m_cond.wait(lock, [this]() { return !m_worker_running; });
+
+    m_pending.clear();
+    m_ready.clear();
+    m_loaded.clear();
+    m_unload.clear();
+    m_used = 0;
+    m_load_all = false;
+    m_canceled = false;
+}
+
+void PayloadManager::forgetSchemas(const std::unordered_set<Schema*>& schemas)
+{
+    auto forget = [&schemas](const Request& r) { return schemas.find(r.schema) != schemas.end(); };
+    // sizes of ready and loaded ones are counted in m_used
+    auto forget_used = [&](const Request& r) {
+        if (!forget(r)) { return false; }
+        m_used -= r.size;
+        return true;
+    };
+
+    lock_t lock(m_mutex);
+    m_pending.erase(std::remove_if(m_pending.begin(), m_pending.end(), forget), m_pending.end());
+    m_ready.erase(std::remove_if(m_ready.begin(), m_ready.end(), forget_used), m_ready.end());
+    m_loaded.erase(std::remove_if(m_loaded.begin(), m_loaded.end(), forget_used), m_loaded.end());
+    m_unload.erase(std::remove_if(m_unload.begin(), m_unload.end(), forget), m_unload.end());
+    if (m_in_flight && schemas.find(m_in_flight) != schemas.end()) {
+        m_in_flight_dropped = true;
+    }
+}
+
+void PayloadManager::unloadDescendants(const SdfPath& path)
+{
+    auto is_descendant = [&path](const Request& r) { return r.path != path && r.path.HasPrefix(path); };
+
+    m_pending.erase(std::remove_if(m_pending.begin(), m_pending.end(), is_descendant), m_pending.end());
+    // not composed yet. just discard
+    m_ready.erase(std::remove_if(m_ready.begin(), m_ready.end(), [&](const Request& r) {
+        if (!is_descendant(r)) { return false; }
+        m_used -= r.size;
+        return true;
+    }), m_ready.end());
+    for (auto it = m_loaded.begin(); it != m_loaded.end();) {
+        if (is_descendant(*it)) {
+            m_used -= it->size;
+            m_unload.push_back(std::move(*it));
+            it = m_loaded.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+    if (m_in_flight && m_in_flight_path != path && m_in_flight_path.HasPrefix(path)) {
+        m_in_flight_dropped = true;
+    }
+}
+
+bool PayloadManager::makeRequest(Schema *schema, Request& dst)
+{
+    auto stage = m_ctx->getUsdStage();
+    auto prim = schema->getUsdPrim();
+    if (!stage || !prim.IsValid()) { return false; }
+
+    dst.schema = schema;
+    dst.path = prim.GetPath();
+
+    const auto& conf = m_ctx->getImportSettings();
+    UsdGeomXformCache xf_cache;
+    auto pos = xf_cache.GetLocalToWorldTransform(prim).ExtractTranslation();
+    dst.position = { (float)pos[0], (float)pos[1], (float)pos[2] };
+    if (conf.swap_handedness) {
+        dst.position.x *= -1.0f;
+    }
+    dst.position *= conf.scale;
+
+    // resolve payload asset to open it in background and to estimate its size
+    SdfPayload payload;
+    if (prim.GetMetadata(SdfFieldKeys->Payload, &payload) && !payload.GetAssetPath().empty()) {
+        ArResolverContextBinder binder(stage->GetPathResolverContext());
+        auto asset_path = SdfComputeAssetPathRelativeToLayer(stage->GetRootLayer(), payload.GetAssetPath());
+        dst.asset_path = ArGetResolver().Resolve(asset_path);
+        if (!dst.asset_path.empty()) {
+            if (FILE *f = fopen(dst.asset_path.c_str(), "rb")) {
+                fseek(f, 0, SEEK_END);
+                dst.size = (size_t)ftell(f);
+                fclose(f);
+            }
+        }
+        else {
+            usdiLogWarning("PayloadManager::makeRequest(): failed to resolve %s\n", payload.GetAssetPath().c_str());
+        }
+    }
+    return true;
+}
+
+bool PayloadManager::popNext(Request& dst)
+{
+    if (m_pending.empty()) { return false; }
+
+    // nearest first
+    auto it = std::min_element(m_pending.begin(), m_pending.end(), [this](const Request& a, const Request& b) {
+        return getDistance(a) < getDistance(b);
+    });
+    Request next = std::move(*it);
+    m_pending.erase(it);
+
+    if (m_budget > 0 && m_used + next.size > m_budget) {
+        // evict loaded payloads that are farther than this request. farthest first.
+        // ancestors of the request are kept. unloading them would unload the request too.
+        float d = getDistance(next);
+        std::sort(m_loaded.begin(), m_loaded.end(), [this](const Request& a, const Request& b) {
+            return getDistance(a) > getDistance(b);
+        });
+        std::vector<size_t> evict;
+        size_t freed = 0;
+        for (size_t i = 0; i < m_loaded.size(); ++i) {
+            auto& l = m_loaded[i];
+            if (m_used - freed + next.size <= m_budget || getDistance(l) <= d) { break; }
+            if (next.path.HasPrefix(l.path)) { continue; }
+            freed += l.size;
+            evict.push_back(i);
+        }
+        // doesn't fit. wait until camera moves or budget changes.
+        if (m_used - freed + next.size > m_budget) {
+            m_pending.push_back(std::move(next));
+            return false;
+        }
+
+        SdfPathVector evicted;
+        for (auto i = evict.rbegin(); i != evict.rend(); ++i) {
+            evicted.push_back(m_loaded[*i].path);
+            m_unload.push_back(std::move(m_loaded[*i]));
+            m_loaded.erase(m_loaded.begin() + *i);
+        }
+        m_used -= freed;
+        for (auto& path : evicted) {
+            unloadDescendants(path);
+        }
+    }
+
+    m_used += next.size;
+    dst = std::move(next);
+    return true;
+}
+
+float PayloadManager::getDistance(const Request& r) const
+{
+    auto d = r.position - m_camera_position;
+    return dot(d, d);
+}
+
+void PayloadManager::kickWorker()
+{
+    if (m_worker_running || m_canceled || m_pending.empty()) { return; }
+    m_worker_running = true;
+    m_ctx->getTaskArena().enqueue([this]() { process(); });
+}
+
+void PayloadManager::process()
+{
+    for (;;) {
+        Request r;
+        {
+            lock_t lock(m_mutex);
+            if (m_canceled || !popNext(r)) {
+                m_worker_running = false;
+                m_cond.notify_all();
+                return;
+            }
+            m_in_flight = r.schema;
+            m_in_flight_path = r.path;
+            m_in_flight_dropped = false;
+        }
+
+        // opening layer (file I/O and parsing) is the heavy part of loading payload.
+        // this doesn't touch the stage so it is safe to do while main thread is reading it.
+        if (!r.asset_path.empty()) {
+            r.layer = SdfLayer::FindOrOpen(r.asset_path);
+        }
+
+        lock_t lock(m_mutex);
+        if (m_in_flight_dropped) {
+            // unloaded or destroyed while opening
+            m_used -= r.size;
+        }
+        else {
+            m_ready.push_back(std::move(r));
+        }
+        m_in_flight = nullptr;
+        m_in_flight_path = SdfPath();
+    }
+}
+
+void PayloadManager::queueLoadables(const SdfPath& root)
+{
+    auto stage = m_ctx->getUsdStage();
+    if (!stage) { return; }
+
+    auto loaded = stage->GetLoadSet();
+    for (auto& path : stage->FindLoadable(root)) {
+        if (loaded.find(path) != loaded.end()) { continue; }
+        // findSchema() materializes the path in lazy mode. excluded prims have no schema and are not loaded.
+        if (auto *schema = m_ctx->findSchema(path.GetText())) {
+            requestLoad(schema);
+        }
+    }
+}
+
+} // namespace usdi
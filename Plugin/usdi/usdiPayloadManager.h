@@ -0,0 +1,75 @@
+#pragma once
+
+namespace usdi {
+
+// loads payloads in background in priority order (distance to camera) within memory budget.
+// heavy part (opening payload layers) is done on worker thread. composing loaded layers into the stage and
+// attaching new subtrees to the schema tree are done in update(), which Context::updateAllSamples() calls.
+class PayloadManager
+{
+public:
+    PayloadManager(Context *ctx);
+    ~PayloadManager();
+
+    // position is in same space as samples (ImportSettings::scale and swap_handedness are applied)
+    void    setCameraPosition(const float3& pos);
+    // in bytes. 0 means unlimited. size of payload is estimated by file size of its asset.
+    void    setMemoryBudget(size_t size);
+    // load all payloads in the stage including ones in payloads loaded later
+    void    requestLoadAll();
+    void    requestLoad(Schema *schema);
+    void    requestUnload(Schema *schema);
+    int     getNumPending();
+
+    // must be called when no one else is accessing the stage
+    void    update();
+    // cancel all requests and wait worker
+    void    clear();
+    // drop requests of schemas that are being destroyed (see Context::destroyDetachedSchemas())
+    void    forgetSchemas(const std::unordered_set<Schema*>& schemas);
+
+private:
+    struct Request
+    {
+        Schema *schema = nullptr;
+        SdfPath path;
+        std::string asset_path; // resolved path of payload asset. can be empty (internal payload)
+        float3 position = float3::zero();
+        size_t size = 0;
+        SdfLayerRefPtr layer;   // keep opened layer alive until the stage loads it
+    };
+    using Requests = std::vector<Request>;
+    using lock_t = std::unique_lock<std::mutex>;
+
+    bool    makeRequest(Schema *schema, Request& dst);
+    bool    popNext(Request& dst); // m_mutex must be locked
+    float   getDistance(const Request& r) const; // squared. only used for ordering
+    void    kickWorker(); // m_mutex must be locked
+    // nested payloads go with their ancestor. m_mutex must be locked
+    void    unloadDescendants(const SdfPath& path);
+    void    process();
+    void    queueLoadables(const SdfPath& root);
+
+private:
+    Context *m_ctx = nullptr;
+    std::mutex m_mutex;
+    std::condition_variable m_cond;
+
+    float3  m_camera_position = float3::zero();
+    size_t  m_budget = 0;
+    size_t  m_used = 0;
+    bool    m_load_all = false;
+    bool    m_worker_running = false;
+    bool    m_canceled = false;
+    // request the worker is opening. dropped if unloaded or forgotten meanwhile.
+    Schema  *m_in_flight = nullptr;
+    SdfPath m_in_flight_path;
+    bool    m_in_flight_dropped = false;
+
+    Requests m_pending;
+    Requests m_ready;
+    Requests m_loaded;
+    Requests m_unload;
+};
+
+} // namespace usdi
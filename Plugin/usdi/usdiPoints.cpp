@@ -7,6 +7,7 @@
 #include "usdiContext.h"
 #include "usdiContext.i"
 #include "usdiAttribute.h"
+#include "usdiBakedCache.h"
 
 namespace usdi {
 
@@ -19,13 +20,28 @@ Points::Points(Context *ctx, Schema *parent, const UsdPrim& prim)
 {
     usdiLogTrace("Points::Points(): %s\n", getPath());
     if (!m_points) { usdiLogError("Points::Points(): m_points is invalid\n"); }
+    findAttributes();
+}
 
+void Points::findAttributes()
+{
+    m_attr_ids32 = nullptr;
     m_attr_ids64 = findAttribute("ids", AttributeType::Int64Array);
     if (m_attr_ids64) {
         m_attr_ids32 = m_attr_ids64->findOrCreateConverter(AttributeType::IntArray);
     }
 }
 
+void Points::resync(bool attributes, const TfTokenVector& changed)
+{
+    super::resync(attributes, changed);
+    m_summary_needs_update = true;
+    if (attributes) {
+        m_points = UsdGeomPoints(m_prim);
+        findAttributes();
+    }
+}
+
 Points::Points(Context *ctx, Schema *parent, const char *name, const char *type)
     : super(ctx, parent, name, type)
     , m_points(m_prim)
@@ -53,25 +69,21 @@ const PointsSummary& Points::getSummary() const
 void Points::updateSample(Time t_)
 {
     super::updateSample(t_);
-    if (m_update_flag.bits == 0) { return; }
-    if (m_update_flag.variant_set_changed) { m_summary_needs_update = true; }
+    if (updateFlag().bits == 0) { return; }
+    if (updateFlag().variant_set_changed) { m_summary_needs_update = true; }
 
     auto t = UsdTimeCode(t_);
     const auto& conf = getImportSettings();
 
-    // swap front sample
-    if (!m_front_sample) {
-        m_front_sample = &m_sample[0];
-    }
-    else if (conf.double_buffering) {
-        if (m_front_sample == &m_sample[0]) {
-            m_front_sample = &m_sample[1];
-        }
-        else {
-            m_front_sample = &m_sample[0];
-        }
+    // pick a buffer that no readers are holding. published by endWrite() at the end.
+    auto *psample = m_samples.beginWrite(!conf.double_buffering);
+    if (!psample) {
+        usdiLogWarning("Points::updateSample(): all sample buffers of %s are held by readers. skipped\n", getPath());
+        // retry on next update
+        updateFlagNext().sample_updated = 1;
+        return;
     }
-    auto& sample = *m_front_sample;
+    auto& sample = *psample;
 
     m_points.GetPointsAttr().Get(&sample.points, t);
     m_points.GetVelocitiesAttr().Get(&sample.velocities, t);
@@ -93,15 +105,13 @@ void Points::updateSample(Time t_)
     if (m_attr_ids32) {
         m_attr_ids32->getImmediate(&sample.ids32, t_);
     }
+
+    m_samples.endWrite();
 }
 
-bool Points::readSample(PointsData& dst, Time t, bool copy)
+// fill dst with sample. if copy is false, dst points to the sample's memory.
+static void ReadPointsSample(PointsData& dst, const PointsSample& sample, bool copy)
 {
-    if (t != m_time_prev) { updateSample(t); }
-
-    if (!m_front_sample) { return false; }
-    const auto& sample = *m_front_sample;
-
     dst.num_points = (uint)sample.points.size();
     if (copy) {
         if (dst.points && !sample.points.empty()) {
@@ -114,10 +124,10 @@ bool Points::readSample(PointsData& dst, Time t, bool copy)
             memcpy(dst.widths, sample.widths.data(), sizeof(float) * dst.num_points);
         }
         if (dst.ids64 && !sample.ids64.empty()) {
-            memcpy(dst.widths, sample.widths.data(), sizeof(int64_t) * dst.num_points);
+            memcpy(dst.ids64, sample.ids64.data(), sizeof(int64_t) * dst.num_points);
         }
         if (dst.ids32 && !sample.ids32.empty()) {
-            memcpy(dst.widths, sample.widths.data(), sizeof(int32_t) * dst.num_points);
+            memcpy(dst.ids32, sample.ids32.data(), sizeof(int32_t) * dst.num_points);
         }
     }
     else {
@@ -127,12 +137,52 @@ bool Points::readSample(PointsData& dst, Time t, bool copy)
         dst.ids64 = (int64_t*)sample.ids64.cdata();
         dst.ids32 = (int32_t*)sample.ids32.cdata();
     }
+}
 
+bool Points::readSample(PointsData& dst, Time t, bool copy)
+{
+    if (m_baked_entry >= 0) {
+        return m_ctx->getBakedCache()->readPoints(m_baked_entry, dst, t, copy);
+    }
+
+    if (copy) {
+        // the buffer is never overwritten while acquired
+        int ibuf = m_samples.acquire();
+        if (ibuf < 0) { return false; }
+        ReadPointsSample(dst, m_samples.get(ibuf), true);
+        m_samples.release(ibuf);
+    }
+    else {
+        // keep holding until next readSample(copy=false). the hold is shared by all callers.
+        int ibuf = acquireSample(dst, t);
+        m_samples.release(m_read_buffer.exchange(ibuf));
+        if (ibuf < 0) { return false; }
+    }
     return dst.num_points > 0;
 }
 
+int Points::acquireSample(PointsData& dst, Time t)
+{
+    if (m_baked_entry >= 0) {
+        // baked samples stay valid until the cache is closed
+        if (!m_ctx->getBakedCache()->readPoints(m_baked_entry, dst, t, false)) { return -1; }
+        return m_samples.ExternalHandle;
+    }
+
+    int ibuf = m_samples.acquire();
+    if (ibuf < 0) { return -1; }
+    ReadPointsSample(dst, m_samples.get(ibuf), false);
+    return ibuf;
+}
+
+void Points::releaseSample(int handle)
+{
+    m_samples.release(handle);
+}
+
 bool Points::writeSample(const PointsData& src, Time t_)
 {
+    if (!m_ctx->checkStageEditable("Points::writeSample()")) { return false; }
     auto t = UsdTimeCode(t_);
     const auto& conf = getExportSettings();
 
@@ -206,8 +256,11 @@ int Points::eachSample(const SampleCallback & cb)
 
     PointsData data;
     for (const auto& t : times) {
-        readSample(data, t.first, false);
+        // readSample() doesn't update. decode each time here (baked samples are read as is).
+        if (m_baked_entry < 0) { updateSample(t.first); }
+        int handle = acquireSample(data, t.first);
         cb(data, t.first);
+        releaseSample(handle);
     }
     return (int)times.size();
 }
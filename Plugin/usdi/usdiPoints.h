@@ -24,17 +24,28 @@ public:
     ~Points() override;
 
     void                    updateSample(Time t) override;
+    void                    resync(bool attributes, const TfTokenVector& changed) override;
 
     const PointsSummary&    getSummary() const;
+    // read the sample made by the last updateSample(). never updates by itself. t is used only by baked caches.
+    // if copy is false, pointers in dst stay valid until next readSample(copy=false) of this schema by any caller
+    // even if updateSample() is running on other threads. use acquireSample() to hold several samples.
     bool                    readSample(PointsData& dst, Time t, bool copy);
+    // same as readSample(copy=false) but pointers in dst stay valid until releaseSample(handle).
+    // any number of handles can be held at the same time. return -1 if no sample is available.
+    int                     acquireSample(PointsData& dst, Time t);
+    void                    releaseSample(int handle);
     bool                    writeSample(const PointsData& src, Time t);
 
     using SampleCallback = std::function<void(const PointsData& data, Time t)>;
     int eachSample(const SampleCallback& cb);
 
 private:
+    void                    findAttributes();
+
     UsdGeomPoints           m_points;
-    PointsSample            m_sample[2], *m_front_sample = nullptr;
+    SampleBuffer<PointsSample> m_samples;
+    std::atomic_int         m_read_buffer = { -1 }; // buffer held by last readSample(copy=false)
     Attribute               *m_attr_ids64 = nullptr;
     Attribute               *m_attr_ids32 = nullptr;
 
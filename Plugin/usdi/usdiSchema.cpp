@@ -10,12 +10,113 @@ namespace usdi {
 
 RegisterSchemaHandler(Schema)
 
+void SchemaUpdateStates::init(int i)
+{
+    flags[i].bits = 0;
+    flags_prev[i].bits = 0;
+    flags_next[i].bits = 0;
+    time_start[i] = usdiInvalidTime;
+    time_end[i] = usdiInvalidTime;
+    time_prev[i] = usdiInvalidTime;
+    time_range_synced[i] = false;
+}
+
+bool SchemaUpdateStates::isSampleUpdated(int i, Time t) const
+{
+    Time prev = time_prev[i];
+    if (std::isnan(prev)) { return true; }
+    if (t == prev) { return false; }
+    if (std::isnan(time_start[i])) { return false; }
+    if ((t <= time_start[i] && prev <= time_start[i]) || (t >= time_end[i] && prev >= time_end[i])) { return false; }
+    return true;
+}
+
+bool SchemaUpdateStates::isUpToDate(int i, Time t) const
+{
+    return flags[i].bits == 0 && flags_next[i].bits == 0 && time_range_synced[i] && !isSampleUpdated(i, t);
+}
+
+
+SchemaPool::SchemaPool(const std::type_info& type, size_t object_size)
+    : m_type(&type)
+    , m_stride((object_size + 15) & ~size_t(15))
+{
+}
+
+SchemaPool::~SchemaPool()
+{
+    clear();
+}
+
+const std::type_info& SchemaPool::getType() const
+{
+    return *m_type;
+}
+
+void* SchemaPool::allocate(SchemaUpdateStates *&states, int& slot)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    if (!m_free_slots.empty()) {
+        auto f = m_free_slots.back();
+        m_free_slots.pop_back();
+        slot = f.index;
+        states = &f.block->states;
+        states->init(slot);
+        return f.block->objects + m_stride * slot;
+    }
+    if (m_blocks.empty() || m_blocks.back()->num_objects == SchemaUpdateStates::Capacity) {
+        BlockPtr block(new Block());
+        block->objects = (char*)AlignedMalloc(m_stride * SchemaUpdateStates::Capacity, 64);
+        m_blocks.push_back(std::move(block));
+    }
+    auto& block = *m_blocks.back();
+    slot = block.num_objects++;
+    states = &block.states;
+    states->init(slot);
+    return block.objects + m_stride * slot;
+}
+
+void SchemaPool::free(SchemaUpdateStates *states, int slot)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    auto *block = getBlockOf(states);
+    // freed slots are left out of update lists (see Context::buildUpdateLists())
+    states->init(slot);
+    m_free_slots.push_back({ block, slot });
+}
+
+void SchemaPool::clear()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    for (auto& block : m_blocks) {
+        AlignedFree(block->objects);
+    }
+    m_blocks.clear();
+    m_free_slots.clear();
+}
+
+Schema* SchemaPool::getObject(const Block& block, int slot) const
+{
+    return (Schema*)(block.objects + m_stride * slot);
+}
+
+SchemaPool::Block* SchemaPool::getBlockOf(SchemaUpdateStates *states)
+{
+    // states is the first member of Block
+    return reinterpret_cast<Block*>(states);
+}
+
+
 Schema::Schema(Context *ctx, Schema *parent, Schema *master, const std::string& path, const UsdPrim& p)
     : m_ctx(ctx)
     , m_parent(parent)
     , m_master(master)
     , m_path(path)
     , m_prim(p)
+    , m_instance_proxy(true)
 {
     init();
 }
@@ -41,14 +142,13 @@ Schema::Schema(Context *ctx, Schema *parent, const char *name, const char *type)
     init();
 }
 
+// linking to parent and master is done by Context (see Context::addSchema() and Context::buildSchemaTree())
+// so that this can be called from multiple threads
 void Schema::init()
 {
-    if (m_parent) { m_parent->addChild(this); }
-    if (m_master) { m_master->addInstance(this); }
     if (m_prim && !m_master) {
+        // attributes are wrapped and time range is computed on first access
         m_path = m_prim.GetPath().GetString();
-        syncAttributes();
-        syncTimeRange();
         syncVariantSets();
     }
 }
@@ -57,24 +157,43 @@ void Schema::setup()
 {
 }
 
+void Schema::bindUpdateStates(SchemaUpdateStates *states, int slot)
+{
+    m_states = states;
+    m_slot = slot;
+    // schemas without their own time range (instances) never need to sync it
+    timeRangeSynced() = !hasOwnTimeRange();
+}
+
 void Schema::syncAttributes()
 {
-    m_attributes.clear();
-    auto attrs = m_prim.GetAuthoredAttributes();
-    for (auto attr : attrs) {
-        if (auto *ret = WrapExistingAttribute(this, attr)) {
-            m_attributes.emplace_back(ret);
+    // wrap all authored attributes in authored order.
+    // keep existing ones. user may hold pointers to them.
+    m_attributes_synced = true;
+    Attributes attrs;
+    for (auto& a : m_prim.GetAuthoredAttributes()) {
+        auto it = std::find_if(m_attributes.begin(), m_attributes.end(), [&a](const AttributePtr& p) {
+            return p && p->getNameToken() == a.GetName();
+        });
+        if (it != m_attributes.end()) {
+            attrs.push_back(std::move(*it));
+        }
+        else if (auto *ret = WrapExistingAttribute(this, a)) {
+            attrs.emplace_back(ret);
         }
     }
+    m_attributes = std::move(attrs);
 }
 
 void Schema::syncTimeRange()
 {
+    // attributes are not need to be wrapped to get time range
+    timeRangeSynced() = true;
     double lower = usdiInvalidTime;
     double upper = usdiInvalidTime;
-    for (auto& a : m_attributes) {
+    for (auto& a : m_prim.GetAuthoredAttributes()) {
         double l, u;
-        a->getTimeRange(l, u);
+        GetAttributeTimeRange(a, l, u);
         if (!std::isnan(l)) {
             if (std::isnan(lower)) {
                 lower = l;
@@ -86,21 +205,68 @@ void Schema::syncTimeRange()
             }
         }
     }
-    m_time_start = lower;
-    m_time_end = upper;
+    timeStart() = lower;
+    timeEnd() = upper;
+}
+
+void Schema::syncAttributesIfNeeded() const
+{
+    if (!m_attributes_synced && m_prim && !m_master) {
+        const_cast<Schema*>(this)->syncAttributes();
+    }
+}
+
+void Schema::syncTimeRangeIfNeeded() const
+{
+    if (!timeRangeSynced() && hasOwnTimeRange()) {
+        const_cast<Schema*>(this)->syncTimeRange();
+    }
+}
+
+Attribute* Schema::findOrWrapAttribute(const TfToken& name) const
+{
+    // TfToken comparison is just a pointer comparison
+    for (const auto& a : m_attributes) {
+        if (a->getNameToken() == name) {
+            return a.get();
+        }
+    }
+    if (m_attributes_synced || !m_prim || m_master) { return nullptr; }
+
+    // hashed lookup in the prim. only requested attribute is wrapped.
+    auto attr = m_prim.GetAttribute(name);
+    if (!attr || !attr.IsAuthored()) { return nullptr; }
+    auto *ret = WrapExistingAttribute(const_cast<Schema*>(this), attr);
+    if (ret) {
+        const_cast<Schema*>(this)->m_attributes.emplace_back(ret);
+    }
+    return ret;
+}
+
+void Schema::materializeChildren()
+{
+    if (!m_children_materialized) {
+        m_ctx->materializeChildren(this);
+    }
 }
 
-void Schema::syncVariantSets()
+bool Schema::syncVariantSets()
 {
     std::vector<std::string> names;
     auto vsets = m_prim.GetVariantSets();
     vsets.GetNames(&names);
+    bool ret = names.size() != m_variant_sets.size();
     m_variant_sets.resize(names.size());
     for (size_t i = 0; i < names.size(); ++i) {
         auto vset = vsets.GetVariantSet(names[i]);
-        m_variant_sets[i].name = names[i];
-        m_variant_sets[i].variants = vset.GetVariantNames();
+        auto sel = vset.GetVariantSelection();
+        auto& dst = m_variant_sets[i];
+        if (dst.name != names[i] || dst.selection != sel) { ret = true; }
+        dst.name = names[i];
+        dst.variants = vset.GetVariantNames();
+        dst.selection = sel;
     }
+    return ret;
 }
 
 Schema::~Schema()
@@ -108,6 +274,16 @@ Schema::~Schema()
     m_attributes.clear();
 }
 
+void SchemaDeleter::operator()(Schema *s) const
+{
+    auto *ctx = s->m_ctx;
+    const auto& type = typeid(*s);
+    auto *states = s->m_states;
+    int slot = s->m_slot;
+    s->~Schema();
+    ctx->freeSchema(type, states, slot);
+}
+
 Context*    Schema::getContext() const      { return m_ctx; }
 int         Schema::getID() const           { return m_id; }
 const char* Schema::getPath() const { return m_path.c_str(); }
@@ -117,19 +293,25 @@ UsdPrim Schema::getUsdPrim() const { return m_prim; }
 
 void Schema::getTimeRange(Time& start, Time& end) const
 {
-    start = m_time_start;
-    end = m_time_end;
+    lock_t lock(m_attr_mutex);
+    syncTimeRangeIfNeeded();
+    start = timeStart();
+    end = timeEnd();
 }
 
 // attribute interface
 
 int Schema::getNumAttributes() const
 {
+    lock_t lock(m_attr_mutex);
+    syncAttributesIfNeeded();
     return (int)m_attributes.size();
 }
 
 Attribute* Schema::getAttribute(int i) const
 {
+    lock_t lock(m_attr_mutex);
+    syncAttributesIfNeeded();
     if (i < 0 || i >= m_attributes.size()) {
         usdiLogError("Schema::getAttribute() i < 0 || i >= m_attributes.size()\n");
         return nullptr;
@@ -139,17 +321,16 @@ Attribute* Schema::getAttribute(int i) const
 
 Attribute* Schema::findAttribute(const char *name, AttributeType type) const
 {
-    for (const auto& a : m_attributes) {
-        if (strcmp(a->getName(), name) == 0) {
-            if (type == AttributeType::Unknown || a->getType() == type) {
-                return a.get();
-            }
-            else {
-                return a->findOrCreateConverter(type);
-            }
-        }
+    if (!name) { return nullptr; }
+    lock_t lock(m_attr_mutex);
+    auto *a = findOrWrapAttribute(TfToken(name));
+    if (!a) { return nullptr; }
+    if (type == AttributeType::Unknown || a->getType() == type) {
+        return a;
+    }
+    else {
+        return a->findOrCreateConverter(type);
     }
-    return nullptr;
 }
 
 Attribute* Schema::createAttribute(const char *name, AttributeType type, AttributeType internal_type)
@@ -157,6 +338,7 @@ Attribute* Schema::createAttribute(const char *name, AttributeType type, Attribu
     if (auto *f = findAttribute(name, type)) {
         return f;
     }
+    if (!m_ctx->checkStageEditable("Schema::createAttribute()")) { return nullptr; }
 
     if (internal_type == AttributeType::Unknown) {
         switch (type) {
@@ -173,6 +355,7 @@ Attribute* Schema::createAttribute(const char *name, AttributeType type, Attribu
     }
 
     if (auto *c = CreateAttribute(this, name, internal_type)) {
+        lock_t lock(m_attr_mutex);
         m_attributes.emplace_back(c);
         return c->findOrCreateConverter(type);
     }
@@ -183,18 +366,11 @@ Attribute* Schema::createAttribute(const char *name, AttributeType type, Attribu
 // parent & child interface
 
 Schema* Schema::getParent() const       { return m_parent; }
-int     Schema::getNumChildren() const  { return (int)m_children.size(); }
-Schema* Schema::getChild(int i) const   { return m_children[i]; }
-Schema* Schema::findChild(const char * path, bool recursive) const
-{
-    auto ret = FindSchema(m_children, path);
-    if (!ret && recursive) {
-        for (auto child : m_children) {
-            ret = child->findChild(path, recursive);
-            if (ret) { break; }
-        }
-    }
-    return ret;
+int     Schema::getNumChildren()        { materializeChildren(); return (int)m_children.size(); }
+Schema* Schema::getChild(int i)         { materializeChildren(); return m_children[i]; }
+Schema* Schema::findChild(const char * path, bool recursive)
+{
+    return m_ctx->findChild(this, path, recursive);
 }
 
 
@@ -212,10 +388,15 @@ bool    Schema::isInstance() const      { return m_master != nullptr || m_prim.I
 bool    Schema::isInstanceable() const  { return m_prim.IsInstanceable(); }
 bool    Schema::isMaster() const        { return m_prim.IsMaster(); }
 bool    Schema::isInMaster() const      { return m_prim.IsInMaster(); }
-void    Schema::setInstanceable(bool v) { m_prim.SetInstanceable(v); }
+void Schema::setInstanceable(bool v)
+{
+    if (!m_ctx->checkStageEditable("Schema::setInstanceable()")) { return; }
+    m_prim.SetInstanceable(v);
+}
 
 bool Schema::addReference(const char *asset_path, const char *prim_path)
 {
+    if (!m_ctx->checkStageEditable("Schema::addReference()")) { return false; }
     if (!asset_path) { asset_path = ""; }
     return m_prim.GetReferences().AppendReference(SdfReference(asset_path, SdfPath(prim_path)));
 }
@@ -229,20 +410,25 @@ bool Schema::hasPayload() const
 }
 void Schema::loadPayload()
 {
+    if (!m_ctx->checkStageEditable("Schema::loadPayload()")) { return; }
     if (hasPayload()) {
+        Context::NoticeBlocker blocker(m_ctx);
         m_prim.Load();
-        m_update_flag_next.payload_loaded = 1;
+        m_ctx->attachPayload(this);
     }
 }
 void Schema::unloadPayload()
 {
+    if (!m_ctx->checkStageEditable("Schema::unloadPayload()")) { return; }
     if (hasPayload()) {
+        Context::NoticeBlocker blocker(m_ctx);
         m_prim.Unload();
-        m_update_flag_next.payload_unloaded = 1;
+        m_ctx->detachPayload(this);
     }
 }
 bool Schema::setPayload(const char *asset_path, const char *prim_path)
 {
+    if (!m_ctx->checkStageEditable("Schema::setPayload()")) { return false; }
     return m_prim.SetPayload(
         SdfPayload(std::string(asset_path), SdfPath(prim_path)));
 }
@@ -311,6 +497,7 @@ bool Schema::setVariantSelection(int iset, int ival)
         usdiLogError("Schema::setVariantSelection(): iset >= m_variant_sets.size()\n");
         return false;
     }
+    if (!m_ctx->checkStageEditable("Schema::setVariantSelection()")) { return false; }
 
     auto& vset = m_variant_sets[iset];
     auto dst = m_prim.GetVariantSet(vset.name);
@@ -329,7 +516,7 @@ bool Schema::setVariantSelection(int iset, int ival)
     }
 
     if (ret) {
-        m_update_flag_next.variant_set_changed = 1;
+        updateFlagNext().variant_set_changed = 1;
     }
     return ret;
 }
@@ -362,6 +549,7 @@ int Schema::findVariant(int iset, const char *name) const
 
 bool Schema::beginEditVariant(const char *set, const char *variant)
 {
+    if (!m_ctx->checkStageEditable("Schema::beginEditVariant()")) { return false; }
     auto vset = m_prim.GetVariantSets().GetVariantSet(set);
     if (!variant) {
         vset.ClearVariantSelection();
@@ -370,7 +558,9 @@ bool Schema::beginEditVariant(const char *set, const char *variant)
     else {
         vset.AppendVariant(variant);
         vset.SetVariantSelection(variant);
-        syncVariantSets();
+        if (syncVariantSets()) {
+            updateFlagNext().variant_set_changed = 1;
+        }
         m_ctx->beginEdit(vset.GetVariantEditTarget());
         return true;
     }
@@ -413,46 +603,79 @@ void Schema::editVariants(const std::function<void()>& body)
     }
 }
 
+void Schema::resync(bool attributes, const TfTokenVector& changed)
+{
+    bool selection_changed = false;
+    if (!m_master && m_prim.IsValid()) {
+        lock_t lock(m_attr_mutex);
+        if (attributes) {
+            // handles are expired if the prim is re-composed. rebind wrapped ones and drop removed ones.
+            // attributes not wrapped yet are wrapped on first access.
+            m_attributes.erase(std::remove_if(m_attributes.begin(), m_attributes.end(), [this](const AttributePtr& p) {
+                auto a = m_prim.GetAttribute(p->getNameToken());
+                if (!a || !a.IsAuthored()) { return true; }
+                p->rebind(a);
+                return false;
+            }), m_attributes.end());
+            m_attributes_synced = false;
+        }
+        for (auto& a : m_attributes) {
+            if (changed.empty() || std::find(changed.begin(), changed.end(), a->getNameToken()) != changed.end()) {
+                a->invalidate();
+            }
+        }
+        timeRangeSynced() = !hasOwnTimeRange();
+        lock.release();
+        selection_changed = syncVariantSets();
+    }
+
+    // summaries and cached data are refreshed by subclasses. value edits are not variant switches.
+    updateFlagNext().sample_updated = 1;
+    if (selection_changed) {
+        updateFlagNext().variant_set_changed = 1;
+    }
+    for (auto *i : m_instances) {
+        i->m_prim = m_prim;
+        i->resync(false, changed);
+        if (selection_changed) {
+            i->updateFlagNext().variant_set_changed = 1;
+        }
+    }
+}
+
 void Schema::notifyForceUpdate()
 {
-    m_update_flag_next.sample_updated = 1;
+    updateFlagNext().sample_updated = 1;
 }
 
 void Schema::notifyImportConfigChanged()
 {
-    m_update_flag_next.import_settings_updated = 1;
+    updateFlagNext().import_settings_updated = 1;
 }
 
-UpdateFlags Schema::getUpdateFlags() const { return m_update_flag; }
-UpdateFlags Schema::getUpdateFlagsPrev() const  { return m_update_flag_prev; }
+UpdateFlags Schema::getUpdateFlags() const { return updateFlag(); }
+UpdateFlags Schema::getUpdateFlagsPrev() const  { return updateFlagPrev(); }
 
 void Schema::updateSample(Time t)
 {
-    m_update_flag_prev = m_update_flag;
-    m_update_flag = m_update_flag_next;
-    m_update_flag_next.bits = 0;
+    updateFlagPrev() = updateFlag();
+    updateFlag() = updateFlagNext();
+    updateFlagNext().bits = 0;
 
-    if(m_update_flag.sample_updated == 0) {
-        m_update_flag.sample_updated = 1;
-        if (!std::isnan(m_time_prev)) {
-            if (t == m_time_prev) {
-                m_update_flag.sample_updated = 0;
-            }
-            else if (std::isnan(m_time_start)) {
-                m_update_flag.sample_updated = 0;
-            }
-            else if ((t <= m_time_start && m_time_prev <= m_time_start) || (t >= m_time_end && m_time_prev >= m_time_end)) {
-                m_update_flag.sample_updated = 0;
-            }
+    {
+        lock_t lock(m_attr_mutex);
+        syncTimeRangeIfNeeded();
+        if (updateFlag().sample_updated == 0) {
+            updateFlag().sample_updated = m_states->isSampleUpdated(m_slot, t) ? 1 : 0;
         }
     }
 
-    //if (m_update_flag.variant_set_changed) {
+    //if (updateFlag().variant_set_changed) {
     //    syncAttributes();
     //    syncTimeRange();
     //}
 
-    m_time_prev = t;
+    timePrev() = t;
 }
 
 void Schema::setOverrideImportSettings(bool v)
@@ -462,8 +685,9 @@ void Schema::setOverrideImportSettings(bool v)
     }
     else {
         if (m_isettings_override != v) {
+            if (!m_isettings) { m_isettings.reset(new ImportSettings()); }
             m_isettings_override = v;
-            m_update_flag_next.import_settings_updated = 1;
+            updateFlagNext().import_settings_updated = 1;
         }
     }
 }
@@ -482,7 +706,7 @@ const ImportSettings& Schema::getImportSettings() const
         return m_master->getImportSettings();
     }
     else {
-        return m_isettings_override ? m_isettings : m_ctx->getImportSettings();
+        return m_isettings_override ? *m_isettings : m_ctx->getImportSettings();
     }
 }
 void Schema::setImportSettings(const ImportSettings& v)
@@ -491,11 +715,17 @@ void Schema::setImportSettings(const ImportSettings& v)
         m_master->setImportSettings(v);
     }
     else {
-        if (m_isettings != v) {
-            m_isettings = v;
-            if (m_isettings_override) {
-                m_update_flag_next.import_settings_updated = 1;
-            }
+        if (!m_isettings) {
+            m_isettings.reset(new ImportSettings(v));
+        }
+        else if (*m_isettings != v) {
+            *m_isettings = v;
+        }
+        else {
+            return;
+        }
+        if (m_isettings_override) {
+            updateFlagNext().import_settings_updated = 1;
         }
     }
 }
@@ -506,6 +736,7 @@ void Schema::setOverrideExportSettings(bool v)
         m_master->setOverrideExportSettings(v);
     }
     else {
+        if (v && !m_esettings) { m_esettings.reset(new ExportSettings()); }
         m_esettings_override = v;
     }
 }
@@ -524,7 +755,7 @@ const ExportSettings& Schema::getExportSettings() const
         return m_master->getExportSettings();
     }
     else {
-        return m_esettings_override ? m_esettings : m_ctx->getExportSettings();
+        return m_esettings_override ? *m_esettings : m_ctx->getExportSettings();
     }
 }
 void Schema::setExportSettings(const ExportSettings& v)
@@ -533,7 +764,12 @@ void Schema::setExportSettings(const ExportSettings& v)
         m_master->setExportSettings(v);
     }
     else {
-        m_esettings = v;
+        if (!m_esettings) {
+            m_esettings.reset(new ExportSettings(v));
+        }
+        else {
+            *m_esettings = v;
+        }
     }
 }
 
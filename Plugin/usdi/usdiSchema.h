@@ -11,9 +11,80 @@ namespace usdi {
     static int _getInheritDepth() { return super::_getInheritDepth() + 1; }\
 
 
+class Schema;
+
+// per-frame update states of schemas in structure-of-arrays form. each block of SchemaPool has one for its schemas.
+// Context::updateAllSamples() checks these and skips schemas that have nothing to update without touching them.
+struct SchemaUpdateStates
+{
+    static const int Capacity = 256;
+
+    UpdateFlags flags[Capacity];
+    UpdateFlags flags_prev[Capacity];
+    UpdateFlags flags_next[Capacity];
+    Time        time_start[Capacity];
+    Time        time_end[Capacity];
+    Time        time_prev[Capacity];
+    bool        time_range_synced[Capacity];
+
+    void init(int i);
+    // time range part of Schema::updateSample()
+    bool isSampleUpdated(int i, Time t) const;
+    // true if Schema::updateSample(t) would change nothing but flags_prev and time_prev
+    bool isUpToDate(int i, Time t) const;
+};
+
+// allocates schemas of one concrete type from fixed size blocks so that schemas of the same type and their
+// SchemaUpdateStates are contiguous.
+// schemas never move (Schema* is handed out through the API). slots of destroyed schemas are given back by free()
+// and reused by later allocations. memory is released only by clear(), which must be called after all schemas in the
+// pool are destroyed. allocate() and free() are thread-safe (schema trees are built in parallel).
+class SchemaPool
+{
+public:
+    struct Block
+    {
+        SchemaUpdateStates states;
+        char *objects = nullptr;
+        int num_objects = 0;
+    };
+    struct Slot
+    {
+        Block *block;
+        int index;
+    };
+    using Slots = std::vector<Slot>;
+
+    SchemaPool(const std::type_info& type, size_t object_size);
+    ~SchemaPool();
+    const std::type_info& getType() const;
+    void*   allocate(SchemaUpdateStates *&states, int& slot);
+    // object in the slot must be destructed already
+    void    free(SchemaUpdateStates *states, int slot);
+    void    clear();
+
+    Schema* getObject(const Block& block, int slot) const;
+    // block that owns states (states given by allocate())
+    static Block* getBlockOf(SchemaUpdateStates *states);
+
+private:
+    using BlockPtr = std::unique_ptr<Block>;
+    const std::type_info *m_type;
+    size_t m_stride;
+    std::vector<BlockPtr> m_blocks;
+    Slots m_free_slots;
+    std::mutex m_mutex;
+};
+
+// placement new to memory from Context's schema pools. see NewSchema().
+void* AllocateSchema(Context *ctx, const std::type_info& type, size_t size, SchemaUpdateStates *&states, int& slot);
+
+
 class Schema
 {
 friend class Context;
+friend struct SchemaDeleter;
+template<class T, class... Args> friend T* NewSchema(Context *ctx, Args&&... args);
 public:
     DefSchemaTraits2(UsdSchemaBase, "");
     static int _getInheritDepth() { return 0; }
@@ -41,11 +112,12 @@ public:
     Attribute*      createAttribute(const char *name, AttributeType type, AttributeType internal_type = AttributeType::Unknown);
 
     // parent & child interface
+    // in lazy mode (ImportSettings::lazy_schema_tree), children are created on first access.
 
     Schema*         getParent() const;
-    int             getNumChildren() const;
-    Schema*         getChild(int i) const;
-    Schema*         findChild(const char *path, bool recursive) const;
+    int             getNumChildren();
+    Schema*         getChild(int i);
+    Schema*         findChild(const char *path, bool recursive);
 
     // reference & instance interface
 
@@ -87,6 +159,12 @@ public:
     void            editVariants(const std::function<void ()>& body); // edit current variant
 
 
+    // called when the prim is changed on the stage (see Context::processChanges()).
+    // attributes: true if the prim may be re-composed or attributes may be added or removed.
+    // changed: names of attributes that are added, removed or edited. empty means the whole prim may be changed.
+    // variant_set_changed is reported only if variant selections are actually changed.
+    virtual void    resync(bool attributes, const TfTokenVector& changed);
+
     UpdateFlags     getUpdateFlags() const;
     UpdateFlags     getUpdateFlagsPrev() const;
     virtual void    updateSample(Time t);
@@ -109,6 +187,7 @@ public:
     template<class Body>
     void eachChild(const Body& body)
     {
+        materializeChildren();
         for (auto& c : m_children) { body(c); }
     }
 
@@ -132,7 +211,15 @@ public:
     template<class Body>
     void eachAttribute(const Body& body)
     {
-        for (auto& a : m_attributes) { body(a.get()); }
+        // body may look up attributes. call it outside the lock.
+        std::vector<Attribute*> attrs;
+        {
+            lock_t lock(m_attr_mutex);
+            syncAttributesIfNeeded();
+            attrs.reserve(m_attributes.size());
+            for (auto& a : m_attributes) { attrs.push_back(a.get()); }
+        }
+        for (auto *a : attrs) { body(a); }
     }
 
     template<class T>
@@ -159,6 +246,7 @@ protected:
     {
         std::string name;
         std::vector<std::string> variants;
+        std::string selection; // as of last syncVariantSets()
     };
 
     using Children = std::vector<Schema*>;
@@ -166,15 +254,39 @@ protected:
     using AttributePtr = std::unique_ptr<Attribute>;
     using Attributes = std::vector<AttributePtr>;
     using VariantSets = std::vector<VariantSet>;
+    using lock_t = tbb::spin_mutex::scoped_lock;
 
+    // attributes are wrapped on first access. syncAttributes() wraps all of them (needed to enumerate).
+    // lazy wrapping and time range sync can run on user threads and update tasks at the same time as resync().
+    // m_attr_mutex must be locked while calling these.
     void syncAttributes();
     void syncTimeRange();
-    void syncVariantSets();
-
+    void syncAttributesIfNeeded() const;
+    void syncTimeRangeIfNeeded() const;
+    Attribute* findOrWrapAttribute(const TfToken& name) const;
+    // returns true if variant sets or selections are changed since last call
+    bool syncVariantSets();
+    void materializeChildren();
+
+    // update states live in the SchemaPool block the schema is allocated from
+    void bindUpdateStates(SchemaUpdateStates *states, int slot);
+    bool hasOwnTimeRange() const { return m_prim && !m_master; }
+    UpdateFlags&    updateFlag() const      { return m_states->flags[m_slot]; }
+    UpdateFlags&    updateFlagPrev() const  { return m_states->flags_prev[m_slot]; }
+    UpdateFlags&    updateFlagNext() const  { return m_states->flags_next[m_slot]; }
+    Time&           timeStart() const       { return m_states->time_start[m_slot]; }
+    Time&           timeEnd() const         { return m_states->time_end[m_slot]; }
+    Time&           timePrev() const        { return m_states->time_prev[m_slot]; }
+    bool&           timeRangeSynced() const { return m_states->time_range_synced[m_slot]; }
+
+    // members are ordered to minimize padding. there can be millions of schemas.
     Context         *m_ctx = nullptr;
     Schema          *m_parent = nullptr;
     Schema          *m_master = nullptr;
+    SchemaUpdateStates *m_states = nullptr;
+    int             m_slot = 0;
     int             m_id = 0;
+    int             m_baked_entry = -1; // index of entry in Context's baked cache. -1 if not baked
 
     std::string     m_path;
     UsdPrim         m_prim;
@@ -184,21 +296,38 @@ protected:
 
     VariantSets     m_variant_sets;
 
-    Time            m_time_start = usdiInvalidTime;
-    Time            m_time_end = usdiInvalidTime;
-    Time            m_time_prev = usdiInvalidTime;
-    UpdateFlags     m_update_flag;
-    UpdateFlags     m_update_flag_prev;
-    UpdateFlags     m_update_flag_next;
-
+    bool            m_instance_proxy = false; // schema in instance. created from master's prim
+    bool            m_attributes_synced = false; // true if all authored attributes are wrapped
+    std::atomic_bool m_children_materialized = { true };
     bool            m_isettings_override = false;
-    ImportSettings  m_isettings;
     bool            m_esettings_override = false;
-    ExportSettings  m_esettings;
+    mutable tbb::spin_mutex m_attr_mutex; // guards m_attributes, m_attributes_synced and time range
+
+    // per-schema settings are rare. allocated on first set.
+    std::unique_ptr<ImportSettings> m_isettings;
+    std::unique_ptr<ExportSettings> m_esettings;
 
     void            *m_userdata = nullptr;
 };
 
+// all schemas must be created by this. T's constructor must not touch update states (they are bound after it).
+template<class T, class... Args>
+inline T* NewSchema(Context *ctx, Args&&... args)
+{
+    SchemaUpdateStates *states;
+    int slot;
+    void *mem = AllocateSchema(ctx, typeid(T), sizeof(T), states, slot);
+    T *ret = new (mem) T(ctx, std::forward<Args>(args)...);
+    ret->bindUpdateStates(states, slot);
+    return ret;
+}
+
+// schemas are in SchemaPool. destruct and give the slot back to the pool.
+struct SchemaDeleter
+{
+    void operator()(Schema *s) const;
+};
+
 
 class ISchemaHandler
 {
@@ -218,7 +347,7 @@ public:
     int         getInheritDepth() override { return SchemaType::_getInheritDepth(); }
     const char* getUsdTypeName() override { return SchemaType::_getUsdTypeName(); }
     bool        isCompatible(const UsdPrim& p) override { typename SchemaType::UsdType t(p); return t; }
-    Schema*     create(Context *ctx, Schema *parent, const UsdPrim& p) override { return new SchemaType(ctx, parent, p); }
+    Schema*     create(Context *ctx, Schema *parent, const UsdPrim& p) override { return NewSchema<SchemaType>(ctx, parent, p); }
 };
 
 Schema* CreateSchema(Context *ctx, Schema *parent, const UsdPrim& p);
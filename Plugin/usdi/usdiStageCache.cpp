@@ -0,0 +1,58 @@
+#include "pch.h"
+#include "usdiInternal.h"
+#include "usdiStageCache.h"
+
+namespace usdi {
+
+StageCache& StageCache::getInstance()
+{
+    static StageCache s_instance;
+    return s_instance;
+}
+
+UsdStageRefPtr StageCache::acquire(const std::string& key, const Opener& opener)
+{
+    std::shared_ptr<std::promise<UsdStageRefPtr>> promise;
+    std::shared_future<UsdStageRefPtr> future;
+    {
+        lock_t lock(m_mutex);
+        auto& rec = m_records[key];
+        if (rec.ref_count++ == 0) {
+            promise = std::make_shared<std::promise<UsdStageRefPtr>>();
+            rec.stage = promise->get_future().share();
+        }
+        future = rec.stage;
+    }
+
+    if (!promise) {
+        return future.get();
+    }
+
+    // open outside the lock. stages of other keys can be opened concurrently.
+    auto stage = opener();
+    promise->set_value(stage);
+    if (!stage) {
+        lock_t lock(m_mutex);
+        m_records.erase(key);
+    }
+    return stage;
+}
+
+void StageCache::release(const std::string& key)
+{
+    UsdStageRefPtr stage;
+    {
+        lock_t lock(m_mutex);
+        auto it = m_records.find(key);
+        if (it == m_records.end()) { return; }
+        if (--it->second.ref_count > 0) { return; }
+        stage = it->second.stage.get();
+        m_records.erase(it);
+    }
+    // destroy the stage outside the lock
+    if (stage) {
+        stage->Close();
+    }
+}
+
+} // namespace usdi
@@ -0,0 +1,33 @@
+#pragma once
+
+namespace usdi {
+
+// process-wide cache of composed stages. reference counted.
+// contexts that open the same file with the same settings can share one stage (OpenSettings::share_stage).
+class StageCache
+{
+public:
+    using Opener = std::function<UsdStageRefPtr()>;
+
+    static StageCache& getInstance();
+
+    // return cached stage if exists. otherwise open it by opener and cache it.
+    // concurrent acquire() of the same key waits for the first one to open the stage.
+    // release() must be called for each successful acquire(). failed acquire() returns null and needs no release().
+    UsdStageRefPtr  acquire(const std::string& key, const Opener& opener);
+    void            release(const std::string& key);
+
+private:
+    struct Record
+    {
+        std::shared_future<UsdStageRefPtr> stage;
+        int ref_count = 0;
+    };
+    using Records = std::map<std::string, Record>;
+    using lock_t = std::unique_lock<std::mutex>;
+
+    std::mutex  m_mutex;
+    Records     m_records;
+};
+
+} // namespace usdi
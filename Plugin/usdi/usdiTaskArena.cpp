@@ -0,0 +1,150 @@
+#include "pch.h"
+#include "usdiInternal.h"
+#include "usdiTaskArena.h"
+#include "usdiUtils.h"
+#ifdef _WIN32
+    #include <windows.h>
+#elif defined(__linux__)
+    #include <pthread.h>
+    #include <sched.h>
+#endif
+
+namespace usdi {
+
+// affinity is a hint. only supported on Windows and Linux.
+static bool SetCurrentThreadAffinity(uint64_t mask, uint64_t *prev)
+{
+#ifdef _WIN32
+    DWORD_PTR ret = ::SetThreadAffinityMask(::GetCurrentThread(), (DWORD_PTR)mask);
+    if (ret == 0) { return false; }
+    if (prev) { *prev = (uint64_t)ret; }
+    return true;
+#elif defined(__linux__)
+    auto th = pthread_self();
+    if (prev) {
+        cpu_set_t cur;
+        CPU_ZERO(&cur);
+        if (pthread_getaffinity_np(th, sizeof(cur), &cur) != 0) { return false; }
+        *prev = 0;
+        for (int i = 0; i < 64; ++i) {
+            if (CPU_ISSET(i, &cur)) { *prev |= (uint64_t)1 << i; }
+        }
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int i = 0; i < 64; ++i) {
+        if (mask & ((uint64_t)1 << i)) { CPU_SET(i, &set); }
+    }
+    return pthread_setaffinity_np(th, sizeof(set), &set) == 0;
+#else
+    (void)mask; (void)prev;
+    return false;
+#endif
+}
+
+// restrict worker threads to cores in affinity_mask while they are in the arena.
+// workers are shared with the global scheduler. affinity is restored when they leave the arena.
+class TaskArena::AffinityObserver : public tbb::task_scheduler_observer
+{
+public:
+    AffinityObserver(tbb::task_arena& arena, uint64_t mask)
+        : tbb::task_scheduler_observer(arena)
+        , m_mask(mask)
+    {
+        observe(true);
+    }
+
+    ~AffinityObserver()
+    {
+        observe(false);
+    }
+
+    void on_scheduler_entry(bool worker) override
+    {
+        if (!worker) { return; }
+        auto& prev = getPrevMask();
+        if (!SetCurrentThreadAffinity(m_mask, &prev)) {
+            prev = 0;
+        }
+    }
+
+    void on_scheduler_exit(bool worker) override
+    {
+        if (!worker) { return; }
+        auto& prev = getPrevMask();
+        if (prev != 0) {
+            SetCurrentThreadAffinity(prev, nullptr);
+            prev = 0;
+        }
+    }
+
+private:
+    static uint64_t& getPrevMask()
+    {
+        static thread_local uint64_t s_prev;
+        return s_prev;
+    }
+
+    uint64_t m_mask;
+};
+
+
+TaskArena::TaskArena()
+{
+}
+
+TaskArena::~TaskArena()
+{
+    m_observer.reset();
+    m_arena.reset();
+}
+
+void TaskArena::setSettings(const ConcurrencySettings& v)
+{
+    m_observer.reset();
+    m_arena.reset();
+    m_settings = v;
+
+    if (m_settings.max_threads > 0) {
+        // one slot is reserved for the thread that calls execute()
+        m_arena.reset(new tbb::task_arena(m_settings.max_threads, 1));
+        m_arena->initialize();
+        if (m_settings.affinity_mask != 0) {
+            m_observer.reset(new AffinityObserver(*m_arena, m_settings.affinity_mask));
+        }
+        usdiLogInfo("TaskArena::setSettings(): max_threads=%d\n", m_settings.max_threads);
+    }
+}
+
+const ConcurrencySettings& TaskArena::getSettings() const
+{
+    return m_settings;
+}
+
+void TaskArena::enqueue(const std::function<void()>& body)
+{
+#if __TBB_TASK_PRIORITY
+    tbb::priority_t priority = tbb::priority_normal;
+    switch (m_settings.priority) {
+    case TaskPriority::Low: priority = tbb::priority_low; break;
+    case TaskPriority::High: priority = tbb::priority_high; break;
+    default: break;
+    }
+    if (m_arena) {
+        m_arena->enqueue(body, priority);
+    }
+    else {
+        auto *t = new(tbb::task::allocate_root()) lambda_task<std::function<void()>>(body);
+        tbb::task::enqueue(*t, priority);
+    }
+#else
+    if (m_arena) {
+        m_arena->enqueue(body);
+    }
+    else {
+        launch(body);
+    }
+#endif
+}
+
+} // namespace usdi
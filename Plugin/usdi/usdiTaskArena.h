@@ -0,0 +1,38 @@
+#pragma once
+
+namespace usdi {
+
+// isolated TBB task arena of a Context.
+// parallel work of the context (tree build, updateAllSamples(), precomputeNormals(), payload streaming, ...)
+// runs in this arena so that it doesn't compete with the host application and other contexts.
+// if ConcurrencySettings::max_threads is 0, the global scheduler is used as before.
+class TaskArena
+{
+public:
+    TaskArena();
+    ~TaskArena();
+
+    // must not be called while tasks of the arena are running.
+    void setSettings(const ConcurrencySettings& v);
+    const ConcurrencySettings& getSettings() const;
+
+    // run body in the arena and wait. parallel algorithms called in body are confined to the arena.
+    template<class Body>
+    void execute(const Body& body)
+    {
+        if (m_arena) { m_arena->execute(body); }
+        else { body(); }
+    }
+
+    // run body asynchronously with the priority of the settings.
+    void enqueue(const std::function<void()>& body);
+
+private:
+    class AffinityObserver;
+
+    ConcurrencySettings m_settings;
+    std::unique_ptr<tbb::task_arena> m_arena;
+    std::unique_ptr<AffinityObserver> m_observer;
+};
+
+} // namespace usdi
@@ -3,6 +3,7 @@
 #include "usdiSchema.h"
 #include "usdiXform.h"
 #include "usdiContext.h"
+#include "usdiBakedCache.h"
 #include "usdiContext.i"
 #include "usdiAttribute.h"
 
@@ -102,6 +103,16 @@ Xform::~Xform()
     usdiLogTrace("Xform::~Xform(): %s\n", getPath());
 }
 
+void Xform::resync(bool attributes, const TfTokenVector& changed)
+{
+    super::resync(attributes, changed);
+    m_summary_needs_update = true;
+    if (attributes) {
+        m_xf = UsdGeomXformable(m_prim);
+        interpretXformOps();
+    }
+}
+
 void Xform::interpretXformOps()
 {
     bool reset_stack = false;
@@ -165,11 +176,11 @@ const XformSummary& Xform::getSummary() const
 void Xform::updateSample(Time t_)
 {
     super::updateSample(t_);
-    if (m_update_flag.bits == 0) {
+    if (updateFlag().bits == 0) {
         m_sample.flags = (m_sample.flags & ~(int)XformData::Flags::UpdatedMask);
         return;
     }
-    if (m_update_flag.variant_set_changed) { m_summary_needs_update = true; }
+    if (updateFlag().variant_set_changed) { m_summary_needs_update = true; }
 
     auto t = UsdTimeCode(t_);
     const auto& conf = getImportSettings();
@@ -283,7 +294,17 @@ void Xform::updateSample(Time t_)
 
 bool Xform::readSample(XformData& dst, Time t)
 {
-    if (t != m_time_prev) { updateSample(t); }
+    if (m_baked_entry >= 0) {
+        bool ret = m_ctx->getBakedCache()->readXform(m_baked_entry, dst, t);
+        // update flags are not baked
+        if (t != m_baked_time_prev) {
+            dst.flags |= (int)XformData::Flags::UpdatedMask;
+        }
+        m_baked_time_prev = t;
+        return ret;
+    }
+
+    if (t != timePrev()) { updateSample(t); }
 
     dst = m_sample;
     return true;
@@ -292,6 +313,7 @@ bool Xform::readSample(XformData& dst, Time t)
 
 bool Xform::writeSample(const XformData& src_, Time t_)
 {
+    if (!m_ctx->checkStageEditable("Xform::writeSample()")) { return false; }
     auto t = UsdTimeCode(t_);
     const auto& conf = getExportSettings();
     XformData src = src_;
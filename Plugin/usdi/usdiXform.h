@@ -13,6 +13,7 @@ public:
     ~Xform() override;
 
     void                updateSample(Time t) override;
+    void                resync(bool attributes, const TfTokenVector& changed) override;
 
     const XformSummary& getSummary() const;
     bool                readSample(XformData& dst, Time t);
@@ -31,6 +32,7 @@ private:
     UsdGeomXformOps     m_write_ops;
 
     XformData            m_sample;
+    Time                 m_baked_time_prev = usdiInvalidTime;
     mutable bool         m_summary_needs_update = true;
     mutable XformSummary m_summary;
 };
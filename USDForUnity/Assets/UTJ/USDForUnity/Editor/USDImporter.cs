@@ -42,6 +42,7 @@ namespace UTJ.USD
                 interpolation = m_importSettings.interpolation,
                 normalCalculation = m_importSettings.normalCalculation,
                 tangentCalculation = m_importSettings.tangentCalculation,
+                fastTangents = m_importSettings.fastTangents,
                 maxBoneWeights = m_importSettings.maxBoneWeights,
                 scale = m_importSettings.scale,
                 loadAllPayloads = true,
@@ -20,6 +20,7 @@ namespace UTJ.USD
             AddEnumProperty(serializedObject.FindProperty(()=> importer.m_importSettings.interpolation ), "Interpolation", "", importer.m_importSettings.interpolation.GetType() );
             AddEnumProperty(serializedObject.FindProperty(() => importer.m_importSettings.normalCalculation), "Compute normals", "", importer.m_importSettings.normalCalculation.GetType());
             AddEnumProperty(serializedObject.FindProperty(() => importer.m_importSettings.tangentCalculation), "Compute tangents", "", importer.m_importSettings.tangentCalculation.GetType());
+            AddByteBoolProperty(serializedObject.FindProperty(() => importer.m_importSettings.fastTangents.v), "Fast tangents", "Per-vertex tangents from UV gradients. Much faster than MikkTSpace but not identical to it.");
             AddFloatProperty(serializedObject.FindProperty(() => importer.m_importSettings.scale), "Scale", "" );
             AddByteBoolProperty(serializedObject.FindProperty(() => importer.m_importSettings.swapHandedness.v), "Swap handedness", "");
             AddByteBoolProperty(serializedObject.FindProperty(() => importer.m_importSettings.swapFaces.v), "Swap faces", "");
@@ -37,6 +37,7 @@ namespace UTJ.USD
 					AddEnumProperty(serializedObject.FindProperty(() => stream.m_importSettings.interpolation), "Interpolation", "", stream.m_importSettings.interpolation.GetType());
 					AddEnumProperty(serializedObject.FindProperty(() => stream.m_importSettings.normalCalculation), "Compute normals", "", stream.m_importSettings.normalCalculation.GetType());
 					AddEnumProperty(serializedObject.FindProperty(() => stream.m_importSettings.tangentCalculation), "Compute tangents", "", stream.m_importSettings.tangentCalculation.GetType());
+					AddByteBoolProperty(serializedObject.FindProperty(() => stream.m_importSettings.fastTangents.v), "Fast tangents", "Per-vertex tangents from UV gradients. Much faster than MikkTSpace but not identical to it.");
 					AddSimpleProperty(serializedObject.FindProperty(() => stream.m_importSettings.scale), "Scale", "");
 					AddByteBoolProperty(serializedObject.FindProperty(() => stream.m_importSettings.swapHandedness.v), "Swap handedness", "");
 					AddByteBoolProperty(serializedObject.FindProperty(() => stream.m_importSettings.swapFaces.v), "Swap faces", "");
@@ -345,7 +345,7 @@ namespace UTJ.USD
                 data.weights = usdi.GetArrayPtr(m_weights);
             }
             {
-                m_indices = new int[data.num_points];
+                m_indices = new int[data.num_indices];
                 data.indices = usdi.GetArrayPtr(m_indices);
             }
             submeshData[m_nth] = data;
@@ -14,6 +14,12 @@ namespace UTJ.USD
             public static implicit operator bool(Context v) { return v.ptr != IntPtr.Zero; }
         }
 
+        public struct OpenTask
+        {
+            public IntPtr ptr;
+            public static implicit operator bool(OpenTask v) { return v.ptr != IntPtr.Zero; }
+        }
+
         public struct Attribute
         {
             public IntPtr ptr;
@@ -148,6 +154,11 @@ namespace UTJ.USD
             public Bool swapFaces;
             [HideInInspector] public Bool splitMesh;
             [HideInInspector] public Bool doubleBuffering;
+            [HideInInspector] public Bool lazySchemaTree;
+            [HideInInspector] public int variantCacheKB;
+            public Bool fastTangents;
+            [HideInInspector] public int lodCount;
+            [HideInInspector] public float lodRatio;
 
             public static ImportSettings default_value
             {
@@ -166,6 +177,11 @@ namespace UTJ.USD
                         swapFaces = false,
                         splitMesh = true,
                         doubleBuffering = true,
+                        lazySchemaTree = false,
+                        variantCacheKB = 0,
+                        fastTangents = false,
+                        lodCount = 0,
+                        lodRatio = 0.5f,
                     };
                 }
             }
@@ -194,6 +210,96 @@ namespace UTJ.USD
             }
         };
 
+        public enum TaskPriority
+        {
+            Low,
+            Normal,
+            High,
+        };
+
+        public struct ConcurrencySettings
+        {
+            public int maxThreads; // 0: no limit
+            public TaskPriority priority;
+            public ulong affinityMask; // hint. 0: no restriction
+
+            public static ConcurrencySettings default_value
+            {
+                get
+                {
+                    return new ConcurrencySettings
+                    {
+                        maxThreads = 0,
+                        priority = TaskPriority.Normal,
+                        affinityMask = 0,
+                    };
+                }
+            }
+        };
+
+
+        public enum PayloadLoadPolicy
+        {
+            Default, // follow ImportSettings.loadAllPayloads
+            LoadAll,
+            LoadNone,
+        };
+
+        [Flags]
+        public enum SchemaTypeFilter
+        {
+            All     = 0,
+            Xform   = 0x1,
+            Camera  = 0x2,
+            Mesh    = 0x4,
+            Points  = 0x8,
+            Other   = 0x10,
+        };
+
+        public struct OpenSettings
+        {
+            public IntPtr primPaths; // pointer to array of char*
+            public int numPrimPaths;
+            public SchemaTypeFilter typeFilter;
+            public PayloadLoadPolicy payloadPolicy;
+            public Bool shareStage;
+
+            public static OpenSettings default_value
+            {
+                get
+                {
+                    return new OpenSettings
+                    {
+                        primPaths = IntPtr.Zero,
+                        numPrimPaths = 0,
+                        typeFilter = SchemaTypeFilter.All,
+                        payloadPolicy = PayloadLoadPolicy.Default,
+                        shareStage = false,
+                    };
+                }
+            }
+        };
+
+        public enum OpenPhase
+        {
+            Pending,
+            LoadingLayers,
+            Composing,
+            BuildingSchemas,
+            Completed,
+            Failed,
+            Canceled,
+        };
+
+        public struct OpenProgress
+        {
+            public OpenPhase phase;
+            public float phaseProgress;
+            public int numLayers;
+            public int numSchemas;
+            public int numCompletedSubtrees;
+        };
+
 
         public struct XformSummary
         {
@@ -305,7 +411,8 @@ namespace UTJ.USD
             public IntPtr   velocities;
             public IntPtr   indices; // always triangulated
             public IntPtr   weights;
-            public int      num_points; // == num_indices
+            public int      num_points;
+            public int      num_indices;
 
             public Vector3  center;
             public Vector3  extents;
@@ -342,6 +449,8 @@ namespace UTJ.USD
 
             public IntPtr   submeshes; // pointer to array of SubmeshData
             public int      num_submeshes;
+            public IntPtr   lods; // pointer to array of SubmeshData
+            public int      num_lods;
 
             public static MeshData default_value
             {
@@ -423,7 +532,16 @@ namespace UTJ.USD
         // Context interface
         [DllImport ("usdi")] public static extern Context       usdiCreateContext();
         [DllImport ("usdi")] public static extern void          usdiDestroyContext(Context ctx);
+        [DllImport ("usdi")] public static extern void          usdiContextAddAssetSearchPath(Context ctx, string path);
+        [DllImport ("usdi")] public static extern void          usdiContextClearAssetSearchPath(Context ctx);
         [DllImport ("usdi")] public static extern Bool          usdiOpen(Context ctx, string path);
+        [DllImport ("usdi")] public static extern Bool          usdiOpenWithSettings(Context ctx, string path, ref OpenSettings settings);
+        [DllImport ("usdi")] public static extern OpenTask      usdiOpenAsync(Context ctx, string path, ref OpenSettings settings);
+        [DllImport ("usdi")] public static extern void          usdiOpenTaskGetProgress(OpenTask task, ref OpenProgress dst);
+        [DllImport ("usdi")] public static extern Schema        usdiOpenTaskGetCompletedSubtree(OpenTask task, int i);
+        [DllImport ("usdi")] public static extern void          usdiOpenTaskCancel(OpenTask task);
+        [DllImport ("usdi")] public static extern Bool          usdiOpenTaskWait(OpenTask task);
+        [DllImport ("usdi")] public static extern void          usdiOpenTaskRelease(OpenTask task);
         [DllImport ("usdi")] public static extern Bool          usdiCreateStage(Context ctx, string path);
         [DllImport ("usdi")] public static extern Bool          usdiSave(Context ctx);
         [DllImport ("usdi")] public static extern Bool          usdiSaveAs(Context ctx, string path);
@@ -432,6 +550,8 @@ namespace UTJ.USD
         [DllImport ("usdi")] public static extern void          usdiGetImportSettings(Context ctx, ref ImportSettings v);
         [DllImport ("usdi")] public static extern void          usdiSetExportSettings(Context ctx, ref ExportSettings v);
         [DllImport ("usdi")] public static extern void          usdiGetExportSettings(Context ctx, ref ExportSettings v);
+        [DllImport ("usdi")] public static extern void          usdiSetConcurrencySettings(Context ctx, ref ConcurrencySettings v);
+        [DllImport ("usdi")] public static extern void          usdiGetConcurrencySettings(Context ctx, ref ConcurrencySettings v);
 
         [DllImport ("usdi")] public static extern Schema        usdiCreateOverride(Context ctx, string prim_path);
         [DllImport ("usdi")] public static extern Xform         usdiCreateXform(Context ctx, Schema parent, string name);
@@ -449,6 +569,15 @@ namespace UTJ.USD
         [DllImport ("usdi")] public static extern void          usdiNotifyForceUpdate(Context ctx);
         [DllImport ("usdi")] public static extern void          usdiUpdateAllSamples(Context ctx, double t);
         [DllImport ("usdi")] public static extern void          usdiRebuildSchemaTree(Context ctx);
+        [DllImport ("usdi")] public static extern void          usdiSetPayloadCameraPosition(Context ctx, ref Vector3 pos);
+        [DllImport ("usdi")] public static extern void          usdiSetPayloadMemoryBudget(Context ctx, ulong size);
+        [DllImport ("usdi")] public static extern void          usdiLoadAllPayloadsAsync(Context ctx);
+        [DllImport ("usdi")] public static extern int           usdiGetNumPendingPayloads(Context ctx);
+        [DllImport ("usdi")] public static extern Bool          usdiBake(Context ctx, string path, double[] times, int num_times);
+        [DllImport ("usdi")] public static extern Bool          usdiOpenBakedCache(Context ctx, string path);
+        [DllImport ("usdi")] public static extern void          usdiCloseBakedCache(Context ctx);
+        [DllImport ("usdi")] public static extern void          usdiPrimLoadPayloadAsync(Schema schema);
+        [DllImport ("usdi")] public static extern void          usdiPrimUnloadPayloadAsync(Schema schema);
         public delegate void usdiPreComputeNormalsCallback(Mesh mesh, Bool done);
         [DllImport ("usdi")] public static extern void          usdiPreComputeNormalsAll(Context ctx, Bool gen_tangents, Bool overwrite, usdiPreComputeNormalsCallback cb = null);
 
@@ -561,6 +690,8 @@ namespace UTJ.USD
         [DllImport ("usdi")] public static extern Mesh      usdiAsMesh(Schema schema);
         [DllImport ("usdi")] public static extern void      usdiMeshGetSummary(Mesh mesh, ref MeshSummary dst);
         [DllImport ("usdi")] public static extern Bool      usdiMeshReadSample(Mesh mesh, ref MeshData dst, double t, Bool copy);
+        [DllImport ("usdi")] public static extern int       usdiMeshAcquireSample(Mesh mesh, ref MeshData dst, double t);
+        [DllImport ("usdi")] public static extern void      usdiMeshReleaseSample(Mesh mesh, int handle);
         [DllImport ("usdi")] public static extern Bool      usdiMeshWriteSample(Mesh mesh, ref MeshData src, double t);
         public delegate void usdiMeshSampleCallback(ref MeshData data, double t);
         [DllImport ("usdi")] public static extern int       usdiMeshEachSample(Mesh mesh, usdiMeshSampleCallback cb);
@@ -570,6 +701,8 @@ namespace UTJ.USD
         [DllImport ("usdi")] public static extern Points    usdiAsPoints(Schema schema);
         [DllImport ("usdi")] public static extern void      usdiPointsGetSummary(Points points, ref PointsSummary dst);
         [DllImport ("usdi")] public static extern Bool      usdiPointsReadSample(Points points, ref PointsData dst, double t, Bool copy);
+        [DllImport ("usdi")] public static extern int       usdiPointsAcquireSample(Points points, ref PointsData dst, double t);
+        [DllImport ("usdi")] public static extern void      usdiPointsReleaseSample(Points points, int handle);
         [DllImport ("usdi")] public static extern Bool      usdiPointsWriteSample(Points points, ref PointsData src, double t);
         public delegate void usdiPointsSampleCallback(ref PointsData data, double t);
         [DllImport ("usdi")] public static extern int       usdiPointsEachSample(Points points, usdiPointsSampleCallback cb);
@@ -584,6 +717,9 @@ namespace UTJ.USD
         [DllImport ("usdi")] public static extern IntPtr    usdiIndexStringArray(IntPtr v, int i);
         [DllImport ("usdi")] public static extern void          usdiMeshAssignRootBone(Mesh mesh, ref MeshData dst, string v);
         [DllImport ("usdi")] public static extern void          usdiMeshAssignBones(Mesh mesh, ref MeshData dst, string[] v, int n);
+        [DllImport ("usdi")] public static extern void          usdiTransformPoints(Vector3[] dst, Vector3[] src, int num, ref Matrix4x4 m);
+        [DllImport ("usdi")] public static extern void          usdiTransformVectors(Vector3[] dst, Vector3[] src, int num, ref Matrix4x4 m);
+        [DllImport ("usdi")] public static extern void          usdiTransformNormals(Vector3[] dst, Vector3[] src, int num, ref Matrix4x4 m);
 
 
         public class AssetRef